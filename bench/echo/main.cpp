@@ -0,0 +1,405 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+#	include <arpa/inet.h>
+#	include <fcntl.h>
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <sys/epoll.h>
+#	include <sys/eventfd.h>
+#	include <sys/resource.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+
+#	include "../../src/opros/tcp_socket.hpp"
+#	include "../../src/opros/wait_set.hpp"
+
+namespace{
+constexpr size_t message_size = 64;
+
+// Linux gives out about 28k ephemeral ports per source address,
+// so the load generator spreads connections over several loopback addresses
+constexpr size_t connections_per_source_address = 20000;
+
+constexpr auto warmup_time = std::chrono::milliseconds(200);
+
+using std::chrono::steady_clock;
+
+void check(bool ok, const char* what){
+	if(!ok){
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+}
+
+// echo server on top of opros::wait_set
+class opros_server{
+	opros::tcp_acceptor acceptor;
+	opros::wait_set ws;
+	std::vector<std::unique_ptr<opros::tcp_socket>> connections;
+	std::atomic<bool> quit{false};
+
+public:
+	opros_server(size_t num_connections) :
+			acceptor(opros::endpoint("127.0.0.1", 0), 4096),
+			ws(unsigned(num_connections + 1))
+	{
+		// connections are dropped along with the wait set when the server is destroyed
+		this->ws.set_destroy_with_contents(true);
+	}
+
+	uint16_t get_port()const{
+		return this->acceptor.get_local_endpoint().get_port();
+	}
+
+	void stop(){
+		this->quit.store(true);
+		this->ws.interrupt();
+	}
+
+	void run(){
+		this->ws.add(this->acceptor, {opros::ready::read}, nullptr);
+
+		std::array<uint8_t, message_size> buffer;
+		std::array<utki::span<uint8_t>, 1> in = {{utki::make_span(buffer)}};
+
+		while(!this->quit.load()){
+			this->ws.wait();
+
+			for(const auto& e : this->ws.get_triggered()){
+				if(!e.user_data){
+					while(auto s = this->acceptor.accept()){
+						s->set_nodelay(true);
+						this->ws.add(*s, {opros::ready::read}, s.get());
+						this->connections.push_back(std::move(s));
+					}
+					continue;
+				}
+
+				auto& s = *static_cast<opros::tcp_socket*>(e.user_data);
+				try{
+					auto res = s.receive(in);
+					if(!res.has_value()){
+						continue;
+					}
+					if(res.value() == 0){
+						this->ws.remove(s);
+						continue;
+					}
+
+					// there is only one request in flight per connection, so the reply always fits the send buffer
+					std::array<utki::span<const uint8_t>, 1> out = {{utki::make_span(buffer.data(), res.value())}};
+					s.send(out);
+				}catch(std::system_error&){
+					// connection reset by the load generator at the end of the run
+					this->ws.remove(s);
+				}
+			}
+		}
+	}
+};
+
+// the same echo server on top of raw epoll, as a baseline
+class epoll_server{
+	int listener;
+	int epoll_fd;
+	int interrupt_fd;
+	std::vector<epoll_event> events;
+	std::vector<int> connections;
+	std::atomic<bool> quit{false};
+
+public:
+	epoll_server(size_t num_connections) :
+			events(num_connections + 2)
+	{
+		this->listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		check(this->listener >= 0, "socket() failed");
+
+		sockaddr_in a{};
+		a.sin_family = AF_INET;
+		a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		check(bind(this->listener, reinterpret_cast<sockaddr*>(&a), sizeof(a)) == 0, "bind() failed");
+		check(listen(this->listener, 4096) == 0, "listen() failed");
+
+		this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		check(this->epoll_fd >= 0, "epoll_create1() failed");
+
+		this->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		check(this->interrupt_fd >= 0, "eventfd() failed");
+
+		for(int fd : {this->listener, this->interrupt_fd}){
+			epoll_event e{};
+			e.events = EPOLLIN;
+			e.data.fd = fd;
+			check(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &e) == 0, "epoll_ctl() failed");
+		}
+	}
+
+	~epoll_server(){
+		for(int fd : this->connections){
+			close(fd);
+		}
+		close(this->interrupt_fd);
+		close(this->epoll_fd);
+		close(this->listener);
+	}
+
+	uint16_t get_port()const{
+		sockaddr_in a{};
+		socklen_t size = sizeof(a);
+		check(getsockname(this->listener, reinterpret_cast<sockaddr*>(&a), &size) == 0, "getsockname() failed");
+		return ntohs(a.sin_port);
+	}
+
+	void stop(){
+		this->quit.store(true);
+		uint64_t one = 1;
+		check(write(this->interrupt_fd, &one, sizeof(one)) == sizeof(one), "write() failed");
+	}
+
+	void run(){
+		std::array<uint8_t, message_size> buffer;
+
+		while(!this->quit.load()){
+			int num_events = epoll_wait(this->epoll_fd, this->events.data(), int(this->events.size()), -1);
+			if(num_events < 0){
+				check(errno == EINTR, "epoll_wait() failed");
+				continue;
+			}
+
+			for(int i = 0; i != num_events; ++i){
+				int fd = this->events[i].data.fd;
+
+				if(fd == this->interrupt_fd){
+					continue;
+				}
+
+				if(fd == this->listener){
+					for(int s; (s = accept4(this->listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;){
+						int one = 1;
+						setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+						epoll_event e{};
+						e.events = EPOLLIN;
+						e.data.fd = s;
+						check(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, s, &e) == 0, "epoll_ctl() failed");
+						this->connections.push_back(s);
+					}
+					continue;
+				}
+
+				ssize_t res = read(fd, buffer.data(), buffer.size());
+				if(res < 0 && errno == EAGAIN){
+					continue;
+				}
+				if(res <= 0){
+					epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+					continue;
+				}
+
+				// there is only one request in flight per connection, so the reply always fits the send buffer
+				send(fd, buffer.data(), size_t(res), MSG_NOSIGNAL);
+			}
+		}
+	}
+};
+
+struct result{
+	double requests_per_second;
+	double p50;
+	double p99;
+	double p999;
+};
+
+// closed loop load generator, each connection sends next request as soon as it gets the reply
+result generate_load(uint16_t port, size_t num_connections, std::chrono::milliseconds duration){
+	struct connection{
+		int fd;
+		size_t num_received = 0;
+		steady_clock::time_point sent_at;
+	};
+
+	std::vector<connection> connections;
+	connections.reserve(num_connections);
+
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	check(epoll_fd >= 0, "epoll_create1() failed");
+
+	std::array<uint8_t, message_size> request{};
+
+	auto send_request = [&](connection& c){
+		c.num_received = 0;
+		c.sent_at = steady_clock::now();
+		check(send(c.fd, request.data(), request.size(), MSG_NOSIGNAL) == ssize_t(request.size()), "send() failed");
+	};
+
+	for(size_t i = 0; i != num_connections; ++i){
+		int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		check(fd >= 0, "socket() failed");
+		connections.push_back(connection{fd, 0, {}});
+
+		int one = 1;
+		setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		sockaddr_in local{};
+		local.sin_family = AF_INET;
+		local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + uint32_t(i / connections_per_source_address));
+		check(bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0, "bind() failed");
+
+		sockaddr_in remote{};
+		remote.sin_family = AF_INET;
+		remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		remote.sin_port = htons(port);
+		check(connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) == 0, "connect() failed");
+
+		check(fcntl(fd, F_SETFL, O_NONBLOCK) == 0, "fcntl() failed");
+
+		epoll_event e{};
+		e.events = EPOLLIN;
+		e.data.u64 = i;
+		check(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &e) == 0, "epoll_ctl() failed");
+	}
+
+	std::vector<uint32_t> latencies;
+	size_t num_completed = 0;
+
+	for(auto& c : connections){
+		send_request(c);
+	}
+
+	std::vector<epoll_event> events(1024);
+	std::array<uint8_t, message_size> buffer;
+
+	auto start = steady_clock::now() + warmup_time;
+	auto end = start + duration;
+
+	for(auto now = steady_clock::now(); now < end; now = steady_clock::now()){
+		int num_events = epoll_wait(epoll_fd, events.data(), int(events.size()), 100);
+		if(num_events < 0){
+			check(errno == EINTR, "epoll_wait() failed");
+			continue;
+		}
+
+		for(int i = 0; i != num_events; ++i){
+			auto& c = connections[events[i].data.u64];
+
+			ssize_t res = read(c.fd, buffer.data(), message_size - c.num_received);
+			if(res <= 0){
+				check(res < 0 && errno == EAGAIN, "connection closed by server");
+				continue;
+			}
+			c.num_received += size_t(res);
+			if(c.num_received != message_size){
+				continue;
+			}
+
+			if(now >= start){
+				latencies.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - c.sent_at).count()));
+				++num_completed;
+			}
+			send_request(c);
+		}
+	}
+
+	for(auto& c : connections){
+		close(c.fd);
+	}
+	close(epoll_fd);
+
+	result ret{};
+	ret.requests_per_second = double(num_completed) / std::chrono::duration<double>(duration).count();
+
+	if(!latencies.empty()){
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&](double p){
+			return double(latencies[std::min(latencies.size() - 1, size_t(double(latencies.size()) * p))]) / 1000;
+		};
+		ret.p50 = percentile(0.5);
+		ret.p99 = percentile(0.99);
+		ret.p999 = percentile(0.999);
+	}
+
+	return ret;
+}
+
+template <typename server_type>
+void bench_echo(const char* name, size_t num_connections, std::chrono::milliseconds duration){
+	server_type server(num_connections);
+
+	std::thread server_thread([&](){
+		server.run();
+	});
+
+	result r{};
+	try{
+		r = generate_load(server.get_port(), num_connections, duration);
+	}catch(std::system_error& e){
+		server.stop();
+		server_thread.join();
+		std::cout << name << ", " << num_connections << " connections: failed, " << e.what() << std::endl;
+		return;
+	}
+
+	server.stop();
+	server_thread.join();
+
+	std::cout << std::fixed << std::setprecision(1)
+			<< name << ", " << num_connections << " connections: "
+			<< r.requests_per_second << " req/s, latency"
+			<< " p50 " << r.p50 << " us,"
+			<< " p99 " << r.p99 << " us,"
+			<< " p999 " << r.p999 << " us" << std::endl;
+}
+
+// each connection takes two file descriptors, one on client and one on server side
+size_t raise_file_descriptor_limit(){
+	rlimit limit{};
+	if(getrlimit(RLIMIT_NOFILE, &limit) != 0){
+		return 0;
+	}
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+	getrlimit(RLIMIT_NOFILE, &limit);
+	return size_t(limit.rlim_cur);
+}
+}
+#endif
+
+// usage: bench [max_connections] [duration_ms]
+int main(int argc, char *argv[]){
+#if CFG_OS == CFG_OS_LINUX
+	size_t max_connections = argc > 1 ? size_t(std::strtoul(argv[1], nullptr, 10)) : 100000;
+	std::chrono::milliseconds duration(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000);
+
+	size_t max_fds = raise_file_descriptor_limit();
+
+	for(size_t num_connections : {1, 10, 100, 1000, 10000, 100000}){
+		if(num_connections > max_connections){
+			break;
+		}
+		if(num_connections * 2 + 16 > max_fds){
+			std::cout << num_connections << " connections: skipped, file descriptor limit is " << max_fds << std::endl;
+			continue;
+		}
+
+		bench_echo<opros_server>("opros", num_connections, duration);
+		bench_echo<epoll_server>("epoll", num_connections, duration);
+	}
+#else
+	std::cout << "echo benchmark is only supported on linux" << std::endl;
+#endif
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include <utki/config.hpp>
+
+#include "../../src/opros/wait_set.hpp"
+#include "../../tests/helpers/queue.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+#	include "../../src/opros/futex_backend.hpp"
+#endif
+
+namespace{
+constexpr unsigned num_round_trips = 100000;
+
+// passes control back and forth between two threads through message queues,
+// returns time per round trip in nanoseconds
+double bench_queue_handoff(){
+	helpers::queue ping;
+	helpers::queue pong;
+
+	opros::wait_set ping_ws(1);
+	opros::wait_set pong_ws(1);
+	ping_ws.add(ping, {opros::ready::read}, &ping);
+	pong_ws.add(pong, {opros::ready::read}, &pong);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread peer([&](){
+		for(unsigned i = 0; i != num_round_trips; ++i){
+			ping_ws.wait();
+			ping.peek_msg();
+			pong.push_message([](){});
+		}
+	});
+
+	for(unsigned i = 0; i != num_round_trips; ++i){
+		ping.push_message([](){});
+		pong_ws.wait();
+		pong.peek_msg();
+	}
+
+	peer.join();
+
+	auto duration = std::chrono::steady_clock::now() - start;
+
+	ping_ws.remove(ping);
+	pong_ws.remove(pong);
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / num_round_trips;
+}
+
+#if CFG_OS == CFG_OS_LINUX
+// the same as bench_queue_handoff(), but through futex events
+double bench_futex_handoff(){
+	opros::futex_event ping;
+	opros::futex_event pong;
+
+	opros::wait_set ping_ws(1, std::make_unique<opros::futex_backend>());
+	opros::wait_set pong_ws(1, std::make_unique<opros::futex_backend>());
+	ping_ws.add(ping, {opros::ready::read}, &ping);
+	pong_ws.add(pong, {opros::ready::read}, &pong);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread peer([&](){
+		for(unsigned i = 0; i != num_round_trips; ++i){
+			ping_ws.wait();
+			ping.reset();
+			pong.signal();
+		}
+	});
+
+	for(unsigned i = 0; i != num_round_trips; ++i){
+		ping.signal();
+		pong_ws.wait();
+		pong.reset();
+	}
+
+	peer.join();
+
+	auto duration = std::chrono::steady_clock::now() - start;
+
+	ping_ws.remove(ping);
+	pong_ws.remove(pong);
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / num_round_trips;
+}
+#endif
+}
+
+int main(int argc, char *argv[]){
+	std::cout << "queue handoff: " << bench_queue_handoff() << " ns/round trip" << std::endl;
+#if CFG_OS == CFG_OS_LINUX
+	std::cout << "futex handoff: " << bench_futex_handoff() << " ns/round trip" << std::endl;
+#endif
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+#	include "../../src/opros/udp_socket.hpp"
+#	include "../../src/opros/wait_set.hpp"
+
+namespace{
+constexpr size_t num_datagrams = 200000;
+constexpr size_t datagram_size = 64;
+
+// sends datagrams over loopback in batches and receives them in batches,
+// returns time per datagram in nanoseconds
+double bench_udp(size_t batch_size){
+	opros::udp_socket receiver(opros::endpoint("127.0.0.1", 0));
+	opros::udp_socket sender(opros::endpoint("127.0.0.1", 0));
+
+	auto receiver_address = receiver.get_local_endpoint();
+
+	std::vector<std::array<uint8_t, datagram_size>> buffers(batch_size);
+
+	std::vector<opros::udp_socket::datagram> out(batch_size);
+	std::vector<opros::udp_socket::datagram> in(batch_size);
+	for(size_t i = 0; i != batch_size; ++i){
+		out[i].buffer = utki::make_span(buffers[i]);
+		out[i].size = datagram_size;
+		out[i].peer = receiver_address;
+		in[i].buffer = utki::make_span(buffers[i]);
+	}
+
+	opros::wait_set ws(1);
+	ws.add(receiver, {opros::ready::read}, &receiver);
+
+	auto start = std::chrono::steady_clock::now();
+
+	size_t num_received = 0;
+	while(num_received != num_datagrams){
+		size_t num_to_send = std::min(batch_size, num_datagrams - num_received);
+		size_t num_sent = 0;
+		while(num_sent != num_to_send){
+			num_sent += sender.send(utki::make_span(out).subspan(num_sent, num_to_send - num_sent));
+		}
+
+		size_t num_batch_received = 0;
+		while(num_batch_received != num_to_send){
+			ws.wait();
+			// one readiness notification drains the whole batch
+			num_batch_received += receiver.receive(utki::make_span(in).subspan(0, num_to_send - num_batch_received));
+		}
+		num_received += num_batch_received;
+	}
+
+	auto duration = std::chrono::steady_clock::now() - start;
+
+	ws.remove(receiver);
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / num_datagrams;
+}
+}
+#endif
+
+int main(int argc, char *argv[]){
+#if CFG_OS == CFG_OS_LINUX
+	for(size_t batch_size : {1, 4, 16, 64}){
+		std::cout << "udp loopback, batch of " << batch_size << ": " << bench_udp(batch_size) << " ns/datagram" << std::endl;
+	}
+#else
+	std::cout << "udp benchmark is only supported on linux" << std::endl;
+#endif
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include <chrono>
+#include <iostream>
+
+#include <utki/config.hpp>
+
+#include "../../src/opros/wait_set.hpp"
+#include "../../tests/helpers/queue.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+#	include <poll.h>
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+#endif
+
+namespace{
+constexpr unsigned num_iterations = 1000000;
+
+// calls the function num_iterations times after warming up,
+// the function returns number of events it has got
+template <typename function_type>
+double measure(function_type&& step){
+	for(unsigned i = 0; i != num_iterations / 10; ++i){
+		step();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	unsigned num_triggered = 0;
+	for(unsigned i = 0; i != num_iterations; ++i){
+		num_triggered += step();
+	}
+
+	auto duration = std::chrono::steady_clock::now() - start;
+
+	if(num_triggered != num_iterations){
+		std::cout << "unexpected number of triggered events: " << num_triggered << std::endl;
+	}
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / num_iterations;
+}
+
+// measures wait() which returns the posted event, no system calls are made,
+// since the backend wakeup made by the first post is coalesced with all the later ones
+double bench_post(opros::wait_set& ws){
+	int data = 0;
+	return measure([&](){
+		ws.post(&data, {opros::ready::read});
+		ws.wait(0);
+		return unsigned(ws.get_triggered().size());
+	});
+}
+
+// measures wait() which returns one event reported by the backend
+double bench_wait(opros::wait_set& ws){
+	helpers::queue q;
+
+	// queue with a message in it stays readable until the message is taken
+	q.push_message([](){});
+
+	ws.add(q, {opros::ready::read}, &q);
+
+	auto ret = measure([&](){
+		ws.wait(0);
+		return unsigned(ws.get_triggered().size());
+	});
+
+	ws.remove(q);
+
+	return ret;
+}
+
+#if CFG_OS == CFG_OS_LINUX
+// raw poll() system call, the lower bound for the wait() with platform backend
+double bench_raw_poll(){
+	// eventfd with non-zero counter stays readable
+	int fd = eventfd(1, EFD_NONBLOCK);
+	if(fd < 0){
+		return 0;
+	}
+
+	pollfd pfd{};
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	auto ret = measure([&](){
+		return unsigned(poll(&pfd, 1, 0));
+	});
+
+	close(fd);
+
+	return ret;
+}
+#endif
+}
+
+int main(int argc, char *argv[]){
+	// NOTE: the header-only mode only changes how the platform backend's wait() is compiled,
+	//       the wait() path of the wait_set itself is inline in both modes. The platform backend's
+	//       wait() always makes a system call which dominates the time, so the difference between
+	//       the modes is within the measurement noise.
+#ifdef OPROS_HEADER_ONLY
+	std::cout << "mode: header-only" << std::endl;
+#else
+	std::cout << "mode: library" << std::endl;
+#endif
+
+	// the overhead of the wait_set without system calls
+
+	{
+		opros::wait_set ws(1);
+		std::cout << "wait_set(1) posted event: " << bench_post(ws) << " ns/wait" << std::endl;
+	}
+
+	// the wait dominated by the system call
+
+	double platform_wait = 0;
+	{
+		opros::wait_set ws(1);
+		platform_wait = bench_wait(ws);
+		std::cout << "wait_set(1) platform backend event: " << platform_wait << " ns/wait" << std::endl;
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	double raw_poll = bench_raw_poll();
+	std::cout << "raw poll(): " << raw_poll << " ns/call" << std::endl;
+	std::cout << "wait_set(1) overhead over poll(): " << (platform_wait - raw_poll) << " ns/wait" << std::endl;
+#endif
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <utki/span.hpp>
+
+#include "config.hpp"
+#include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Event waiting backend.
+ * Backend does the actual waiting for the wait_set. Platform-specific backend
+ * (epoll on Linux, kqueue on MacOS, WaitForMultipleObjectsEx() on Windows) is used
+ * by default, but a custom one can be passed to the wait_set on construction,
+ * for example the simulation_backend.
+ * All functions, except interrupt(), are called from the thread which owns the wait_set.
+ */
+class backend
+{
+public:
+	/**
+	 * @brief Result of the wait.
+	 */
+	struct wait_result {
+		/**
+		 * @brief Number of events written to the output buffer.
+		 */
+		size_t num_events = 0;
+
+		/**
+		 * @brief Whether the wait was interrupted with interrupt().
+		 */
+		bool interrupted = false;
+
+		/**
+		 * @brief Whether the wait has ended due to timeout.
+		 */
+		bool timed_out = false;
+	};
+
+	backend() = default;
+
+	backend(const backend&) = delete;
+	backend& operator=(const backend&) = delete;
+
+	backend(backend&&) = delete;
+	backend& operator=(backend&&) = delete;
+
+	virtual ~backend() = default;
+
+	/**
+	 * @brief Register waitable.
+	 * @param w - waitable to register.
+	 * @param wait_for - readiness flags to wait for.
+	 * @param user_data - user data to report along with the waitable's events.
+	 */
+	virtual void add(waitable& w, utki::flags<ready> wait_for, void* user_data) = 0;
+
+	/**
+	 * @brief Modify registration of the waitable.
+	 * @param w - registered waitable.
+	 * @param wait_for - new readiness flags to wait for.
+	 * @param user_data - new user data.
+	 */
+	virtual void change(waitable& w, utki::flags<ready> wait_for, void* user_data) = 0;
+
+	/**
+	 * @brief Unregister waitable.
+	 * @param w - registered waitable.
+	 * @return User data the waitable was registered with.
+	 */
+	virtual void* remove(waitable& w) noexcept = 0;
+
+	/**
+	 * @brief Unregister all waitables.
+	 * Default implementation throws, since the backend does not support it.
+	 * @throw std::logic_error - in case the backend does not support clearing.
+	 */
+	virtual void clear()
+	{
+		throw std::logic_error("backend::clear(): not supported by the backend");
+	}
+
+	/**
+	 * @brief Wait for events.
+	 * @param infinite - whether to wait without timeout.
+	 * @param timeout - wait timeout in milliseconds, ignored if infinite is true.
+	 * @param out_events - buffer to store triggered events to.
+	 * @return Result of the wait.
+	 */
+	virtual wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) = 0;
+
+	/**
+	 * @brief Interrupt the wait.
+	 * Must be thread-safe. Several interrupts before the wait returns
+	 * should be coalesced into one.
+	 */
+	virtual void interrupt() noexcept = 0;
+
+	/**
+	 * @brief Prepare the backend for reuse.
+	 * Called by wait_set_pool when the wait_set which used the backend is destroyed.
+	 * At that point no waitables are registered. The backend must discard the
+	 * pending interrupt, if any, so that it does not leak to the next user.
+	 * Default implementation refuses the reuse.
+	 * @return true if the backend can be reused by another wait_set.
+	 * @return false if the backend has to be destroyed.
+	 */
+	virtual bool reset() noexcept
+	{
+		return false;
+	}
+
+protected:
+	static decltype(waitable::handle) get_handle(const waitable& w) noexcept
+	{
+		return w.handle;
+	}
+
+#if CFG_OS == CFG_OS_WINDOWS
+	static void set_waiting_flags(waitable& w, utki::flags<ready> wait_for)
+	{
+		w.set_waiting_flags(wait_for);
+	}
+
+	static utki::flags<ready> get_readiness_flags(waitable& w)
+	{
+		return w.get_readiness_flags();
+	}
+#endif
+};
+
+} // namespace opros
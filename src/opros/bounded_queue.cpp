@@ -0,0 +1,272 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "bounded_queue.hpp"
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#if CFG_OS == CFG_OS_LINUX
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+#elif CFG_OS == CFG_OS_MACOSX
+#	include <fcntl.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
+
+using namespace opros;
+
+namespace {
+#if CFG_OS == CFG_OS_LINUX
+// eventfd is not writable when its counter is at this value
+constexpr const eventfd_t eventfd_max_value = std::numeric_limits<eventfd_t>::max() - 1;
+#elif CFG_OS == CFG_OS_MACOSX
+void set_nonblocking(int fd)
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	int flags = fcntl(fd, F_GETFL, 0);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		throw std::system_error(errno, std::generic_category(), "bounded_queue::bounded_queue(): fcntl() failed");
+	}
+}
+
+// read all the data available on the socket
+void drain(int fd) noexcept
+{
+	std::array<uint8_t, 4096> buf{};
+	while (read(fd, buf.data(), buf.size()) > 0) {
+	}
+}
+
+// write to the socket until the peer's receive buffer is full, after that the socket is not writable
+void fill(int fd) noexcept
+{
+	std::array<uint8_t, 4096> buf{};
+	while (write(fd, buf.data(), buf.size()) > 0) {
+	}
+	while (write(fd, buf.data(), 1) > 0) {
+	}
+}
+#endif
+} // namespace
+
+bounded_queue_base::bounded_queue_base(size_t high_watermark, size_t low_watermark) :
+	waitable([&]() {
+		if (high_watermark == 0) {
+			throw std::invalid_argument("bounded_queue::bounded_queue(): high_watermark is 0");
+		}
+		if (low_watermark >= high_watermark) {
+			throw std::invalid_argument(
+				"bounded_queue::bounded_queue(): low_watermark must be less than high_watermark"
+			);
+		}
+#if CFG_OS == CFG_OS_WINDOWS
+		auto handle = CreateEvent(
+			nullptr, // security attributes
+			TRUE, // manual-reset
+			FALSE, // not signalled initially
+			nullptr // no name
+		);
+		if (handle == nullptr) {
+			throw std::system_error(
+				int(GetLastError()),
+				std::generic_category(),
+				"bounded_queue::bounded_queue(): CreateEvent() failed"
+			);
+		}
+		return handle;
+#elif CFG_OS == CFG_OS_MACOSX
+		// socket end is writable while there is space in the receive buffer of the peer end,
+		// this allows controlling both read and write readiness of a single file descriptor
+		std::array<int, 2> ends{-1, -1};
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends.data()) < 0) {
+			throw std::system_error(errno, std::generic_category(), "bounded_queue::bounded_queue(): socketpair() failed");
+		}
+		this->peer_end = ends[1];
+		try {
+			set_nonblocking(ends[0]);
+			set_nonblocking(ends[1]);
+		} catch (...) {
+			close(ends[0]);
+			close(ends[1]);
+			throw;
+		}
+		return ends[0];
+#elif CFG_OS == CFG_OS_LINUX
+		int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "bounded_queue::bounded_queue(): eventfd() failed");
+		}
+		return fd;
+#else
+#	error "Unsupported OS"
+#endif
+	}()),
+	high_watermark(high_watermark),
+	low_watermark(low_watermark),
+	target{ready::write}
+{
+	this->signal(this->target);
+}
+
+bounded_queue_base::~bounded_queue_base()
+{
+#if CFG_OS == CFG_OS_WINDOWS
+	CloseHandle(this->handle);
+#elif CFG_OS == CFG_OS_MACOSX
+	close(this->handle);
+	close(this->peer_end);
+#elif CFG_OS == CFG_OS_LINUX
+	close(this->handle);
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+bool bounded_queue_base::on_size_changed(size_t size) noexcept
+{
+	if (size >= this->high_watermark) {
+		this->full = true;
+	} else if (size <= this->low_watermark) {
+		this->full = false;
+	}
+
+	utki::flags<ready> readiness = false;
+	readiness.set(ready::read, size != 0);
+	readiness.set(ready::write, !this->full);
+
+	if (readiness == this->target) {
+		return false;
+	}
+	this->target = readiness;
+	return true;
+}
+
+void bounded_queue_base::update_signal()
+{
+	std::lock_guard<decltype(this->signal_mutex)> signal_lock(this->signal_mutex);
+
+	// the readiness could have changed again after it was updated by the calling thread,
+	// so signal the latest one, the thread which has changed it will find it already signalled
+	utki::flags<ready> readiness = false;
+	{
+		std::lock_guard<decltype(this->mut)> lock(this->mut);
+		readiness = this->target;
+	}
+
+	if (readiness != this->signalled) {
+		this->signal(readiness);
+	}
+}
+
+void bounded_queue_base::signal(utki::flags<ready> readiness)
+{
+	// queue cannot be empty and full at the same time
+	utki::assert(readiness.get(ready::read) || readiness.get(ready::write), SL);
+
+#if CFG_OS == CFG_OS_WINDOWS
+	this->signalled = readiness;
+	if (!(this->waiting_flags & readiness).is_clear()) {
+		if (SetEvent(this->handle) == 0) {
+			throw std::system_error(int(GetLastError()), std::generic_category(), "bounded_queue: SetEvent() failed");
+		}
+	} else {
+		if (ResetEvent(this->handle) == 0) {
+			throw std::system_error(int(GetLastError()), std::generic_category(), "bounded_queue: ResetEvent() failed");
+		}
+	}
+#elif CFG_OS == CFG_OS_MACOSX
+	if (readiness.get(ready::read) != this->signalled.get(ready::read)) {
+		if (readiness.get(ready::read)) {
+			std::array<uint8_t, 1> one_byte_buf{};
+			if (write(this->peer_end, one_byte_buf.data(), 1) != 1) {
+				throw std::system_error(errno, std::generic_category(), "bounded_queue: write() failed");
+			}
+		} else {
+			drain(this->handle);
+		}
+	}
+	if (readiness.get(ready::write) != this->signalled.get(ready::write)) {
+		if (readiness.get(ready::write)) {
+			drain(this->peer_end);
+		} else {
+			fill(this->handle);
+		}
+	}
+	this->signalled = readiness;
+#elif CFG_OS == CFG_OS_LINUX
+	// eventfd counter values:
+	// - 0: empty, readable is not signalled, writable is signalled
+	// - 1: not empty and not full, both readable and writable are signalled
+	// - max value: full, only readable is signalled
+	eventfd_t value = 0;
+	if (!readiness.get(ready::write)) {
+		value = eventfd_max_value;
+	} else if (readiness.get(ready::read)) {
+		value = 1;
+	}
+
+	if (this->signalled.get(ready::read)) {
+		eventfd_t old_value = 0;
+		if (eventfd_read(this->handle, &old_value) < 0) {
+			throw std::system_error(errno, std::generic_category(), "bounded_queue: eventfd_read() failed");
+		}
+	}
+	if (value != 0) {
+		if (eventfd_write(this->handle, value) < 0) {
+			throw std::system_error(errno, std::generic_category(), "bounded_queue: eventfd_write() failed");
+		}
+	}
+	this->signalled = readiness;
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+#if CFG_OS == CFG_OS_WINDOWS
+void bounded_queue_base::set_waiting_flags(utki::flags<ready> wait_for)
+{
+	if (!utki::flags<ready>(wait_for).clear(ready::read).clear(ready::write).is_clear()) {
+		throw std::invalid_argument(
+			"bounded_queue::set_waiting_flags(): only ready::read and ready::write flags are allowed"
+		);
+	}
+
+	std::lock_guard<decltype(this->signal_mutex)> lock(this->signal_mutex);
+	this->waiting_flags = wait_for;
+	this->signal(this->signalled);
+}
+
+utki::flags<ready> bounded_queue_base::get_readiness_flags()
+{
+	std::lock_guard<decltype(this->signal_mutex)> lock(this->signal_mutex);
+	return this->waiting_flags & this->signalled;
+}
+#endif
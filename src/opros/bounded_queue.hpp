@@ -0,0 +1,219 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include <utki/config.hpp>
+#include <utki/spin_lock.hpp>
+
+#include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Base class of the bounded queue.
+ * Implements the readiness signalling of the bounded_queue, independent of the item type.
+ * Use bounded_queue instead of this class.
+ */
+class bounded_queue_base : public waitable
+{
+protected:
+	utki::spin_lock mut;
+
+private:
+	const size_t high_watermark;
+	const size_t low_watermark;
+
+	// queue has reached the high watermark and has not yet dropped to the low watermark
+	bool full = false;
+
+	// readiness to be signalled by the handle, protected by the mutex
+	utki::flags<ready> target = false;
+
+	// serializes the system calls updating the handle, those are made without holding the spin lock,
+	// so that contending producers and consumers do not spin through a system call
+	std::mutex signal_mutex;
+
+	// readiness currently signalled by the handle, protected by the signal_mutex
+	utki::flags<ready> signalled = false;
+
+#if CFG_OS == CFG_OS_WINDOWS
+	// protected by the signal_mutex
+	utki::flags<ready> waiting_flags = false;
+#elif CFG_OS == CFG_OS_MACOSX
+	// other end of the socket pair, the waitable handle is one end
+	int peer_end;
+#endif
+
+	void signal(utki::flags<ready> readiness);
+
+protected:
+	/**
+	 * @brief Constructor.
+	 * @param high_watermark - number of items at which the queue stops accepting new items.
+	 * @param low_watermark - number of items to which the full queue has to drop to accept new items again.
+	 * @throw std::invalid_argument - in case high_watermark is 0 or low_watermark is not less than high_watermark.
+	 */
+	bounded_queue_base(size_t high_watermark, size_t low_watermark);
+
+	~bounded_queue_base()
+#if CFG_OS == CFG_OS_WINDOWS
+		override
+#endif
+		;
+
+	/**
+	 * @brief Check if new items are accepted.
+	 * Must be called with the mutex locked.
+	 * @return true if the queue is not full.
+	 */
+	bool is_accepting() const noexcept
+	{
+		return !this->full;
+	}
+
+	/**
+	 * @brief Update readiness after the number of items has changed.
+	 * Must be called with the mutex locked.
+	 * @param size - current number of items in the queue.
+	 * @return true if the readiness has changed and update_signal() has to be called after unlocking the mutex.
+	 */
+	bool on_size_changed(size_t size) noexcept;
+
+	/**
+	 * @brief Make the handle signal the current readiness.
+	 * Must be called with the mutex unlocked.
+	 */
+	void update_signal();
+
+#if CFG_OS == CFG_OS_WINDOWS
+	void set_waiting_flags(utki::flags<ready> wait_for) override;
+	utki::flags<ready> get_readiness_flags() override;
+#endif
+
+public:
+	bounded_queue_base(const bounded_queue_base&) = delete;
+	bounded_queue_base& operator=(const bounded_queue_base&) = delete;
+
+	bounded_queue_base(bounded_queue_base&&) = delete;
+	bounded_queue_base& operator=(bounded_queue_base&&) = delete;
+};
+
+/**
+ * @brief Thread-safe bounded queue.
+ * The waitable is ready to read when the queue is not empty and ready to write when the queue accepts new items.
+ * When the number of items reaches the high watermark the queue stops accepting new items until the
+ * number of items drops to the low watermark. This way producers can wait for ready::write in their own
+ * wait_sets instead of spinning, and the backpressure propagates from consumers to producers.
+ * The readiness is signalled through the handle only when it changes, so pushing to a non-empty queue
+ * and popping from a queue which does not drop to the low watermark do not make system calls.
+ * @tparam T - type of the items.
+ */
+template <typename T>
+class bounded_queue final : public bounded_queue_base
+{
+	std::deque<T> items;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param high_watermark - number of items at which the queue stops accepting new items.
+	 * @param low_watermark - number of items to which the full queue has to drop to accept new items again.
+	 * @throw std::invalid_argument - in case high_watermark is 0 or low_watermark is not less than high_watermark.
+	 */
+	bounded_queue(size_t high_watermark, size_t low_watermark) :
+		bounded_queue_base(high_watermark, low_watermark)
+	{}
+
+	bounded_queue(const bounded_queue&) = delete;
+	bounded_queue& operator=(const bounded_queue&) = delete;
+
+	bounded_queue(bounded_queue&&) = delete;
+	bounded_queue& operator=(bounded_queue&&) = delete;
+
+	~bounded_queue() = default;
+
+	/**
+	 * @brief Push item to the queue.
+	 * @param item - item to push.
+	 * @return true if the item was pushed.
+	 * @return false if the queue is full, the item is left untouched in that case.
+	 */
+	bool try_push(T&& item)
+	{
+		{
+			std::lock_guard<decltype(this->mut)> lock(this->mut);
+			if (!this->is_accepting()) {
+				return false;
+			}
+			this->items.push_back(std::move(item));
+			if (!this->on_size_changed(this->items.size())) {
+				return true;
+			}
+		}
+		this->update_signal();
+		return true;
+	}
+
+	/**
+	 * @brief Pop item from the queue.
+	 * @return the item from the front of the queue.
+	 * @return std::nullopt if the queue is empty.
+	 */
+	std::optional<T> try_pop()
+	{
+		std::optional<T> ret;
+		{
+			std::lock_guard<decltype(this->mut)> lock(this->mut);
+			if (this->items.empty()) {
+				return std::nullopt;
+			}
+			ret.emplace(std::move(this->items.front()));
+			this->items.pop_front();
+			if (!this->on_size_changed(this->items.size())) {
+				return ret;
+			}
+		}
+		this->update_signal();
+		return ret;
+	}
+
+	/**
+	 * @brief Get number of items in the queue.
+	 * @return number of items in the queue.
+	 */
+	size_t size()
+	{
+		std::lock_guard<decltype(this->mut)> lock(this->mut);
+		return this->items.size();
+	}
+};
+
+} // namespace opros
@@ -0,0 +1,401 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "concurrent_epoll_backend.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <chrono>
+#	include <limits>
+#	include <stdexcept>
+#	include <system_error>
+
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+uint32_t to_epoll_events(utki::flags<ready> wait_for, bool oneshot)
+{
+	// NOTE: EPOLLHUP is always reported, no need to request it
+	return (oneshot ? unsigned(EPOLLONESHOT) : 0) |
+		(wait_for.get(ready::read) ? (unsigned(EPOLLIN) | unsigned(EPOLLRDHUP)) : 0) |
+		(wait_for.get(ready::priority) ? unsigned(EPOLLPRI) : 0) | (wait_for.get(ready::write) ? unsigned(EPOLLOUT) : 0) |
+		(EPOLLERR);
+}
+
+utki::flags<ready> to_ready_flags(uint32_t events)
+{
+	utki::flags<ready> ret = false;
+	ret.set(ready::error, (events & EPOLLERR) != 0);
+	ret.set(ready::hangup, (events & EPOLLHUP) != 0);
+	ret.set(ready::read, (events & EPOLLIN) != 0);
+	ret.set(ready::read_hangup, (events & EPOLLRDHUP) != 0);
+	ret.set(ready::priority, (events & EPOLLPRI) != 0);
+	ret.set(ready::write, (events & EPOLLOUT) != 0);
+	return ret;
+}
+
+// flags which are reported for the given wait flags
+utki::flags<ready> get_reportable_flags(utki::flags<ready> wait_for)
+{
+	wait_for.set(ready::error);
+	wait_for.set(ready::hangup);
+	if (wait_for.get(ready::read)) {
+		wait_for.set(ready::read_hangup);
+	}
+	return wait_for;
+}
+
+// the epoll event data holds the handle in lower 32 bits and the registration generation in upper 32 bits
+uint64_t make_event_data(int handle, uint32_t generation)
+{
+	return (uint64_t(generation) << 32) | uint32_t(handle);
+}
+
+// data of the interrupt eventfd's epoll event, generation 0 is never used by registrations
+constexpr const uint64_t interrupt_event_data = std::numeric_limits<uint32_t>::max();
+
+// data of the wakeup eventfd's epoll event
+constexpr const uint64_t wakeup_event_data = interrupt_event_data - 1;
+
+// creates epoll set with the interrupt eventfd added to it
+int create_epoll_set(int interrupt_fd)
+{
+	int epoll_set = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_set < 0) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): epoll_create1() failed");
+	}
+
+	epoll_event e{};
+	e.data.u64 = interrupt_event_data;
+	e.events = EPOLLIN;
+	if (epoll_ctl(epoll_set, EPOLL_CTL_ADD, interrupt_fd, &e) < 0) {
+		auto err = errno;
+		close(epoll_set);
+		throw std::system_error(err, std::generic_category(), "wait_set::wait_set(): epoll_ctl() failed");
+	}
+
+	return epoll_set;
+}
+} // namespace
+
+concurrent_epoll_backend::concurrent_epoll_backend(unsigned capacity, bool oneshot) :
+	oneshot(oneshot),
+	// NOTE: no extra slot for the interrupt eventfd, so that epoll_wait() never returns more events
+	// than the capacity, in case more waitables than the capacity are added, dropping the extra
+	// event is not an option because in oneshot mode it would not be reported again
+	revents(capacity)
+{
+	if (capacity >= unsigned(std::numeric_limits<int>::max())) {
+		throw std::invalid_argument("wait_set(): given capacity is too big, should be < INT_MAX");
+	}
+	utki::assert(int(capacity) > 0, SL);
+
+	this->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (this->interrupt_fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): eventfd() failed");
+	}
+
+	// counter is never read, so the eventfd stays readable
+	this->wakeup_fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (this->wakeup_fd < 0) {
+		auto err = errno;
+		close(this->interrupt_fd);
+		throw std::system_error(err, std::generic_category(), "wait_set::wait_set(): eventfd() failed");
+	}
+
+	try {
+		this->epoll_set = create_epoll_set(this->interrupt_fd);
+	} catch (...) {
+		close(this->wakeup_fd);
+		close(this->interrupt_fd);
+		throw;
+	}
+}
+
+concurrent_epoll_backend::~concurrent_epoll_backend()
+{
+	utki::assert(this->retired_set < 0, SL);
+	close(this->wakeup_fd);
+	close(this->interrupt_fd);
+	close(this->epoll_set);
+}
+
+void concurrent_epoll_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	auto handle = get_handle(w);
+
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	++this->next_generation;
+	if (this->next_generation == 0) {
+		++this->next_generation;
+	}
+
+	auto res = this->registrations.try_emplace(handle, registration{this->next_generation, wait_for, user_data});
+	if (!res.second) {
+		throw std::logic_error("wait_set::add(): the waitable is already added to this wait set");
+	}
+
+	epoll_event e{};
+	e.data.u64 = make_event_data(handle, this->next_generation);
+	e.events = to_epoll_events(wait_for, this->oneshot);
+	if (epoll_ctl(this->epoll_set, EPOLL_CTL_ADD, handle, &e) < 0) {
+		auto err = errno;
+		this->registrations.erase(res.first);
+		throw std::system_error(err, std::generic_category(), "wait_set::add(): epoll_ctl() failed");
+	}
+}
+
+void concurrent_epoll_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	auto handle = get_handle(w);
+
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(handle);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
+	}
+	auto& r = i->second;
+
+	// user data is not passed to the kernel, so changing only the user data does not need a system call,
+	// unless in one-shot mode, where change() re-arms the waitable
+	if (r.wait_for != wait_for || this->oneshot) {
+		epoll_event e{};
+		e.data.u64 = make_event_data(handle, r.generation);
+		e.events = to_epoll_events(wait_for, this->oneshot);
+		if (epoll_ctl(this->epoll_set, EPOLL_CTL_MOD, handle, &e) < 0) {
+			throw std::system_error(errno, std::generic_category(), "wait_set::change(): epoll_ctl() failed");
+		}
+		r.wait_for = wait_for;
+	}
+
+	r.user_data = user_data;
+}
+
+void* concurrent_epoll_backend::remove(waitable& w) noexcept
+{
+	auto handle = get_handle(w);
+
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(handle);
+	if (i == this->registrations.end()) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::remove(): waitable is not added to wait set";
+			},
+			SL
+		);
+		return nullptr;
+	}
+	void* user_data = i->second.user_data;
+
+	if (epoll_ctl(this->epoll_set, EPOLL_CTL_DEL, handle, nullptr) < 0) {
+		utki::assert(false, SL);
+	}
+
+	// the events of this registration which are already returned by epoll_wait() are
+	// dropped by collect_events() since the registration is not found anymore
+	this->registrations.erase(i);
+
+	return user_data;
+}
+
+void concurrent_epoll_backend::clear()
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	// closing the epoll set drops all the registrations with a single system call,
+	// the interrupt eventfd is added to the new epoll set, so pending interrupt is kept
+	int new_epoll_set = create_epoll_set(this->interrupt_fd);
+
+	if (this->waiting_set == this->epoll_set) {
+		// the waiting thread is blocked on the old epoll set, so it cannot be closed right away,
+		// make the old epoll set ready, so that the waiting thread switches to the new one
+		epoll_event e{};
+		e.data.u64 = wakeup_event_data;
+		e.events = EPOLLIN;
+		if (epoll_ctl(this->epoll_set, EPOLL_CTL_ADD, this->wakeup_fd, &e) < 0) {
+			auto err = errno;
+			close(new_epoll_set);
+			throw std::system_error(err, std::generic_category(), "wait_set::clear(): epoll_ctl() failed");
+		}
+		utki::assert(this->retired_set < 0, SL);
+		this->retired_set = this->epoll_set;
+	} else {
+		close(this->epoll_set);
+	}
+	this->epoll_set = new_epoll_set;
+
+	this->registrations.clear();
+}
+
+void concurrent_epoll_backend::interrupt() noexcept
+{
+	if (eventfd_write(this->interrupt_fd, 1) < 0) {
+		utki::assert(false, SL);
+	}
+}
+
+bool concurrent_epoll_backend::reset() noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	utki::assert(this->registrations.empty(), SL);
+
+	// drop pending interrupt
+	eventfd_t value = 0;
+	if (eventfd_read(this->interrupt_fd, &value) < 0) {
+		utki::assert(errno == EAGAIN, SL);
+	}
+
+	return true;
+}
+
+int concurrent_epoll_backend::begin_wait()
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->waiting_set = this->epoll_set;
+	return this->waiting_set;
+}
+
+void concurrent_epoll_backend::end_wait(int set) noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->waiting_set = -1;
+	if (this->retired_set == set) {
+		close(this->retired_set);
+		this->retired_set = -1;
+	}
+}
+
+size_t concurrent_epoll_backend::collect_events(
+	int num_triggered,
+	utki::span<event_info> out_events,
+	bool& interrupted
+)
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	size_t out_i = 0;
+	for (const auto& e : utki::make_span(this->revents.data(), size_t(num_triggered))) {
+		if (e.data.u64 == interrupt_event_data) {
+			// reset the eventfd counter, so that all interrupts issued so far are coalesced into one
+			eventfd_t value = 0;
+			if (eventfd_read(this->interrupt_fd, &value) < 0) {
+				utki::assert(errno == EAGAIN, SL);
+			}
+			interrupted = true;
+			continue;
+		}
+
+		if (e.data.u64 == wakeup_event_data) {
+			// the epoll set was replaced by clear()
+			continue;
+		}
+
+		auto handle = int(uint32_t(e.data.u64));
+		auto generation = uint32_t(e.data.u64 >> 32);
+
+		auto i = this->registrations.find(handle);
+		if (i == this->registrations.end() || i->second.generation != generation) {
+			// the waitable was removed after epoll_wait() has returned
+			continue;
+		}
+		const auto& r = i->second;
+
+		auto flags = to_ready_flags(e.events) & get_reportable_flags(r.wait_for);
+		if (flags.is_clear()) {
+			// the wait flags were changed after epoll_wait() has returned
+			continue;
+		}
+
+		utki::assert(out_i < out_events.size(), SL);
+		out_events[out_i] = {flags, r.user_data};
+		++out_i;
+	}
+
+	return out_i;
+}
+
+backend::wait_result concurrent_epoll_backend::wait(
+	bool infinite,
+	uint32_t timeout,
+	utki::span<event_info> out_events
+)
+{
+	using std::chrono::steady_clock;
+
+	utki::assert(this->revents.size() == out_events.size(), SL);
+
+	auto deadline = steady_clock::now() + std::chrono::milliseconds(timeout);
+
+	wait_result ret;
+
+	// events can be dropped because of concurrent removal, in that case wait again
+	while (true) {
+		int epoll_timeout = -1;
+		if (!infinite) {
+			auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - steady_clock::now()).count();
+			epoll_timeout = int(std::clamp<decltype(remaining)>(remaining, 0, std::numeric_limits<int>::max()));
+		}
+
+		int set = this->begin_wait();
+		int num_triggered = epoll_wait(set, this->revents.data(), int(this->revents.size()), epoll_timeout);
+		auto err = errno;
+		this->end_wait(set);
+
+		if (num_triggered < 0) {
+			// if interrupted by signal, try waiting again
+			if (err == EINTR) {
+				continue;
+			}
+			throw std::system_error(err, std::generic_category(), "wait_set::wait(): epoll_wait() failed");
+		}
+
+		if (num_triggered == 0) {
+			if (steady_clock::now() < deadline) {
+				// timeout is bigger than epoll_wait() can handle at once
+				continue;
+			}
+			ret.timed_out = true;
+			return ret;
+		}
+
+		ret.num_events = this->collect_events(num_triggered, out_events, ret.interrupted);
+		if (ret.num_events != 0 || ret.interrupted) {
+			return ret;
+		}
+	}
+}
+
+#endif
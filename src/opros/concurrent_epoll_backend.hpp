@@ -0,0 +1,125 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <mutex>
+#	include <unordered_map>
+#	include <vector>
+
+#	include <sys/epoll.h>
+
+#	include "backend.hpp"
+
+namespace opros {
+
+/**
+ * @brief Linux epoll based backend with thread-safe registration.
+ * Waitables can be added, changed and removed from any thread, including while another thread
+ * is blocked in wait(). The registrations are passed to the kernel right away, so the blocked wait()
+ * starts reporting the newly added waitable without being interrupted.
+ * Each registration gets a generation number which is stored in the epoll event data along with the handle,
+ * and the events returned by epoll_wait() are checked against the current registrations before being reported.
+ * Thus, after remove() returns, the wait() which is blocked at the moment, as well as all later wait() calls,
+ * do not report the events of the removed waitable, even if its handle is reused by another waitable.
+ * Events are also filtered by the current wait flags, so the flags removed with change() are not reported either.
+ * clear() can be called while another thread is blocked in wait(), the old epoll set is closed
+ * after the waiting thread has switched to the new one.
+ * Only one thread can wait at a time.
+ *
+ * In one-shot mode each waitable is disabled after its event is reported by wait(),
+ * until change() is called for it. The change() re-arms the waitable with a single epoll_ctl() call,
+ * even if the wait flags are not changed. This allows handling the event in another thread
+ * and putting the waitable back to waiting afterwards without interrupting the waiting thread.
+ */
+class concurrent_epoll_backend final : public backend
+{
+	struct registration {
+		uint32_t generation;
+		utki::flags<ready> wait_for;
+		void* user_data;
+	};
+
+	const bool oneshot;
+
+	int epoll_set;
+
+	int interrupt_fd; // eventfd used by interrupt()
+
+	// always readable eventfd, used by clear() to wake up the thread waiting on the old epoll set
+	int wakeup_fd;
+
+	// epoll set the waiting thread is blocked on, -1 if there is no waiting thread
+	int waiting_set = -1;
+
+	// old epoll set replaced by clear() while the thread was waiting on it, closed when the wait ends
+	int retired_set = -1;
+
+	std::vector<epoll_event> revents; // used for getting the result from epoll_wait()
+
+	std::mutex mutex;
+
+	std::unordered_map<int, registration> registrations;
+
+	uint32_t next_generation = 0;
+
+	int begin_wait();
+	void end_wait(int set) noexcept;
+
+	size_t collect_events(int num_triggered, utki::span<event_info> out_events, bool& interrupted);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables.
+	 * @param oneshot - whether to use one-shot mode.
+	 */
+	concurrent_epoll_backend(unsigned capacity, bool oneshot = false);
+
+	concurrent_epoll_backend(const concurrent_epoll_backend&) = delete;
+	concurrent_epoll_backend& operator=(const concurrent_epoll_backend&) = delete;
+
+	concurrent_epoll_backend(concurrent_epoll_backend&&) = delete;
+	concurrent_epoll_backend& operator=(concurrent_epoll_backend&&) = delete;
+
+	~concurrent_epoll_backend() override;
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
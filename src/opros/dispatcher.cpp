@@ -0,0 +1,311 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "dispatcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace opros;
+
+bool dispatcher::registration::take_token(clock::time_point now) noexcept
+{
+	std::chrono::duration<double> elapsed = now - this->last_refill;
+	this->last_refill = now;
+	this->tokens = std::min(this->limit.burst, this->tokens + elapsed.count() * this->limit.rate);
+
+	if (this->tokens < 1) {
+		return false;
+	}
+	this->tokens -= 1;
+	return true;
+}
+
+dispatcher::dispatcher(unsigned capacity, size_t events_per_iteration) :
+	ws(capacity),
+	events_per_iteration(events_per_iteration)
+{
+	if (events_per_iteration == 0) {
+		throw std::invalid_argument("dispatcher::dispatcher(): events_per_iteration is 0");
+	}
+}
+
+dispatcher::~dispatcher()
+{
+	// registered waitables are dropped along with the wait set
+	this->ws.set_destroy_with_contents(true);
+}
+
+dispatcher::registration& dispatcher::get_registration(const waitable& w)
+{
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("dispatcher: waitable is not added");
+	}
+	return *i->second;
+}
+
+void dispatcher::add(waitable& w, utki::flags<ready> wait_for, handler_type handler)
+{
+	if (this->registrations.find(&w) != this->registrations.end()) {
+		throw std::logic_error("dispatcher::add(): waitable is already added");
+	}
+
+	auto r = std::make_unique<registration>(w, wait_for, std::move(handler));
+
+	this->ws.add(w, wait_for, r.get());
+
+	this->registrations.emplace(&w, std::move(r));
+}
+
+void dispatcher::add(waitable& w, utki::flags<ready> wait_for, handler_type handler, rate_limit limit)
+{
+	if (!(limit.rate > 0)) {
+		throw std::invalid_argument("dispatcher::add(): rate is not positive");
+	}
+	if (!(limit.burst >= 1)) {
+		throw std::invalid_argument("dispatcher::add(): burst is less than 1");
+	}
+
+	this->add(w, wait_for, std::move(handler));
+
+	auto& r = *this->registrations.at(&w);
+	r.limited = true;
+	r.limit = limit;
+	r.tokens = limit.burst;
+	r.last_refill = clock::now();
+}
+
+void dispatcher::change(waitable& w, utki::flags<ready> wait_for)
+{
+	auto& r = this->get_registration(w);
+
+	if (!r.muted) {
+		this->ws.change(w, wait_for, &r);
+	}
+	r.wait_for = wait_for;
+}
+
+void dispatcher::remove(waitable& w)
+{
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("dispatcher::remove(): waitable is not added");
+	}
+
+	auto& r = *i->second;
+
+	if (!r.muted) {
+		this->ws.remove(w);
+	}
+
+	r.removed = true;
+
+	if (r.queued || r.muted || r.dispatching) {
+		// still referenced from the ready queue, the mute queue or the running handler
+		this->removed_registrations.push_back(std::move(i->second));
+	}
+	this->registrations.erase(i);
+}
+
+bool dispatcher::is_muted(const waitable& w)
+{
+	return this->get_registration(w).muted;
+}
+
+void dispatcher::set_deadline(const waitable& w, clock::duration deadline)
+{
+	this->get_registration(w).deadline = deadline;
+}
+
+void dispatcher::enqueue(clock::time_point deadline, registration* r, work_type&& work)
+{
+	this->ready_queue.push_back(ready_entry{deadline, this->next_sequence, r, std::move(work)});
+	++this->next_sequence;
+	std::push_heap(this->ready_queue.begin(), this->ready_queue.end(), std::greater<>());
+}
+
+dispatcher::ready_entry dispatcher::dequeue()
+{
+	utki::assert(!this->ready_queue.empty(), SL);
+	std::pop_heap(this->ready_queue.begin(), this->ready_queue.end(), std::greater<>());
+	auto e = std::move(this->ready_queue.back());
+	this->ready_queue.pop_back();
+	return e;
+}
+
+void dispatcher::post(work_type work, clock::time_point deadline)
+{
+	this->enqueue(deadline, nullptr, std::move(work));
+}
+
+void dispatcher::mute(registration& r, clock::time_point now)
+{
+	utki::assert(!r.muted, SL);
+	utki::assert(r.tokens < 1, SL);
+
+	// Muted waitable is taken out of the wait set instead of changing its wait flags to none,
+	// because error and hangup are reported regardless of the wait flags and would make
+	// the loop spin until the waitable is unmuted.
+	this->ws.remove(r.w);
+	r.muted = true;
+
+	auto refill_time = std::chrono::duration<double>((1 - r.tokens) / r.limit.rate);
+	this->muted.push({now + std::chrono::duration_cast<clock::duration>(refill_time), &r});
+}
+
+void dispatcher::unmute_due(clock::time_point now)
+{
+	while (!this->muted.empty() && this->muted.top().until <= now) {
+		auto& r = *this->muted.top().r;
+		this->muted.pop();
+
+		r.muted = false;
+		if (r.removed) {
+			continue;
+		}
+
+		this->ws.add(r.w, r.wait_for, &r);
+	}
+}
+
+void dispatcher::free_removed() noexcept
+{
+	auto& v = this->removed_registrations;
+	v.erase(
+		std::remove_if(
+			v.begin(),
+			v.end(),
+			[](const auto& r) {
+				return !r->queued && !r->muted && !r->dispatching;
+			}
+		),
+		v.end()
+	);
+}
+
+size_t dispatcher::run_once_internal(bool infinite, uint32_t timeout)
+{
+	this->unmute_due(clock::now());
+
+	if (!this->ready_queue.empty()) {
+		// there are entries left from previous iteration, only poll for new events
+		infinite = false;
+		timeout = 0;
+	} else if (!this->muted.empty()) {
+		using std::chrono::milliseconds;
+		auto until_unmute = this->muted.top().until - clock::now();
+		// round up to not wake up before the refill time
+		auto ms = std::max(
+			std::chrono::duration_cast<milliseconds>(until_unmute + milliseconds(1) - clock::duration(1)).count(),
+			milliseconds::rep(0)
+		);
+		if (infinite || milliseconds::rep(timeout) > ms) {
+			infinite = false;
+			timeout = uint32_t(ms);
+		}
+	}
+
+	if (infinite) {
+		this->ws.wait();
+	} else {
+		this->ws.wait(timeout);
+	}
+
+	auto now = clock::now();
+
+	for (const auto& e : this->ws.get_triggered()) {
+		auto& r = *static_cast<registration*>(e.user_data);
+		utki::assert(!r.removed, SL);
+		utki::assert(!r.muted, SL);
+
+		r.pending_flags |= e.flags;
+		if (!r.queued) {
+			r.queued = true;
+			auto deadline = r.deadline == clock::duration::max() || now > clock::time_point::max() - r.deadline
+				? clock::time_point::max()
+				: now + r.deadline;
+			this->enqueue(deadline, &r, nullptr);
+		}
+	}
+
+	this->unmute_due(now);
+
+	size_t num_called = 0;
+	while (!this->ready_queue.empty() && num_called != this->events_per_iteration) {
+		auto e = this->dequeue();
+
+		auto check_deadline = [&]() {
+			if (e.deadline != clock::time_point::max() && e.deadline < clock::now()) {
+				++this->num_missed_deadlines;
+			}
+		};
+
+		if (!e.r) {
+			check_deadline();
+			e.work();
+			++num_called;
+			continue;
+		}
+
+		auto& r = *e.r;
+		r.queued = false;
+
+		if (r.removed) {
+			continue;
+		}
+
+		auto flags = r.pending_flags;
+		r.pending_flags.clear();
+
+		if (r.limited && !r.take_token(now)) {
+			this->mute(r, now);
+			continue;
+		}
+
+		check_deadline();
+
+		r.dispatching = true;
+		try {
+			r.handler(flags);
+		} catch (...) {
+			r.dispatching = false;
+			this->free_removed();
+			throw;
+		}
+		r.dispatching = false;
+
+		++num_called;
+
+		if (r.limited && !r.removed && !r.muted && r.tokens < 1) {
+			this->mute(r, now);
+		}
+	}
+
+	this->free_removed();
+
+	return num_called;
+}
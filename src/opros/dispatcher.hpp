@@ -0,0 +1,317 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "wait_set.hpp"
+
+namespace opros {
+
+/**
+ * @brief Event loop with fair dispatch.
+ * Dispatcher owns a wait_set and calls the handlers of the triggered waitables.
+ * The triggered waitables and the posted work items are put to the ready queue and the handlers are called
+ * in earliest deadline first order, at most a given number of handlers per iteration. Handlers without
+ * deadline are called after the ones with deadline, in the order they were queued. The waitables which were
+ * not served stay in the queue for the next iteration, and a waitable which triggers again while being
+ * in the queue is not queued for the second time. So, a waitable which triggers on every iteration
+ * is served in turn with the others.
+ * Each waitable can have a token bucket rate limit. Each handler call takes one token. When there are
+ * no tokens left, the waitable is muted, i.e. taken out of the wait_set, and is put back automatically
+ * when the bucket refills. Thus, a flooding source cannot take more than its share of the loop.
+ * Dispatcher is not thread-safe, except interrupt().
+ */
+class dispatcher
+{
+public:
+	/**
+	 * @brief Type of event handler.
+	 * The handler is called with the readiness flags of the triggered waitable.
+	 * The handler can add, change and remove waitables, including its own one.
+	 */
+	using handler_type = std::function<void(utki::flags<ready>)>;
+
+	/**
+	 * @brief Type of posted work item.
+	 */
+	using work_type = std::function<void()>;
+
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Token bucket rate limit.
+	 */
+	struct rate_limit {
+		/**
+		 * @brief Token refill rate, in handler calls per second.
+		 */
+		double rate;
+
+		/**
+		 * @brief Bucket size, i.e. maximum number of handler calls in a burst.
+		 */
+		double burst;
+	};
+
+private:
+	struct registration {
+		waitable& w;
+		utki::flags<ready> wait_for;
+		handler_type handler;
+
+		bool limited;
+		rate_limit limit;
+		double tokens;
+		clock::time_point last_refill;
+
+		// relative deadline of handling the event, counted from the moment the event is noticed
+		clock::duration deadline = clock::duration::max();
+
+		// readiness flags accumulated while waiting in the ready queue
+		utki::flags<ready> pending_flags = false;
+
+		bool queued = false;
+
+		// the handler is being called, so the registration must outlive a remove() made by the handler
+		bool dispatching = false;
+
+		bool muted = false;
+		bool removed = false;
+
+		registration(waitable& w, utki::flags<ready> wait_for, handler_type&& handler) :
+			w(w),
+			wait_for(wait_for),
+			handler(std::move(handler)),
+			limited(false),
+			limit{0, 0},
+			tokens(0)
+		{}
+
+		// refill the bucket and try to take a token
+		bool take_token(clock::time_point now) noexcept;
+	};
+
+	struct mute_entry {
+		clock::time_point until;
+		registration* r;
+
+		bool operator>(const mute_entry& e) const noexcept
+		{
+			return this->until > e.until;
+		}
+	};
+
+	opros::wait_set ws;
+
+	const size_t events_per_iteration;
+
+	std::unordered_map<const waitable*, std::unique_ptr<registration>> registrations;
+
+	// registrations removed while being in the ready queue, muted or having the handler called,
+	// those are freed when no longer referenced
+	std::vector<std::unique_ptr<registration>> removed_registrations;
+
+	struct ready_entry {
+		clock::time_point deadline;
+
+		// sequence number of queuing, for FIFO order among entries with the same deadline
+		uint64_t sequence;
+
+		// either registration or posted work
+		registration* r;
+		work_type work;
+
+		bool operator>(const ready_entry& e) const noexcept
+		{
+			if (this->deadline != e.deadline) {
+				return this->deadline > e.deadline;
+			}
+			return this->sequence > e.sequence;
+		}
+	};
+
+	// min-heap by deadline
+	std::vector<ready_entry> ready_queue;
+
+	uint64_t next_sequence = 0;
+
+	size_t num_missed_deadlines = 0;
+
+	void enqueue(clock::time_point deadline, registration* r, work_type&& work);
+	ready_entry dequeue();
+
+	std::priority_queue<mute_entry, std::vector<mute_entry>, std::greater<>> muted;
+
+	registration& get_registration(const waitable& w);
+
+	void mute(registration& r, clock::time_point now);
+	void unmute_due(clock::time_point now);
+
+	void free_removed() noexcept;
+
+	size_t run_once_internal(bool infinite, uint32_t timeout);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables.
+	 * @param events_per_iteration - maximum number of handler calls per iteration.
+	 * @throw std::invalid_argument - in case events_per_iteration is 0.
+	 */
+	dispatcher(unsigned capacity, size_t events_per_iteration = 64);
+
+	dispatcher(const dispatcher&) = delete;
+	dispatcher& operator=(const dispatcher&) = delete;
+
+	dispatcher(dispatcher&&) = delete;
+	dispatcher& operator=(dispatcher&&) = delete;
+
+	~dispatcher();
+
+	/**
+	 * @brief Add waitable.
+	 * @param w - waitable to add.
+	 * @param wait_for - readiness flags to wait for.
+	 * @param handler - handler to call when the waitable triggers.
+	 * @throw std::logic_error - in case the waitable is already added.
+	 */
+	void add(waitable& w, utki::flags<ready> wait_for, handler_type handler);
+
+	/**
+	 * @brief Add rate limited waitable.
+	 * The bucket is full initially.
+	 * @param w - waitable to add.
+	 * @param wait_for - readiness flags to wait for.
+	 * @param handler - handler to call when the waitable triggers.
+	 * @param limit - rate limit of the handler calls.
+	 * @throw std::logic_error - in case the waitable is already added.
+	 * @throw std::invalid_argument - in case the rate is not positive or the burst is less than 1.
+	 */
+	void add(waitable& w, utki::flags<ready> wait_for, handler_type handler, rate_limit limit);
+
+	/**
+	 * @brief Change wait flags of the waitable.
+	 * In case the waitable is muted, the new flags are applied when it is unmuted.
+	 * @param w - added waitable.
+	 * @param wait_for - new readiness flags to wait for.
+	 * @throw std::logic_error - in case the waitable is not added.
+	 */
+	void change(waitable& w, utki::flags<ready> wait_for);
+
+	/**
+	 * @brief Remove waitable.
+	 * After removal the handler is not called anymore, even if the waitable is in the ready queue.
+	 * @param w - added waitable.
+	 * @throw std::logic_error - in case the waitable is not added.
+	 */
+	void remove(waitable& w);
+
+	/**
+	 * @brief Check if the waitable is muted by the rate limit.
+	 * @param w - added waitable.
+	 * @return true if the waitable is muted.
+	 * @throw std::logic_error - in case the waitable is not added.
+	 */
+	bool is_muted(const waitable& w);
+
+	/**
+	 * @brief Set deadline for handling events of the waitable.
+	 * When the waitable triggers, its handler is due within the given time from the moment
+	 * the dispatcher notices the event.
+	 * @param w - added waitable.
+	 * @param deadline - relative deadline, clock::duration::max() means no deadline.
+	 * @throw std::logic_error - in case the waitable is not added.
+	 */
+	void set_deadline(const waitable& w, clock::duration deadline);
+
+	/**
+	 * @brief Post work item.
+	 * The work item is called from run_once() in deadline order together with the handlers
+	 * of the triggered waitables, and counts towards the handler calls per iteration.
+	 * @param work - work item to call.
+	 * @param deadline - time point by which the work item is due,
+	 *                   clock::time_point::max() means no deadline.
+	 */
+	void post(work_type work, clock::time_point deadline = clock::time_point::max());
+
+	/**
+	 * @brief Get number of handlers called after their deadline.
+	 * @return number of missed deadlines since the dispatcher was created.
+	 */
+	size_t get_num_missed_deadlines() const noexcept
+	{
+		return this->num_missed_deadlines;
+	}
+
+	/**
+	 * @brief Get number of entries in the ready queue.
+	 * @return number of triggered waitables and posted work items which are not yet called.
+	 */
+	size_t get_num_queued() const noexcept
+	{
+		return this->ready_queue.size();
+	}
+
+	/**
+	 * @brief Run one iteration of the loop.
+	 * Waits for events, unless the ready queue is not empty, and calls the handlers.
+	 * The wait timeout is cut to the nearest time a muted waitable is unmuted.
+	 * @return number of handlers called.
+	 */
+	size_t run_once()
+	{
+		return this->run_once_internal(true, 0);
+	}
+
+	/**
+	 * @brief Run one iteration of the loop with timeout.
+	 * @param timeout - maximum time in milliseconds to wait for events.
+	 * @return number of handlers called.
+	 */
+	size_t run_once(uint32_t timeout)
+	{
+		return this->run_once_internal(false, timeout);
+	}
+
+	/**
+	 * @brief Interrupt waiting.
+	 * Makes the currently blocked, or the next, run_once() return.
+	 * Thread-safe.
+	 */
+	void interrupt() noexcept
+	{
+		this->ws.interrupt();
+	}
+};
+
+} // namespace opros
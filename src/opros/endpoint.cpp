@@ -0,0 +1,106 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "endpoint.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <array>
+#	include <cstring>
+#	include <stdexcept>
+
+#	include <arpa/inet.h>
+#	include <netinet/in.h>
+
+using namespace opros;
+
+endpoint::endpoint(const char* ip, uint16_t port)
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	auto& v4 = reinterpret_cast<sockaddr_in&>(this->storage);
+	if (inet_pton(AF_INET, ip, &v4.sin_addr) == 1) {
+		v4.sin_family = AF_INET;
+		v4.sin_port = htons(port);
+		this->length = sizeof(sockaddr_in);
+		return;
+	}
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	auto& v6 = reinterpret_cast<sockaddr_in6&>(this->storage);
+	if (inet_pton(AF_INET6, ip, &v6.sin6_addr) == 1) {
+		v6.sin6_family = AF_INET6;
+		v6.sin6_port = htons(port);
+		this->length = sizeof(sockaddr_in6);
+		return;
+	}
+
+	throw std::invalid_argument(std::string("endpoint::endpoint(): could not parse IP address: ") + ip);
+}
+
+uint16_t endpoint::get_port() const noexcept
+{
+	switch (this->get_family()) {
+		case AF_INET:
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			return ntohs(reinterpret_cast<const sockaddr_in&>(this->storage).sin_port);
+		case AF_INET6:
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			return ntohs(reinterpret_cast<const sockaddr_in6&>(this->storage).sin6_port);
+		default:
+			return 0;
+	}
+}
+
+std::string endpoint::get_ip() const
+{
+	std::array<char, INET6_ADDRSTRLEN> buf{};
+
+	const void* addr = nullptr;
+	switch (this->get_family()) {
+		case AF_INET:
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			addr = &reinterpret_cast<const sockaddr_in&>(this->storage).sin_addr;
+			break;
+		case AF_INET6:
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			addr = &reinterpret_cast<const sockaddr_in6&>(this->storage).sin6_addr;
+			break;
+		default:
+			return {};
+	}
+
+	if (!inet_ntop(this->get_family(), addr, buf.data(), socklen_t(buf.size()))) {
+		return {};
+	}
+	return buf.data();
+}
+
+bool endpoint::operator==(const endpoint& e) const noexcept
+{
+	return this->length == e.length && std::memcmp(&this->storage, &e.storage, this->length) == 0;
+}
+
+#endif
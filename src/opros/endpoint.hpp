@@ -0,0 +1,143 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <cstdint>
+#	include <string>
+
+#	include <sys/socket.h>
+
+namespace opros {
+
+/**
+ * @brief IP socket address.
+ * IPv4 or IPv6 address and port.
+ */
+class endpoint
+{
+	sockaddr_storage storage{};
+	socklen_t length = 0;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Creates invalid endpoint, with zero length address.
+	 */
+	endpoint() = default;
+
+	/**
+	 * @brief Constructor.
+	 * @param ip - IPv4 address in dotted decimal notation, e.g. "127.0.0.1", or IPv6 address, e.g. "::1".
+	 * @param port - port number.
+	 * @throw std::invalid_argument - in case the IP address could not be parsed.
+	 */
+	endpoint(const char* ip, uint16_t port);
+
+	/**
+	 * @brief Get socket address.
+	 * @return pointer to the socket address.
+	 */
+	const sockaddr* get_sockaddr() const noexcept
+	{
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return reinterpret_cast<const sockaddr*>(&this->storage);
+	}
+
+	/**
+	 * @brief Get socket address.
+	 * Can be used to fill in the address by system calls, along with set_size().
+	 * @return pointer to the socket address storage.
+	 */
+	sockaddr* get_sockaddr() noexcept
+	{
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return reinterpret_cast<sockaddr*>(&this->storage);
+	}
+
+	/**
+	 * @brief Get size of the socket address.
+	 * @return size of the socket address in bytes.
+	 */
+	socklen_t size() const noexcept
+	{
+		return this->length;
+	}
+
+	/**
+	 * @brief Get capacity of the socket address storage.
+	 * @return size of the socket address storage in bytes.
+	 */
+	static socklen_t capacity() noexcept
+	{
+		return sizeof(sockaddr_storage);
+	}
+
+	/**
+	 * @brief Set size of the socket address.
+	 * @param size - size of the socket address in bytes, as returned by system call.
+	 */
+	void set_size(socklen_t size) noexcept
+	{
+		this->length = size;
+	}
+
+	/**
+	 * @brief Get address family.
+	 * @return AF_INET or AF_INET6.
+	 */
+	int get_family() const noexcept
+	{
+		return this->storage.ss_family;
+	}
+
+	/**
+	 * @brief Get port.
+	 * @return port number.
+	 */
+	uint16_t get_port() const noexcept;
+
+	/**
+	 * @brief Convert IP address to string.
+	 * @return IP address in text form, without port.
+	 */
+	std::string get_ip() const;
+
+	bool operator==(const endpoint& e) const noexcept;
+
+	bool operator!=(const endpoint& e) const noexcept
+	{
+		return !this->operator==(e);
+	}
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,343 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "epoll_backend.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <limits>
+#	include <system_error>
+
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+
+namespace opros {
+
+namespace {
+OPROS_INLINE uint32_t to_epoll_events(utki::flags<ready> wait_for)
+{
+	// NOTE: EPOLLHUP is always reported, no need to request it
+	return (wait_for.get(ready::read) ? (unsigned(EPOLLIN) | unsigned(EPOLLRDHUP)) : 0) |
+		(wait_for.get(ready::priority) ? unsigned(EPOLLPRI) : 0) | (wait_for.get(ready::write) ? unsigned(EPOLLOUT) : 0) |
+		(EPOLLERR);
+}
+
+// creates epoll set with the interrupt eventfd added to it
+OPROS_INLINE int create_epoll_set(int interrupt_fd, void* interrupt_data)
+{
+	int epoll_set = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_set < 0) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): epoll_create1() failed");
+	}
+
+	epoll_event e{};
+	e.data.ptr = interrupt_data;
+	e.events = EPOLLIN;
+	if (epoll_ctl(epoll_set, EPOLL_CTL_ADD, interrupt_fd, &e) < 0) {
+		auto err = errno;
+		close(epoll_set);
+		throw std::system_error(err, std::generic_category(), "wait_set::wait_set(): epoll_ctl() failed");
+	}
+
+	return epoll_set;
+}
+} // namespace
+
+OPROS_INLINE epoll_backend::epoll_backend(unsigned capacity, int interrupt_fd) :
+	interrupt_fd(interrupt_fd),
+	owns_interrupt_fd(interrupt_fd < 0),
+	revents(size_t(capacity) + 1) // one extra slot for interrupt eventfd
+{
+	if (capacity >= unsigned(std::numeric_limits<int>::max())) {
+		throw std::invalid_argument("wait_set(): given capacity is too big, should be < INT_MAX");
+	}
+	utki::assert(int(capacity) > 0, SL);
+
+	if (this->owns_interrupt_fd) {
+		this->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (this->interrupt_fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): eventfd() failed");
+		}
+	}
+
+	try {
+		this->epoll_set = create_epoll_set(this->interrupt_fd, &this->interrupt_fd);
+	} catch (...) {
+		if (this->owns_interrupt_fd) {
+			close(this->interrupt_fd);
+		}
+		throw;
+	}
+}
+
+OPROS_INLINE epoll_backend::~epoll_backend()
+{
+	if (this->owns_interrupt_fd) {
+		close(this->interrupt_fd);
+	}
+	close(this->epoll_set);
+}
+
+OPROS_INLINE void epoll_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	auto handle = get_handle(w);
+
+	// NOTE: insert interest before doing the system call, so that in case insertion
+	// throws there would be no need to revert the system call
+	this->interests.insert(handle, {wait_for, user_data});
+
+	epoll_event e{};
+	e.data.ptr = user_data;
+	e.events = to_epoll_events(wait_for);
+	int res = epoll_ctl(this->epoll_set, EPOLL_CTL_ADD, handle, &e);
+	if (res < 0) {
+		auto err = errno;
+		this->interests.erase(handle);
+		utki::log_debug([&](auto& o) {
+			o << "wait_set::add(): epoll_ctl() failed. If you are adding socket, "
+				 "please check that is is opened before adding to wait_set."
+			  << std::endl;
+		});
+		throw std::system_error(err, std::generic_category(), "wait_set::add(): epoll_ctl() failed");
+	}
+}
+
+OPROS_INLINE void epoll_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	// the change is applied to the kernel in the beginning of the next wait()
+	this->interests.request(get_handle(w), {wait_for, user_data});
+}
+
+OPROS_INLINE void* epoll_backend::remove(waitable& w) noexcept
+{
+	auto handle = get_handle(w);
+
+	auto i = this->interests.find(handle);
+	if (!i) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::remove(): waitable is not added to wait set";
+			},
+			SL
+		);
+		return nullptr;
+	}
+	void* user_data = i->requested.user_data;
+
+	int res = epoll_ctl(this->epoll_set, EPOLL_CTL_DEL, handle, nullptr);
+	if (res < 0) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::Remove(): epoll_ctl failed, probably the waitable was "
+					 "not added to the wait set";
+			},
+			SL
+		);
+	}
+
+	this->interests.erase(handle);
+
+	return user_data;
+}
+
+OPROS_INLINE void epoll_backend::clear()
+{
+	// closing the epoll set drops all the registrations with a single system call,
+	// the interrupt eventfd is added to the new epoll set, so pending interrupt is kept
+	int new_epoll_set = create_epoll_set(this->interrupt_fd, &this->interrupt_fd);
+
+	close(this->epoll_set);
+	this->epoll_set = new_epoll_set;
+
+	this->interests.clear();
+}
+
+OPROS_INLINE void epoll_backend::interrupt() noexcept
+{
+	// eventfd_write() is just a write() to the eventfd, so it is async-signal-safe
+	if (eventfd_write(this->interrupt_fd, 1) < 0) {
+		utki::assert(false, SL);
+	}
+}
+
+OPROS_INLINE bool epoll_backend::reset() noexcept
+{
+	utki::assert(this->interests.size() == 0, SL);
+
+	// drop pending interrupt
+	eventfd_t value = 0;
+	if (eventfd_read(this->interrupt_fd, &value) < 0) {
+		utki::assert(errno == EAGAIN, SL);
+	}
+
+	return true;
+}
+
+OPROS_INLINE void epoll_backend::apply_pending_changes()
+{
+	this->interests.apply_pending_changes([this](int handle, const auto& requested, const auto&) {
+		epoll_event e{};
+		e.data.ptr = requested.user_data;
+		e.events = to_epoll_events(requested.wait_for);
+		int res = epoll_ctl(this->epoll_set, EPOLL_CTL_MOD, handle, &e);
+		if (res < 0) {
+			throw std::system_error(errno, std::generic_category(), "wait_set::change(): epoll_ctl() failed");
+		}
+	});
+}
+
+OPROS_INLINE backend::wait_result epoll_backend::wait_internal(int timeout, utki::span<event_info> out_events)
+{
+	// TRACE(<< "going to epoll_wait() with timeout = " << timeout << std::endl)
+
+	int num_events_triggered{};
+
+	while (true) {
+		utki::assert(this->revents.size() <= std::numeric_limits<int>::max(), SL);
+		num_events_triggered = epoll_wait(this->epoll_set, this->revents.data(), int(this->revents.size()), timeout);
+
+		// TRACE(<< "epoll_wait() returned " << num_events_triggered << std::endl)
+
+		if (num_events_triggered < 0) {
+			// if interrupted by signal, try waiting again.
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "wait_set::wait(): epoll_wait() failed");
+		}
+		break;
+	};
+
+	wait_result ret;
+
+	if (num_events_triggered == 0) {
+		// timeout hit
+		ret.timed_out = true;
+		return ret;
+	}
+
+	utki::assert(num_events_triggered > 0, SL);
+	utki::assert(this->revents.size() == out_events.size() + 1, SL);
+	utki::assert(size_t(num_events_triggered) <= this->revents.size(), SL);
+
+	size_t out_i = 0;
+	for (const auto& e : utki::make_span(this->revents.data(), num_events_triggered)) {
+		if (e.data.ptr == &this->interrupt_fd) {
+			// reset the eventfd counter, so that all interrupts issued so far are coalesced into one
+			eventfd_t value = 0;
+			if (eventfd_read(this->interrupt_fd, &value) < 0) {
+				// the eventfd is non-blocking, so EAGAIN means there was a race with
+				// another reader, which cannot happen, so ignore the failure
+				utki::assert(errno == EAGAIN, SL);
+			}
+			ret.interrupted = true;
+			continue;
+		}
+
+		if (out_i == out_events.size()) {
+			// more waitables than the capacity are added and all the slots were taken by them,
+			// the event is level-triggered, so it will be reported again by the next wait
+			continue;
+		}
+
+		utki::assert(out_i < out_events.size(), SL);
+		event_info& ei = out_events[out_i];
+		++out_i;
+
+		ei.flags.clear();
+		ei.user_data = e.data.ptr;
+
+		if ((e.events & EPOLLERR) != 0) {
+			ei.flags.set(ready::error);
+		}
+		if ((e.events & EPOLLHUP) != 0) {
+			ei.flags.set(ready::hangup);
+		}
+		if ((e.events & EPOLLIN) != 0) {
+			ei.flags.set(ready::read);
+		}
+		if ((e.events & EPOLLRDHUP) != 0) {
+			ei.flags.set(ready::read_hangup);
+		}
+		if ((e.events & EPOLLPRI) != 0) {
+			ei.flags.set(ready::priority);
+		}
+		if ((e.events & EPOLLOUT) != 0) {
+			ei.flags.set(ready::write);
+		}
+
+		utki::assert(!ei.flags.is_clear(), SL);
+	}
+
+	utki::assert(out_i <= out_events.size(), SL);
+	utki::assert(out_i + (ret.interrupted ? 1 : 0) <= size_t(num_events_triggered), SL);
+	ret.num_events = out_i;
+
+	return ret;
+}
+
+OPROS_INLINE backend::wait_result epoll_backend::wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events)
+{
+	this->apply_pending_changes();
+
+	if (infinite) {
+		return this->wait_internal(-1, out_events);
+	}
+
+	// in linux, epoll_wait() gets timeout as int argument, while we have timeout
+	// as uint32_t, so the requested timeout can be bigger than int can hold
+	// (negative values of the int are not used)
+
+	auto max_time_step = uint32_t(std::numeric_limits<int>::max());
+
+	while (timeout >= max_time_step) {
+		utki::assert(
+			int(max_time_step) >= 0,
+			[&](auto& o) {
+				o << "timeout = 0x" << std::hex << timeout;
+			},
+			SL
+		);
+		auto res = this->wait_internal(int(max_time_step), out_events);
+		if (!res.timed_out) {
+			return res;
+		}
+		timeout -= max_time_step;
+		if (timeout == 0) {
+			// timeout hit
+			return res;
+		}
+	}
+
+	utki::assert(int(timeout) >= 0, SL);
+	return this->wait_internal(int(timeout), out_events);
+}
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,92 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <vector>
+
+#	include <sys/epoll.h>
+
+#	include "backend.hpp"
+#	include "interest_table.hpp"
+
+namespace opros {
+
+/**
+ * @brief Linux epoll based backend.
+ */
+class epoll_backend final : public backend
+{
+	int epoll_set;
+
+	int interrupt_fd; // eventfd used by interrupt()
+	bool owns_interrupt_fd;
+
+	std::vector<epoll_event> revents; // used for getting the result from epoll_wait()
+
+	interest_table interests;
+
+	void apply_pending_changes();
+
+	wait_result wait_internal(int timeout, utki::span<event_info> out_events);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables.
+	 * @param interrupt_fd - eventfd to be used by interrupt(), -1 to create a new one.
+	 *                       The given eventfd is not closed by the backend.
+	 */
+	epoll_backend(unsigned capacity, int interrupt_fd = -1);
+
+	epoll_backend(const epoll_backend&) = delete;
+	epoll_backend& operator=(const epoll_backend&) = delete;
+
+	epoll_backend(epoll_backend&&) = delete;
+	epoll_backend& operator=(epoll_backend&&) = delete;
+
+	~epoll_backend() override;
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
+
+#ifdef OPROS_HEADER_ONLY
+#	include "epoll_backend.cpp"
+#endif
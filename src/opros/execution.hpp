@@ -0,0 +1,514 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+// std::execution (P2300) integration, available when stdexec library is present and compiling as C++20 or later
+#if __has_include(<stdexec/execution.hpp>) && __cplusplus >= 202002L
+
+#	include <atomic>
+#	include <exception>
+#	include <mutex>
+#	include <optional>
+#	include <thread>
+#	include <utility>
+
+#	include <stdexec/execution.hpp>
+
+#	include "wait_set.hpp"
+
+namespace opros {
+
+/**
+ * @brief Execution context for std::execution senders.
+ * Runs a wait_set loop in the thread which calls run(). Senders obtained from the context's scheduler
+ * complete on that thread: schedule() sender completes on the next loop iteration and async_wait() sender
+ * completes when the waitable becomes ready.
+ * Operation states are intrusive, they are linked into the context's queue and used as user data
+ * for the wait_set, so starting an operation does not allocate.
+ * Operations can be started from any thread.
+ * Started operations are cancelled through the receiver's stop token: the operation is taken out of
+ * the context's queue or wait_set on the loop thread and completes as stopped.
+ */
+class execution_context
+{
+public:
+	/**
+	 * @brief Base of operation states.
+	 * Not to be used directly.
+	 */
+	struct operation_base {
+		enum class result {
+			value,
+			error,
+			stopped
+		};
+
+		using completion_function_type = void (*)(operation_base& op, result r) noexcept;
+
+		const completion_function_type complete;
+
+		// waitable to wait for, nullptr for schedule() operation
+		waitable* const w;
+		const utki::flags<ready> wait_for;
+
+		// readiness flags of the triggered waitable
+		utki::flags<ready> flags = false;
+
+		std::exception_ptr error;
+
+		// set by the stop callback, possibly from another thread
+		std::atomic<bool> stop_requested = false;
+
+		// links in the queue of started operations or in the list of waiting operations
+		operation_base* next = nullptr;
+		operation_base* prev = nullptr;
+
+		operation_base(completion_function_type complete, waitable* w, utki::flags<ready> wait_for) noexcept :
+			complete(complete),
+			w(w),
+			wait_for(wait_for)
+		{}
+
+		operation_base(const operation_base&) = delete;
+		operation_base& operator=(const operation_base&) = delete;
+
+		operation_base(operation_base&&) = delete;
+		operation_base& operator=(operation_base&&) = delete;
+
+		~operation_base() = default;
+	};
+
+private:
+	opros::wait_set ws;
+
+	std::mutex mutex;
+
+	// started operations which are not yet processed by the loop
+	operation_base* queue_head = nullptr;
+	operation_base* queue_tail = nullptr;
+
+	// operations added to the wait_set, accessed only from the loop thread
+	operation_base* waiting_head = nullptr;
+
+	bool finishing = false;
+
+	// some operations have stop requested
+	std::atomic<bool> stop_pending = false;
+
+	std::atomic<std::thread::id> loop_thread;
+
+	operation_base* take_queue() noexcept
+	{
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		auto ret = this->queue_head;
+		this->queue_head = nullptr;
+		this->queue_tail = nullptr;
+		return ret;
+	}
+
+	void process_queue(operation_base* op) noexcept
+	{
+		while (op) {
+			// the operation state can be destroyed by completion, so take the next one beforehand
+			auto next = op->next;
+			op->next = nullptr;
+
+			if (op->stop_requested.load()) {
+				op->complete(*op, operation_base::result::stopped);
+			} else if (!op->w) {
+				op->complete(*op, operation_base::result::value);
+			} else {
+				try {
+					this->ws.add(*op->w, op->wait_for, op);
+				} catch (...) {
+					op->error = std::current_exception();
+					op->complete(*op, operation_base::result::error);
+					op = next;
+					continue;
+				}
+				op->next = this->waiting_head;
+				if (this->waiting_head) {
+					this->waiting_head->prev = op;
+				}
+				this->waiting_head = op;
+			}
+
+			op = next;
+		}
+	}
+
+	void remove_waiting(operation_base& op) noexcept
+	{
+		this->ws.remove(*op.w);
+
+		if (op.prev) {
+			op.prev->next = op.next;
+		} else {
+			this->waiting_head = op.next;
+		}
+		if (op.next) {
+			op.next->prev = op.prev;
+		}
+		op.next = nullptr;
+		op.prev = nullptr;
+	}
+
+	void complete_stopped_waiting() noexcept
+	{
+		for (auto op = this->waiting_head; op;) {
+			// the operation state can be destroyed by completion, so take the next one beforehand
+			auto next = op->next;
+			if (op->stop_requested.load()) {
+				this->remove_waiting(*op);
+				op->complete(*op, operation_base::result::stopped);
+			}
+			op = next;
+		}
+	}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - capacity of the context's wait_set, i.e. expected maximum number of
+	 *                   simultaneously waited waitables.
+	 */
+	execution_context(unsigned capacity) :
+		ws(capacity)
+	{}
+
+	execution_context(const execution_context&) = delete;
+	execution_context& operator=(const execution_context&) = delete;
+
+	execution_context(execution_context&&) = delete;
+	execution_context& operator=(execution_context&&) = delete;
+
+	~execution_context() = default;
+
+	/**
+	 * @brief Enqueue started operation.
+	 * Not to be used directly, called by operation states.
+	 * @param op - operation to enqueue.
+	 */
+	void enqueue(operation_base& op) noexcept
+	{
+		{
+			std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+			if (this->queue_tail) {
+				this->queue_tail->next = &op;
+			} else {
+				this->queue_head = &op;
+			}
+			this->queue_tail = &op;
+		}
+
+		// the loop processes the queue before waiting, so no need to wake it up from its own thread
+		if (std::this_thread::get_id() != this->loop_thread.load(std::memory_order_relaxed)) {
+			this->ws.interrupt();
+		}
+	}
+
+	/**
+	 * @brief Request stop of started operation.
+	 * Not to be used directly, called by stop callbacks of operation states.
+	 * Thread-safe.
+	 * @param op - operation to stop.
+	 */
+	void request_stop(operation_base& op) noexcept
+	{
+		op.stop_requested.store(true);
+		this->stop_pending.store(true);
+		this->ws.interrupt();
+	}
+
+	/**
+	 * @brief Run the loop.
+	 * Processes the operations until finish() is called. After that, the operations which are already
+	 * started are processed, and the operations waiting for waitables are completed as stopped.
+	 */
+	void run()
+	{
+		this->loop_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+		while (true) {
+			this->process_queue(this->take_queue());
+
+			bool queue_empty = false;
+			{
+				std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+				if (this->finishing && !this->queue_head) {
+					break;
+				}
+				queue_empty = !this->queue_head;
+			}
+
+			if (queue_empty) {
+				this->ws.wait();
+			} else {
+				// operations were started by completions, process them without blocking
+				this->ws.wait(0);
+			}
+
+			for (const auto& e : this->ws.get_triggered()) {
+				auto& op = *static_cast<operation_base*>(e.user_data);
+				this->remove_waiting(op);
+				op.flags = e.flags;
+				op.complete(op, operation_base::result::value);
+			}
+
+			// the triggered operations are completed already, so the remaining ones are still waiting
+			if (this->stop_pending.exchange(false)) {
+				this->complete_stopped_waiting();
+			}
+		}
+
+		// complete all operations which are still waiting
+		while (this->waiting_head) {
+			auto& op = *this->waiting_head;
+			this->remove_waiting(op);
+			op.complete(op, operation_base::result::stopped);
+		}
+
+		this->loop_thread.store(std::thread::id(), std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Request the loop to finish.
+	 * Thread-safe.
+	 */
+	void finish() noexcept
+	{
+		{
+			std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+			this->finishing = true;
+		}
+		this->ws.interrupt();
+	}
+
+	class scheduler;
+
+	/**
+	 * @brief Get scheduler of the context.
+	 * @return Scheduler.
+	 */
+	scheduler get_scheduler() noexcept;
+};
+
+/**
+ * @brief Scheduler of the execution_context.
+ * Satisfies std::execution scheduler concept.
+ */
+class execution_context::scheduler
+{
+	execution_context* context;
+
+	template <typename receiver_type, bool is_wait>
+	class operation : private operation_base
+	{
+		execution_context& context;
+		receiver_type receiver;
+
+		using stop_token_type = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_type>>;
+
+		struct stop_request {
+			operation* op;
+
+			void operator()() const noexcept
+			{
+				this->op->context.request_stop(*this->op);
+			}
+		};
+
+		std::optional<stdexec::stop_callback_for_t<stop_token_type, stop_request>> stop_callback;
+
+		static void complete_operation(operation_base& base, result r) noexcept
+		{
+			auto& op = static_cast<operation&>(base);
+
+			// waits for the stop callback in case it is being run by another thread at the moment
+			op.stop_callback.reset();
+
+			switch (r) {
+				case result::value:
+					if constexpr (is_wait) {
+						stdexec::set_value(std::move(op.receiver), op.flags);
+					} else {
+						stdexec::set_value(std::move(op.receiver));
+					}
+					break;
+				case result::error:
+					stdexec::set_error(std::move(op.receiver), std::move(op.error));
+					break;
+				case result::stopped:
+					stdexec::set_stopped(std::move(op.receiver));
+					break;
+			}
+		}
+
+	public:
+		using operation_state_concept = stdexec::operation_state_t;
+
+		operation(
+			execution_context& context,
+			receiver_type&& receiver,
+			waitable* w,
+			utki::flags<ready> wait_for
+		) :
+			operation_base(&complete_operation, w, wait_for),
+			context(context),
+			receiver(std::move(receiver))
+		{}
+
+		void start() & noexcept
+		{
+			auto token = stdexec::get_stop_token(stdexec::get_env(this->receiver));
+			if (token.stop_requested()) {
+				stdexec::set_stopped(std::move(this->receiver));
+				return;
+			}
+
+			// in case stop is requested before the operation is enqueued,
+			// it is noticed when the loop processes the queue
+			this->stop_callback.emplace(std::move(token), stop_request{this});
+
+			this->context.enqueue(*this);
+		}
+	};
+
+	struct env {
+		execution_context* context;
+
+		template <typename tag_type>
+		scheduler query(stdexec::get_completion_scheduler_t<tag_type>) const noexcept
+		{
+			return scheduler(this->context);
+		}
+	};
+
+public:
+	/**
+	 * @brief Sender of schedule() operation.
+	 * Completes with no values on the context's loop thread.
+	 */
+	class schedule_sender
+	{
+		execution_context* context;
+
+	public:
+		using sender_concept = stdexec::sender_t;
+		using completion_signatures = stdexec::completion_signatures<
+			stdexec::set_value_t(),
+			stdexec::set_error_t(std::exception_ptr),
+			stdexec::set_stopped_t()>;
+
+		explicit schedule_sender(execution_context* context) noexcept :
+			context(context)
+		{}
+
+		template <typename receiver_type>
+		operation<receiver_type, false> connect(receiver_type receiver) const
+		{
+			return operation<receiver_type, false>(*this->context, std::move(receiver), nullptr, false);
+		}
+
+		env get_env() const noexcept
+		{
+			return {this->context};
+		}
+	};
+
+	/**
+	 * @brief Sender of async_wait() operation.
+	 * Completes with readiness flags of the waitable on the context's loop thread.
+	 */
+	class wait_sender
+	{
+		execution_context* context;
+		waitable* w;
+		utki::flags<ready> wait_for;
+
+	public:
+		using sender_concept = stdexec::sender_t;
+		using completion_signatures = stdexec::completion_signatures<
+			stdexec::set_value_t(utki::flags<ready>),
+			stdexec::set_error_t(std::exception_ptr),
+			stdexec::set_stopped_t()>;
+
+		wait_sender(execution_context* context, waitable& w, utki::flags<ready> wait_for) noexcept :
+			context(context),
+			w(&w),
+			wait_for(wait_for)
+		{}
+
+		template <typename receiver_type>
+		operation<receiver_type, true> connect(receiver_type receiver) const
+		{
+			return operation<receiver_type, true>(*this->context, std::move(receiver), this->w, this->wait_for);
+		}
+
+		env get_env() const noexcept
+		{
+			return {this->context};
+		}
+	};
+
+	explicit scheduler(execution_context* context) noexcept :
+		context(context)
+	{}
+
+	/**
+	 * @brief Schedule work on the context's loop thread.
+	 * @return Sender which completes on the context's loop thread.
+	 */
+	schedule_sender schedule() const noexcept
+	{
+		return schedule_sender(this->context);
+	}
+
+	/**
+	 * @brief Wait for the waitable to become ready.
+	 * The waitable is added to the context's wait_set when the operation is started and removed
+	 * when it triggers. The same waitable must not be waited by several operations at a time.
+	 * @param w - waitable to wait for. Must outlive the operation.
+	 * @param wait_for - readiness flags to wait for.
+	 * @return Sender which completes with readiness flags of the waitable.
+	 */
+	wait_sender async_wait(waitable& w, utki::flags<ready> wait_for) const noexcept
+	{
+		return wait_sender(this->context, w, wait_for);
+	}
+
+	bool operator==(const scheduler&) const noexcept = default;
+};
+
+inline execution_context::scheduler execution_context::get_scheduler() noexcept
+{
+	return scheduler(this);
+}
+
+} // namespace opros
+
+#endif
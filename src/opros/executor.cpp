@@ -0,0 +1,413 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "executor.hpp"
+
+#include <algorithm>
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+#	include "concurrent_epoll_backend.hpp"
+#endif
+
+using namespace opros;
+
+namespace {
+// registration whose handler is being called by the current thread
+thread_local void* current_registration = nullptr;
+} // namespace
+
+executor::poller::poller(unsigned capacity) :
+#if CFG_OS == CFG_OS_LINUX
+	ws(capacity, std::make_unique<concurrent_epoll_backend>(capacity, true))
+#else
+	ws(capacity)
+#endif
+{}
+
+executor::executor(unsigned capacity, unsigned num_workers, unsigned num_pollers)
+{
+	if (num_pollers == 0) {
+		throw std::invalid_argument("executor::executor(): number of pollers must be positive");
+	}
+
+	if (num_workers == 0) {
+		num_workers = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	for (unsigned i = 0; i != num_pollers; ++i) {
+		this->pollers.push_back(std::make_unique<poller>(capacity));
+	}
+
+	for (unsigned i = 0; i != num_workers; ++i) {
+		this->workers.push_back(std::make_unique<worker>());
+	}
+
+	try {
+		for (auto& p : this->pollers) {
+			p->thread = std::thread([this, &p = *p]() {
+				this->poller_loop(p);
+			});
+		}
+
+		for (unsigned i = 0; i != num_workers; ++i) {
+			this->workers[i]->thread = std::thread([this, i]() {
+				this->worker_loop(i);
+			});
+		}
+	} catch (...) {
+		this->stop();
+		throw;
+	}
+}
+
+executor::~executor() noexcept
+{
+	this->stop();
+}
+
+void executor::stop() noexcept
+{
+	this->quit.store(true);
+
+	for (auto& p : this->pollers) {
+		p->ws.interrupt();
+	}
+
+	{
+		std::lock_guard<decltype(this->sleep_mutex)> lock(this->sleep_mutex);
+	}
+	this->sleep_cv.notify_all();
+
+	for (auto& p : this->pollers) {
+		if (p->thread.joinable()) {
+			p->thread.join();
+		}
+	}
+
+	for (auto& w : this->workers) {
+		if (w->thread.joinable()) {
+			w->thread.join();
+		}
+	}
+}
+
+void executor::send_command(poller& p, command&& c)
+{
+	{
+		std::lock_guard<decltype(p.commands_mutex)> lock(p.commands_mutex);
+		p.commands.push_back(std::move(c));
+	}
+	p.ws.interrupt();
+}
+
+void executor::add(waitable& w, utki::flags<ready> wait_for, handler_type handler)
+{
+	unsigned poller_index = this->next_poller.fetch_add(1, std::memory_order_relaxed) % this->pollers.size();
+
+	auto reg = std::make_shared<registration>(w, wait_for, std::move(handler), poller_index);
+
+	{
+		std::lock_guard<decltype(this->registrations_mutex)> lock(this->registrations_mutex);
+		if (!this->registrations.try_emplace(&w, reg).second) {
+			throw std::logic_error("executor::add(): the waitable is already added to this executor");
+		}
+	}
+
+	command c{command::type::add, std::move(reg), {}};
+	auto done = c.done.get_future();
+
+	this->send_command(*this->pollers[poller_index], std::move(c));
+
+	try {
+		done.get();
+	} catch (...) {
+		std::lock_guard<decltype(this->registrations_mutex)> lock(this->registrations_mutex);
+		this->registrations.erase(&w);
+		throw;
+	}
+}
+
+void executor::remove(waitable& w)
+{
+	std::shared_ptr<registration> reg;
+
+	{
+		std::lock_guard<decltype(this->registrations_mutex)> lock(this->registrations_mutex);
+		auto i = this->registrations.find(&w);
+		if (i == this->registrations.end()) {
+			throw std::logic_error("executor::remove(): the waitable is not added to this executor");
+		}
+		reg = std::move(i->second);
+		this->registrations.erase(i);
+	}
+
+	command c{command::type::remove, reg, {}};
+	auto done = c.done.get_future();
+
+	this->send_command(*this->pollers[reg->poller_index], std::move(c));
+
+	done.get();
+
+	if (current_registration == reg.get()) {
+		// called from the handler of the waitable being removed
+		return;
+	}
+
+	auto current = static_cast<registration*>(current_registration);
+
+	// wait till the handler finishes in case it is running
+	std::unique_lock<decltype(this->handlers_mutex)> lock(this->handlers_mutex);
+
+	if (current) {
+		// called from the handler of another waitable, check that the handler being waited for
+		// does not wait, directly or through other handlers, for the calling handler to finish
+		for (const registration* r = reg.get(); r; r = r->waiting_for_removal) {
+			if (r == current) {
+				return;
+			}
+		}
+		current->waiting_for_removal = reg.get();
+	}
+
+	this->handlers_cv.wait(lock, [&reg]() {
+		return !reg->running.load();
+	});
+
+	if (current) {
+		current->waiting_for_removal = nullptr;
+	}
+}
+
+void executor::poller_loop(poller& p)
+{
+	while (!this->quit.load()) {
+		p.ws.wait();
+
+		if (this->quit.load()) {
+			break;
+		}
+
+		// NOTE: triggered events have to be dispatched before processing the commands,
+		//       because processing remove command can destroy the registration
+		for (const auto& e : p.ws.get_triggered()) {
+			auto reg = static_cast<registration*>(e.user_data);
+
+#if CFG_OS != CFG_OS_LINUX
+			// take the waitable out of the wait_set until the handler finishes,
+			// so that it is not reported again meanwhile,
+			// on Linux the one-shot registration is disabled by the kernel instead
+			p.ws.remove(reg->w);
+			reg->in_wait_set = false;
+#endif
+
+			this->push_task({reg->shared_from_this(), e.flags});
+		}
+
+		this->process_commands(p);
+	}
+
+	for (auto& reg : p.registrations) {
+		if (reg->in_wait_set) {
+			p.ws.remove(reg->w);
+			reg->in_wait_set = false;
+		}
+	}
+	p.registrations.clear();
+}
+
+void executor::process_commands(poller& p)
+{
+	decltype(p.commands) commands;
+	{
+		std::lock_guard<decltype(p.commands_mutex)> lock(p.commands_mutex);
+		std::swap(commands, p.commands);
+	}
+
+	for (auto& c : commands) {
+		auto& reg = *c.reg;
+		switch (c.t) {
+			case command::type::add:
+				try {
+					p.ws.add(reg.w, reg.wait_for, &reg);
+					reg.in_wait_set = true;
+					p.registrations.insert(c.reg);
+					c.done.set_value();
+				} catch (...) {
+					c.done.set_exception(std::current_exception());
+				}
+				break;
+			case command::type::remove:
+				reg.removed.store(true);
+				if (reg.in_wait_set) {
+					p.ws.remove(reg.w);
+					reg.in_wait_set = false;
+				}
+				p.registrations.erase(c.reg);
+				c.done.set_value();
+				break;
+			case command::type::rearm:
+				if (reg.removed.load()) {
+					break;
+				}
+				try {
+					p.ws.add(reg.w, reg.wait_for, &reg);
+					reg.in_wait_set = true;
+				} catch (...) {
+					// the waitable stays out of the wait_set until removed from the executor,
+					// let the handler know about that
+					this->push_task({std::move(c.reg), utki::flags<ready>{ready::error}, false});
+				}
+				break;
+		}
+	}
+}
+
+void executor::push_task(task&& t)
+{
+	unsigned index = this->next_worker.fetch_add(1, std::memory_order_relaxed) % this->workers.size();
+	auto& w = *this->workers[index];
+
+	{
+		std::lock_guard<decltype(w.tasks_mutex)> lock(w.tasks_mutex);
+		w.tasks.push_back(std::move(t));
+	}
+
+	this->num_tasks.fetch_add(1);
+
+	// NOTE: sleeping worker increments num_sleeping before checking num_tasks,
+	//       so either it sees the new task or we see it sleeping
+	if (this->num_sleeping.load() != 0) {
+		{
+			std::lock_guard<decltype(this->sleep_mutex)> lock(this->sleep_mutex);
+		}
+		this->sleep_cv.notify_one();
+	}
+}
+
+bool executor::pop_task(unsigned index, task& t)
+{
+	// take the oldest task from own deque, so that the waitables are handled in the order they have triggered
+	{
+		auto& w = *this->workers[index];
+		std::lock_guard<decltype(w.tasks_mutex)> lock(w.tasks_mutex);
+		if (!w.tasks.empty()) {
+			t = std::move(w.tasks.front());
+			w.tasks.pop_front();
+			this->num_tasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// steal the most recent task from other workers, so that the owner and the thief
+	// work on the opposite ends of the deque
+	for (size_t i = 1; i != this->workers.size(); ++i) {
+		auto& w = *this->workers[(index + i) % this->workers.size()];
+		std::lock_guard<decltype(w.tasks_mutex)> lock(w.tasks_mutex);
+		if (!w.tasks.empty()) {
+			t = std::move(w.tasks.back());
+			w.tasks.pop_back();
+			this->num_tasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void executor::run_task(task& t) noexcept
+{
+	auto& reg = *t.reg;
+
+	// NOTE: running flag is set before checking removed flag, while remove() sets removed flag before
+	//       checking running flag, so either the handler is not called or remove() waits for it
+	reg.running.store(true);
+
+	if (!reg.removed.load()) {
+		current_registration = &reg;
+		reg.handler(t.flags);
+		current_registration = nullptr;
+
+		// NOTE: the waitable is re-armed while the running flag is still set, so that remove()
+		//       called from other thread does not return before that
+		if (t.rearm && !reg.removed.load()) {
+			this->rearm(t);
+		}
+	}
+
+	reg.running.store(false);
+
+	if (reg.removed.load()) {
+		{
+			std::lock_guard<decltype(this->handlers_mutex)> lock(this->handlers_mutex);
+		}
+		this->handlers_cv.notify_all();
+	}
+}
+
+void executor::rearm(task& t) noexcept
+{
+	auto& reg = *t.reg;
+	auto& p = *this->pollers[reg.poller_index];
+
+#if CFG_OS == CFG_OS_LINUX
+	// the concurrent_epoll_backend allows re-arming the one-shot registration from the worker thread
+	try {
+		p.ws.change(reg.w, reg.wait_for, &reg);
+	} catch (...) {
+		if (reg.removed.load()) {
+			// the waitable has been removed from the wait_set concurrently
+			return;
+		}
+		// the waitable stays disabled until removed from the executor, let the handler know about that
+		this->push_task({t.reg, utki::flags<ready>{ready::error}, false});
+	}
+#else
+	this->send_command(p, {command::type::rearm, t.reg, {}});
+#endif
+}
+
+void executor::worker_loop(unsigned index)
+{
+	task t;
+	while (!this->quit.load()) {
+		if (this->pop_task(index, t)) {
+			this->run_task(t);
+			t.reg.reset();
+			continue;
+		}
+
+		this->num_sleeping.fetch_add(1);
+		{
+			std::unique_lock<decltype(this->sleep_mutex)> lock(this->sleep_mutex);
+			this->sleep_cv.wait(lock, [this]() {
+				return this->quit.load() || this->num_tasks.load() != 0;
+			});
+		}
+		this->num_sleeping.fetch_sub(1);
+	}
+}
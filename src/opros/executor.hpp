@@ -0,0 +1,240 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <utki/spin_lock.hpp>
+
+#include "wait_set.hpp"
+
+namespace opros {
+
+/**
+ * @brief Executor of waitable event handlers.
+ * Executor runs one or more poller threads, each waiting on its own wait_set, and a pool of worker threads.
+ * When a waitable triggers, the poller takes the waitable out of waiting and hands the event
+ * over to one of the workers, where the handler of the waitable is called. After the handler returns,
+ * the waitable is put back to waiting. So, the handler of a single waitable is never called concurrently,
+ * while handlers of different waitables run in parallel.
+ * On Linux the pollers use concurrent_epoll_backend in one-shot mode, so the kernel disables the waitable
+ * when reporting its event and the worker re-arms it right after the handler returns, with a single
+ * epoll_ctl() call and without waking up the poller. On other platforms the poller removes the waitable
+ * from its wait_set and adds it back when requested by the worker.
+ * Each worker has its own task deque. The worker takes tasks from the front of its own deque, i.e. in the
+ * order the waitables have triggered, so that newly triggered waitables do not starve the older ones. When
+ * it runs out of tasks, it steals tasks from the back of other workers' deques. Thus, a slow handler
+ * only delays the tasks queued to the same worker until other workers steal them.
+ */
+class executor
+{
+public:
+	/**
+	 * @brief Type of event handler.
+	 * The handler is called from a worker thread with the readiness flags of the triggered event.
+	 * In case the waitable could not be put back to waiting after the handler has returned,
+	 * the handler is called once more with the ready::error flag set, after which it is not
+	 * called anymore until the waitable is removed from the executor and added again.
+	 * The handler must not throw.
+	 */
+	using handler_type = std::function<void(utki::flags<ready>)>;
+
+private:
+	struct registration : public std::enable_shared_from_this<registration> {
+		waitable& w;
+		const utki::flags<ready> wait_for;
+		const handler_type handler;
+		const unsigned poller_index;
+
+		// set by poller when the waitable is removed from executor
+		std::atomic<bool> removed{false};
+
+		// set by worker when the handler is running
+		std::atomic<bool> running{false};
+
+		// registration whose handler is being removed by the handler of this registration,
+		// accessed under handlers_mutex
+		const registration* waiting_for_removal = nullptr;
+
+		// whether the waitable is currently in the wait_set, accessed only by poller thread
+		bool in_wait_set = false;
+
+		registration(waitable& w, utki::flags<ready> wait_for, handler_type&& handler, unsigned poller_index) :
+			w(w),
+			wait_for(wait_for),
+			handler(std::move(handler)),
+			poller_index(poller_index)
+		{}
+	};
+
+	struct task {
+		std::shared_ptr<registration> reg;
+		utki::flags<ready> flags;
+
+		// whether to put the waitable back to waiting after the handler returns
+		bool rearm = true;
+	};
+
+	struct command {
+		enum class type {
+			add,
+			remove,
+			rearm
+		};
+
+		type t;
+		std::shared_ptr<registration> reg;
+		std::promise<void> done;
+	};
+
+	struct poller {
+		wait_set ws;
+
+		utki::spin_lock commands_mutex;
+		std::vector<command> commands;
+
+		// registrations added to this poller, accessed only by poller thread
+		std::unordered_set<std::shared_ptr<registration>> registrations;
+
+		std::thread thread;
+
+		poller(unsigned capacity);
+	};
+
+	struct worker {
+		utki::spin_lock tasks_mutex;
+		std::deque<task> tasks;
+
+		std::thread thread;
+	};
+
+	std::atomic<bool> quit{false};
+
+	std::vector<std::unique_ptr<poller>> pollers;
+	std::atomic<unsigned> next_poller{0};
+
+	std::vector<std::unique_ptr<worker>> workers;
+	std::atomic<unsigned> next_worker{0};
+
+	// number of tasks in all worker deques
+	std::atomic<size_t> num_tasks{0};
+
+	// number of workers sleeping due to lack of tasks
+	std::atomic<unsigned> num_sleeping{0};
+
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+
+	// used by remove() to wait for the running handler to finish
+	std::mutex handlers_mutex;
+	std::condition_variable handlers_cv;
+
+	std::mutex registrations_mutex;
+	std::unordered_map<const waitable*, std::shared_ptr<registration>> registrations;
+
+	void send_command(poller& p, command&& c);
+
+	void stop() noexcept;
+
+	void poller_loop(poller& p);
+	void process_commands(poller& p);
+
+	void worker_loop(unsigned index);
+	bool pop_task(unsigned index, task& t);
+	void push_task(task&& t);
+	void run_task(task& t) noexcept;
+	void rearm(task& t) noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Starts poller and worker threads.
+	 * @param capacity - maximum number of waitables per poller thread.
+	 * @param num_workers - number of worker threads, 0 means number of hardware threads.
+	 * @param num_pollers - number of poller threads, must be positive.
+	 */
+	executor(unsigned capacity, unsigned num_workers = 0, unsigned num_pollers = 1);
+
+	executor(const executor&) = delete;
+	executor& operator=(const executor&) = delete;
+
+	executor(executor&&) = delete;
+	executor& operator=(executor&&) = delete;
+
+	/**
+	 * @brief Destructor.
+	 * Stops all threads. Tasks which have not started yet are dropped,
+	 * waitables still added to the executor are removed from it.
+	 */
+	~executor() noexcept;
+
+	/**
+	 * @brief Get number of worker threads.
+	 * @return number of worker threads.
+	 */
+	size_t num_workers() const noexcept
+	{
+		return this->workers.size();
+	}
+
+	/**
+	 * @brief Add waitable to the executor.
+	 * Can be called from any thread, including the handlers.
+	 * @param w - waitable to add.
+	 * @param wait_for - readiness flags to wait for.
+	 * @param handler - handler to call when the waitable triggers.
+	 * @throw std::logic_error - in case the waitable is already added to the executor.
+	 */
+	void add(waitable& w, utki::flags<ready> wait_for, handler_type handler);
+
+	/**
+	 * @brief Remove waitable from the executor.
+	 * Can be called from any thread, including the handlers.
+	 * After this function returns the handler of the waitable is not running and will not be called again,
+	 * except when called from the handler of the same waitable, in which case the handler is not
+	 * called again after it returns.
+	 * In case two handlers remove each other's waitables at the same time, waiting for each other
+	 * would deadlock, so such remove() called from the second handler returns without waiting for
+	 * the first handler to finish, which is blocked in its own remove() call at that moment.
+	 * This is also the case for longer cycles of handlers removing each other's waitables.
+	 * @param w - waitable to remove.
+	 * @throw std::logic_error - in case the waitable is not added to the executor.
+	 */
+	void remove(waitable& w);
+};
+
+} // namespace opros
@@ -0,0 +1,161 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "file_watch.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <array>
+#	include <climits>
+#	include <cstring>
+#	include <system_error>
+#	include <utility>
+
+#	include <sys/inotify.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+const std::array<std::pair<file_watch::change, uint32_t>, size_t(file_watch::change::enum_size)> change_masks = {
+	{
+		{file_watch::change::created, IN_CREATE},
+		{file_watch::change::deleted, IN_DELETE},
+		{file_watch::change::modified, IN_MODIFY},
+		{file_watch::change::attributes, IN_ATTRIB},
+		{file_watch::change::closed_write, IN_CLOSE_WRITE},
+		{file_watch::change::moved_from, IN_MOVED_FROM},
+		{file_watch::change::moved_to, IN_MOVED_TO},
+		{file_watch::change::self_deleted, IN_DELETE_SELF},
+		{file_watch::change::self_moved, IN_MOVE_SELF},
+		{file_watch::change::is_directory, IN_ISDIR},
+		{file_watch::change::watch_removed, IN_IGNORED},
+		{file_watch::change::overflow, IN_Q_OVERFLOW},
+	}
+};
+
+int create_inotify()
+{
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "file_watch::file_watch(): inotify_init1() failed");
+	}
+	return fd;
+}
+
+// buffer must be able to hold at least one event with the longest file name
+constexpr const size_t min_buffer_size = sizeof(inotify_event) + NAME_MAX + 1;
+} // namespace
+
+file_watch::file_watch(size_t buffer_size) :
+	waitable(create_inotify()),
+	buffer((std::max(buffer_size, min_buffer_size) + sizeof(decltype(buffer)::value_type) - 1) /
+		   sizeof(decltype(buffer)::value_type))
+{}
+
+file_watch::~file_watch()
+{
+	close(this->handle);
+}
+
+int file_watch::add_watch(const std::string& path, utki::flags<change> changes)
+{
+	uint32_t mask = 0;
+	for (const auto& cm : change_masks) {
+		if (changes.get(cm.first)) {
+			mask |= cm.second;
+		}
+	}
+
+	int wd = inotify_add_watch(this->handle, path.c_str(), mask);
+	if (wd < 0) {
+		throw std::system_error(errno, std::generic_category(), "file_watch::add_watch(): inotify_add_watch() failed");
+	}
+	return wd;
+}
+
+void file_watch::remove_watch(int watch)
+{
+	if (inotify_rm_watch(this->handle, watch) < 0) {
+		throw std::system_error(errno, std::generic_category(), "file_watch::remove_watch(): inotify_rm_watch() failed");
+	}
+}
+
+utki::span<const file_watch::event> file_watch::read_events()
+{
+	this->events.clear();
+
+	ssize_t num_bytes{};
+	while (true) {
+		num_bytes = read(this->handle, this->buffer.data(), this->buffer.size() * sizeof(decltype(buffer)::value_type));
+		if (num_bytes < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN) {
+				// no events queued
+				return this->events;
+			}
+			throw std::system_error(errno, std::generic_category(), "file_watch::read_events(): read() failed");
+		}
+		break;
+	}
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	auto data = reinterpret_cast<const uint8_t*>(this->buffer.data());
+
+	for (size_t offset = 0; offset < size_t(num_bytes);) {
+		utki::assert(offset + sizeof(inotify_event) <= size_t(num_bytes), SL);
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		auto ie = reinterpret_cast<const inotify_event*>(std::next(data, ptrdiff_t(offset)));
+
+		event e{};
+		e.watch = ie->wd;
+		e.cookie = ie->cookie;
+		for (const auto& cm : change_masks) {
+			if ((ie->mask & cm.second) != 0) {
+				e.changes.set(cm.first);
+			}
+		}
+		if (ie->len != 0) {
+			// name is null-terminated and possibly padded with more nulls
+			e.name = std::string_view(
+				static_cast<const char*>(ie->name), //
+				strnlen(static_cast<const char*>(ie->name), ie->len)
+			);
+		}
+
+		this->events.push_back(e);
+
+		offset += sizeof(inotify_event) + ie->len;
+	}
+
+	return this->events;
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <string>
+#	include <string_view>
+#	include <vector>
+
+#	include <utki/flags.hpp>
+#	include <utki/span.hpp>
+
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief File system change notification waitable.
+ * Waitable based on inotify. It becomes ready to read when there are
+ * change events queued for any of the watched files or directories.
+ * Watching a directory reports changes of the files in that directory,
+ * so changes of thousands of files cost only as much as the number of changes.
+ */
+class file_watch final : public waitable
+{
+public:
+	/**
+	 * @brief Kind of change.
+	 */
+	enum class change {
+		/**
+		 * @brief File was created in the watched directory.
+		 */
+		created,
+
+		/**
+		 * @brief File was deleted from the watched directory.
+		 */
+		deleted,
+
+		/**
+		 * @brief File was modified.
+		 */
+		modified,
+
+		/**
+		 * @brief File metadata was changed, e.g. permissions or timestamps.
+		 */
+		attributes,
+
+		/**
+		 * @brief File opened for writing was closed.
+		 */
+		closed_write,
+
+		/**
+		 * @brief File was moved out of the watched directory.
+		 */
+		moved_from,
+
+		/**
+		 * @brief File was moved into the watched directory.
+		 */
+		moved_to,
+
+		/**
+		 * @brief Watched file or directory itself was deleted.
+		 */
+		self_deleted,
+
+		/**
+		 * @brief Watched file or directory itself was moved.
+		 */
+		self_moved,
+
+		/**
+		 * @brief The event is about a directory.
+		 * Only reported, there is no point in requesting it.
+		 */
+		is_directory,
+
+		/**
+		 * @brief The watch was removed, explicitly or because the watched file was deleted.
+		 * Only reported, there is no point in requesting it.
+		 */
+		watch_removed,
+
+		/**
+		 * @brief Event queue has overflown, some events were lost.
+		 * Only reported, there is no point in requesting it.
+		 */
+		overflow,
+
+		enum_size // this must always be the last element of the enum
+	};
+
+	/**
+	 * @brief Change event.
+	 */
+	struct event {
+		/**
+		 * @brief Watch descriptor of the watch the event is about, as returned by add_watch().
+		 * -1 for overflow event.
+		 */
+		int watch;
+
+		/**
+		 * @brief Kind of change.
+		 */
+		utki::flags<change> changes;
+
+		/**
+		 * @brief Cookie connecting moved_from and moved_to events of a single rename.
+		 */
+		uint32_t cookie;
+
+		/**
+		 * @brief Name of the file inside of the watched directory.
+		 * Empty for events about the watched file or directory itself.
+		 * Points into the internal buffer, so it is valid till the next call to read_events().
+		 */
+		std::string_view name;
+	};
+
+private:
+	// buffer for reading raw inotify events, stored as 64-bit words to align the inotify_event structures
+	std::vector<uint64_t> buffer;
+
+	std::vector<event> events;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param buffer_size - size of the buffer for reading the events, in bytes.
+	 *                      Larger buffer allows reading more events with a single system call.
+	 */
+	file_watch(size_t buffer_size = size_t(64) * 1024);
+
+	file_watch(const file_watch&) = delete;
+	file_watch& operator=(const file_watch&) = delete;
+
+	file_watch(file_watch&&) = delete;
+	file_watch& operator=(file_watch&&) = delete;
+
+	~file_watch();
+
+	/**
+	 * @brief Start watching a file or directory.
+	 * Adding a watch for the path which is already watched replaces the changes to watch.
+	 * @param path - path to the file or directory to watch.
+	 * @param changes - changes to watch for.
+	 * @return watch descriptor.
+	 * @throw std::system_error - in case adding the watch has failed.
+	 */
+	int add_watch(const std::string& path, utki::flags<change> changes);
+
+	/**
+	 * @brief Stop watching a file or directory.
+	 * @param watch - watch descriptor returned by add_watch().
+	 * @throw std::system_error - in case removing the watch has failed.
+	 */
+	void remove_watch(int watch);
+
+	/**
+	 * @brief Read queued events.
+	 * Does not block. Reads as many queued events as fit into the buffer with a single
+	 * system call and decodes them. The decoded events are kept in a reused buffer, so
+	 * no memory is allocated once the buffer has grown to the needed size.
+	 * In case not all queued events fit into the buffer the waitable stays ready to read,
+	 * so the rest of the events will be reported by the next wait.
+	 * @return decoded events, valid till the next call to read_events().
+	 * @throw std::system_error - in case reading has failed.
+	 */
+	utki::span<const event> read_events();
+};
+
+} // namespace opros
+
+#endif
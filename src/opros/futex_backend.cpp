@@ -0,0 +1,241 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "futex_backend.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cerrno>
+#	include <chrono>
+#	include <system_error>
+
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex word must be lock-free");
+
+uint32_t* get_futex_word(std::atomic<uint32_t>& a) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return reinterpret_cast<uint32_t*>(&a);
+}
+} // namespace
+
+void futex_event::signal() noexcept
+{
+	if (this->signalled.exchange(true)) {
+		// already signalled, the waiting side is already notified
+		return;
+	}
+
+	std::lock_guard<decltype(this->owner_lock)> lock(this->owner_lock);
+	if (this->owner) {
+		this->owner->notify();
+	}
+}
+
+void futex_backend::notify() noexcept
+{
+	this->sequence.fetch_add(1);
+
+	// the waiting thread checks the sequence after announcing it goes to sleep,
+	// so no wakeup is lost if it is not sleeping yet
+	if (this->sleeping.load()) {
+		syscall(SYS_futex, get_futex_word(this->sequence), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+	}
+}
+
+futex_backend::~futex_backend()
+{
+	// the registered events could be signalled from other threads,
+	// detach them so that they do not notify the destroyed backend
+	try {
+		this->clear();
+	} catch (...) {
+		utki::assert(false, SL);
+	}
+}
+
+futex_backend::registration& futex_backend::get_registration(const waitable& w)
+{
+	auto i = std::find_if(this->registrations.begin(), this->registrations.end(), [&w](const auto& r) {
+		return r.e == &w;
+	});
+	if (i == this->registrations.end()) {
+		throw std::logic_error("futex_backend: waitable is not added");
+	}
+	return *i;
+}
+
+void futex_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	if (get_handle(w) != futex_event::handle_value) {
+		throw std::invalid_argument("futex_backend::add(): waitable is not a futex_event");
+	}
+	auto e = static_cast<futex_event*>(&w);
+
+	{
+		std::lock_guard<decltype(e->owner_lock)> lock(e->owner_lock);
+		if (e->owner) {
+			throw std::logic_error("futex_backend::add(): futex_event is already added to a wait_set");
+		}
+		e->owner = this;
+	}
+
+	this->registrations.push_back(registration{e, wait_for, user_data});
+}
+
+void futex_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	auto& r = this->get_registration(w);
+	r.wait_for = wait_for;
+	r.user_data = user_data;
+}
+
+void* futex_backend::remove(waitable& w) noexcept
+{
+	auto i = std::find_if(this->registrations.begin(), this->registrations.end(), [&w](const auto& r) {
+		return r.e == &w;
+	});
+	utki::assert(i != this->registrations.end(), SL);
+
+	{
+		std::lock_guard<decltype(i->e->owner_lock)> lock(i->e->owner_lock);
+		i->e->owner = nullptr;
+	}
+
+	void* user_data = i->user_data;
+	this->registrations.erase(i);
+	return user_data;
+}
+
+void futex_backend::clear()
+{
+	for (auto& r : this->registrations) {
+		std::lock_guard<decltype(r.e->owner_lock)> lock(r.e->owner_lock);
+		r.e->owner = nullptr;
+	}
+	this->registrations.clear();
+}
+
+size_t futex_backend::collect_events(utki::span<event_info> out_events) noexcept
+{
+	size_t num_events = 0;
+
+	size_t size = this->registrations.size();
+	if (this->scan_start >= size) {
+		this->scan_start = 0;
+	}
+
+	for (size_t n = 0; n != size && num_events != out_events.size(); ++n) {
+		size_t index = (this->scan_start + n) % size;
+		const auto& r = this->registrations[index];
+
+		if (r.wait_for.get(ready::read) && r.e->is_signalled()) {
+			out_events[num_events] = event_info{{ready::read}, r.user_data};
+			++num_events;
+
+			// next scan starts after the last reported event
+			this->scan_start = index + 1;
+		}
+	}
+
+	return num_events;
+}
+
+backend::wait_result futex_backend::wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events)
+{
+	using std::chrono::steady_clock;
+
+	auto deadline = steady_clock::now() + std::chrono::milliseconds(timeout);
+
+	wait_result result;
+
+	for (;;) {
+		// read the sequence before checking the events, so that signalling
+		// which happens after the check changes the sequence and the futex wait returns right away
+		uint32_t seq = this->sequence.load();
+
+		if (this->interrupt_pending.exchange(false)) {
+			result.interrupted = true;
+			return result;
+		}
+
+		result.num_events = this->collect_events(out_events);
+		if (result.num_events != 0) {
+			return result;
+		}
+
+		timespec ts{};
+		if (!infinite) {
+			auto now = steady_clock::now();
+			if (now >= deadline) {
+				result.timed_out = true;
+				return result;
+			}
+			auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+			ts.tv_sec = time_t(left.count() / std::nano::den);
+			ts.tv_nsec = long(left.count() % std::nano::den);
+		}
+
+		this->sleeping.store(true);
+		long res = syscall(
+			SYS_futex,
+			get_futex_word(this->sequence),
+			FUTEX_WAIT_PRIVATE,
+			seq,
+			infinite ? nullptr : &ts,
+			nullptr,
+			0
+		);
+		int error = errno;
+		this->sleeping.store(false);
+
+		if (res != 0 && error != EAGAIN && error != EINTR && error != ETIMEDOUT) {
+			throw std::system_error(error, std::generic_category(), "futex_backend::wait(): futex() failed");
+		}
+	}
+}
+
+void futex_backend::interrupt() noexcept
+{
+	this->interrupt_pending.store(true);
+	this->notify();
+}
+
+bool futex_backend::reset() noexcept
+{
+	this->interrupt_pending.store(false);
+	return true;
+}
+
+#endif
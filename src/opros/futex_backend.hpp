@@ -0,0 +1,180 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <atomic>
+#	include <cstdint>
+#	include <mutex>
+#	include <vector>
+
+#	include <utki/spin_lock.hpp>
+
+#	include "backend.hpp"
+
+namespace opros {
+
+class futex_backend;
+
+/**
+ * @brief In-process event waitable signalled through a futex.
+ * The event does not have any kernel file descriptor, so it can only be added to a wait_set
+ * which uses futex_backend. The event is ready to read while it is signalled.
+ * Signalling the event which is already signalled, or which is waited by a wait_set
+ * which is not blocked at the moment, makes no system calls.
+ * signal(), reset() and is_signalled() are thread-safe.
+ */
+class futex_event : public waitable
+{
+	friend class futex_backend;
+
+	// waitable is not polymorphic on Linux, so futex events are told apart
+	// from other waitables by this handle value, which is not a valid file descriptor
+	constexpr static int handle_value = -2;
+
+	std::atomic<bool> signalled{false};
+
+	// protects the owner, so that the backend is not destroyed while being notified
+	utki::spin_lock owner_lock;
+	futex_backend* owner = nullptr;
+
+public:
+	futex_event() :
+		waitable(handle_value)
+	{}
+
+	futex_event(const futex_event&) = delete;
+	futex_event& operator=(const futex_event&) = delete;
+
+	futex_event(futex_event&&) = delete;
+	futex_event& operator=(futex_event&&) = delete;
+
+	~futex_event() = default;
+
+	/**
+	 * @brief Signal the event.
+	 * Wakes up the wait_set waiting for the event.
+	 */
+	void signal() noexcept;
+
+	/**
+	 * @brief Reset the event to not signalled state.
+	 */
+	void reset() noexcept
+	{
+		this->signalled.store(false);
+	}
+
+	/**
+	 * @brief Check if the event is signalled.
+	 * @return true if the event is signalled.
+	 */
+	bool is_signalled() const noexcept
+	{
+		return this->signalled.load();
+	}
+};
+
+/**
+ * @brief Backend for waiting on in-process futex events.
+ * Instead of writing and reading an eventfd and calling epoll_wait(), the backend sleeps
+ * on a single futex word which is incremented by the registered events when they are signalled
+ * and by interrupt(). So, a cross-thread wakeup costs one FUTEX_WAKE on the signalling side
+ * and one FUTEX_WAIT on the waiting side, and nothing at all when the waiting thread is not asleep.
+ * The readiness of the registered events is checked by scanning them, so the backend is meant
+ * for small sets, like the mailboxes of pipeline stages.
+ * Only futex_event waitables can be added.
+ */
+class futex_backend final : public backend
+{
+	friend class futex_event;
+
+	struct registration {
+		futex_event* e;
+		utki::flags<ready> wait_for;
+		void* user_data;
+	};
+
+	std::vector<registration> registrations;
+
+	// index of the registration to start the next scan from, so that all the ready events
+	// get reported in turn when they do not fit into the wait_set's buffer
+	size_t scan_start = 0;
+
+	// incremented on every signal and interrupt, the waiting thread sleeps on it
+	std::atomic<uint32_t> sequence{0};
+
+	std::atomic<bool> sleeping{false};
+
+	std::atomic<bool> interrupt_pending{false};
+
+	void notify() noexcept;
+
+	registration& get_registration(const waitable& w);
+
+	size_t collect_events(utki::span<event_info> out_events) noexcept;
+
+public:
+	futex_backend() = default;
+
+	futex_backend(const futex_backend&) = delete;
+	futex_backend& operator=(const futex_backend&) = delete;
+
+	futex_backend(futex_backend&&) = delete;
+	futex_backend& operator=(futex_backend&&) = delete;
+
+	~futex_backend() override;
+
+	/**
+	 * @brief Register futex event.
+	 * @param w - futex_event to register.
+	 * @param wait_for - readiness flags to wait for.
+	 * @param user_data - user data to report along with the event.
+	 * @throw std::invalid_argument - in case the waitable is not a futex_event.
+	 * @throw std::logic_error - in case the event is already added to a wait_set.
+	 */
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+
+	void* remove(waitable& w) noexcept override;
+
+	void clear() override;
+
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+
+	void interrupt() noexcept override;
+
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,298 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <utki/flags.hpp>
+
+#include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Interest state cache of file descriptor based backends.
+ * Keeps current interest of every registered handle in a vector indexed by handle,
+ * since file descriptors are small and densely allocated numbers.
+ * Used to skip redundant changes and to defer the changes till the next wait().
+ */
+class interest_table
+{
+public:
+	struct state {
+		utki::flags<ready> wait_for;
+		void* user_data;
+
+		bool operator==(const state& s) const noexcept
+		{
+			return this->wait_for == s.wait_for && this->user_data == s.user_data;
+		}
+
+		bool operator!=(const state& s) const noexcept
+		{
+			return !this->operator==(s);
+		}
+	};
+
+	struct interest {
+		// interest requested by user
+		state requested;
+
+		// interest currently set in the kernel
+		state applied;
+
+		// whether the handle is listed in pending_changes
+		bool pending = false;
+
+		// whether the handle is registered
+		bool present = false;
+	};
+
+private:
+	std::vector<interest> interests;
+
+	size_t num_present = 0;
+
+	// handles which have requested interest different from applied one
+	std::vector<int> pending_changes;
+
+public:
+	size_t size() const noexcept
+	{
+		return this->num_present;
+	}
+
+	/**
+	 * @brief Insert interest of a newly registered handle.
+	 * @param handle - handle to insert.
+	 * @param s - interest state, considered as already applied.
+	 * @throw std::invalid_argument - in case the handle is negative.
+	 * @throw std::logic_error - in case the handle is already in the table.
+	 */
+	void insert(int handle, const state& s)
+	{
+		if (handle < 0) {
+			throw std::invalid_argument("wait_set::add(): invalid handle");
+		}
+
+		auto index = size_t(handle);
+		if (index >= this->interests.size()) {
+			this->interests.resize(index + 1);
+		}
+
+		auto& i = this->interests[index];
+		if (i.present) {
+			throw std::logic_error("wait_set::add(): the waitable is already added to this wait set");
+		}
+		i.requested = s;
+		i.applied = s;
+		i.pending = false;
+		i.present = true;
+		++this->num_present;
+	}
+
+	/**
+	 * @brief Find interest of the handle.
+	 * @param handle - handle to find interest for.
+	 * @return pointer to the interest.
+	 * @return nullptr if the handle is not in the table.
+	 */
+	interest* find(int handle) noexcept
+	{
+		if (handle < 0 || size_t(handle) >= this->interests.size()) {
+			return nullptr;
+		}
+		auto& i = this->interests[size_t(handle)];
+		if (!i.present) {
+			return nullptr;
+		}
+		return &i;
+	}
+
+	const interest* find(int handle) const noexcept
+	{
+		return const_cast<interest_table*>(this)->find(handle);
+	}
+
+	/**
+	 * @brief Remove interest of the handle.
+	 * @param handle - handle to remove.
+	 */
+	void erase(int handle) noexcept
+	{
+		// NOTE: the handle can still be listed in pending_changes, it will be skipped
+		//       when applying the changes since it will not be found among the interests
+		auto i = this->find(handle);
+		if (!i) {
+			return;
+		}
+		i->present = false;
+		i->pending = false;
+		--this->num_present;
+	}
+
+	/**
+	 * @brief Call the given function for every interest.
+	 * @param visit - function called as visit(int handle, const interest& i).
+	 */
+	template <typename visit_function_type>
+	void for_each(visit_function_type&& visit) const
+	{
+		for (size_t handle = 0; handle != this->interests.size(); ++handle) {
+			const auto& i = this->interests[handle];
+			if (i.present) {
+				visit(int(handle), i);
+			}
+		}
+	}
+
+	/**
+	 * @brief Remove all interests.
+	 */
+	void clear() noexcept
+	{
+		// NOTE: the vector keeps its capacity, so re-adding the handles does not allocate
+		this->interests.clear();
+		this->num_present = 0;
+		this->pending_changes.clear();
+	}
+
+	/**
+	 * @brief Request interest change.
+	 * @param handle - handle to change interest for.
+	 * @param s - requested interest state.
+	 * @throw std::logic_error - in case the handle is not in the table.
+	 */
+	void request(int handle, const state& s)
+	{
+		auto i = this->find(handle);
+		if (!i) {
+			throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
+		}
+
+		if (i->requested == s) {
+			return;
+		}
+
+		// NOTE: push to the list before changing the requested state, so that in case
+		// push_back() throws the interest would remain unchanged
+		if (!i->pending) {
+			this->pending_changes.push_back(handle);
+			i->pending = true;
+		}
+		i->requested = s;
+	}
+
+	/**
+	 * @brief Apply pending changes.
+	 * Calls the given function for every handle which requested interest differs from the applied one.
+	 * In case the function throws, the change is reverted and the exception is propagated.
+	 * @param apply - function to apply the change to the kernel,
+	 *                called as apply(int handle, const state& requested, const state& applied).
+	 */
+	template <typename apply_function_type>
+	void apply_pending_changes(apply_function_type&& apply)
+	{
+		for (auto i = this->pending_changes.begin(); i != this->pending_changes.end(); ++i) {
+			auto in = this->find(*i);
+			if (!in) {
+				// the waitable was removed after changing
+				continue;
+			}
+
+			if (!in->pending) {
+				// the handle was removed and then re-added after changing
+				continue;
+			}
+			in->pending = false;
+
+			if (in->requested == in->applied) {
+				// the change was reverted by subsequent change
+				continue;
+			}
+
+			try {
+				apply(*i, in->requested, in->applied);
+			} catch (...) {
+				// the change has not been applied, so revert it
+				in->requested = in->applied;
+				// drop the processed changes from the list, the failed one is also dropped
+				this->pending_changes.erase(this->pending_changes.begin(), std::next(i));
+				throw;
+			}
+			in->applied = in->requested;
+		}
+		this->pending_changes.clear();
+	}
+
+	/**
+	 * @brief Enumerate pending changes.
+	 * Calls the given function for every handle which requested interest differs from the applied one.
+	 * Unlike apply_pending_changes(), the changes stay pending until commit_pending_changes() is called.
+	 * Used by backends which pass the changes to the kernel in a batch, so that the interests are only
+	 * considered applied after the batch has been accepted by the kernel.
+	 * @param visit - function called as visit(int handle, const state& requested, const state& applied).
+	 */
+	template <typename visit_function_type>
+	void for_each_pending_change(visit_function_type&& visit) const
+	{
+		for (int handle : this->pending_changes) {
+			auto in = this->find(handle);
+			if (!in) {
+				// the waitable was removed after changing
+				continue;
+			}
+
+			if (!in->pending || in->requested == in->applied) {
+				// the handle was re-added or the change was reverted by subsequent change
+				continue;
+			}
+
+			visit(handle, in->requested, in->applied);
+		}
+	}
+
+	/**
+	 * @brief Mark all pending changes as applied.
+	 */
+	void commit_pending_changes() noexcept
+	{
+		for (int handle : this->pending_changes) {
+			auto in = this->find(handle);
+			if (!in || !in->pending) {
+				continue;
+			}
+			in->pending = false;
+			in->applied = in->requested;
+		}
+		this->pending_changes.clear();
+	}
+};
+
+} // namespace opros
@@ -0,0 +1,315 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "ipc_channel.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cstring>
+#	include <limits>
+#	include <stdexcept>
+#	include <system_error>
+
+#	include <sys/eventfd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+// each message is preceded by its size and aligned to this
+constexpr const size_t message_alignment = sizeof(uint64_t);
+
+constexpr const size_t min_capacity = 64;
+
+// size value marking that the rest of the ring till the end is unused and the next message is in the beginning
+constexpr const uint32_t wrap_marker = std::numeric_limits<uint32_t>::max();
+
+size_t align(size_t size) noexcept
+{
+	return (size + message_alignment - 1) & ~(message_alignment - 1);
+}
+
+size_t record_size(size_t message_size) noexcept
+{
+	return align(sizeof(uint32_t) + message_size);
+}
+
+int create_eventfd()
+{
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "ipc_channel::ipc_channel(): eventfd() failed");
+	}
+	return fd;
+}
+
+void ring_doorbell(int fd) noexcept
+{
+	if (eventfd_write(fd, 1) < 0) {
+		utki::assert(false, SL);
+	}
+}
+
+void reset_doorbell(int fd) noexcept
+{
+	eventfd_t value = 0;
+	if (eventfd_read(fd, &value) < 0) {
+		utki::assert(errno == EAGAIN, SL);
+	}
+}
+} // namespace
+
+ipc_channel::ipc_channel(size_t capacity) :
+	waitable(create_eventfd())
+{
+	size_t cap = min_capacity;
+	while (cap < capacity) {
+		cap <<= 1;
+	}
+
+	this->memfd = memfd_create("opros_ipc_channel", MFD_CLOEXEC);
+	if (this->memfd < 0) {
+		auto err = errno;
+		close(this->handle);
+		throw std::system_error(err, std::generic_category(), "ipc_channel::ipc_channel(): memfd_create() failed");
+	}
+
+	if (ftruncate(this->memfd, off_t(sizeof(header) + cap)) < 0) {
+		auto err = errno;
+		close(this->memfd);
+		close(this->handle);
+		throw std::system_error(err, std::generic_category(), "ipc_channel::ipc_channel(): ftruncate() failed");
+	}
+
+	try {
+		this->map();
+	} catch (...) {
+		close(this->memfd);
+		close(this->handle);
+		throw;
+	}
+
+	// the memory is zero-initialized, so head and tail are already 0
+	this->hdr->capacity = cap;
+	this->capacity = cap;
+}
+
+ipc_channel::ipc_channel(int memfd, int doorbell_fd) :
+	waitable(doorbell_fd),
+	memfd(memfd)
+{
+	try {
+		this->map();
+
+		auto cap = this->hdr->capacity;
+		if (cap < min_capacity || (cap & (cap - 1)) != 0 || sizeof(header) + cap != this->mapping_size) {
+			munmap(this->mapping, this->mapping_size);
+			throw std::invalid_argument("ipc_channel::ipc_channel(): shared memory is not a channel");
+		}
+		this->capacity = size_t(cap);
+	} catch (...) {
+		close(this->memfd);
+		close(this->handle);
+		throw;
+	}
+}
+
+ipc_channel::~ipc_channel()
+{
+	munmap(this->mapping, this->mapping_size);
+	close(this->memfd);
+	close(this->handle);
+}
+
+void ipc_channel::map()
+{
+	struct stat st {};
+	if (fstat(this->memfd, &st) < 0) {
+		throw std::system_error(errno, std::generic_category(), "ipc_channel: fstat() failed");
+	}
+	if (size_t(st.st_size) < sizeof(header)) {
+		throw std::invalid_argument("ipc_channel: shared memory is too small");
+	}
+	this->mapping_size = size_t(st.st_size);
+
+	this->mapping = mmap(nullptr, this->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->memfd, 0);
+	if (this->mapping == MAP_FAILED) {
+		throw std::system_error(errno, std::generic_category(), "ipc_channel: mmap() failed");
+	}
+
+	this->hdr = static_cast<header*>(this->mapping);
+	this->data = std::next(static_cast<uint8_t*>(this->mapping), sizeof(header));
+}
+
+size_t ipc_channel::max_message_size() const noexcept
+{
+	// message together with possible wrap gap must fit into the ring
+	return std::min(this->capacity / 2 - sizeof(uint32_t), size_t(wrap_marker - 1));
+}
+
+bool ipc_channel::send(utki::span<const uint8_t> message)
+{
+	if (message.size() > this->max_message_size()) {
+		throw std::invalid_argument("ipc_channel::send(): message is too big");
+	}
+
+	const auto cap = this->capacity;
+
+	// the tail is only written by us
+	auto tail = this->hdr->tail.load(std::memory_order_relaxed);
+	auto head = this->hdr->head.load(std::memory_order_acquire);
+
+	// positions are in the shared memory and could be corrupted by the peer
+	if (tail - head > cap || tail % message_alignment != 0) {
+		throw std::runtime_error("ipc_channel: shared memory contents are corrupted");
+	}
+
+	auto offset = size_t(tail & (cap - 1));
+	auto size = record_size(message.size());
+
+	size_t gap = 0;
+	if (offset + size > cap) {
+		// message does not fit till the end of the ring, it will be placed in the beginning
+		gap = cap - offset;
+	}
+
+	if (cap - size_t(tail - head) < gap + size) {
+		return false;
+	}
+
+	if (gap != 0) {
+		// there is always room for the marker since records are aligned
+		uint32_t marker = wrap_marker;
+		memcpy(std::next(this->data, ptrdiff_t(offset)), &marker, sizeof(marker));
+		offset = 0;
+	}
+
+	auto size32 = uint32_t(message.size());
+	auto p = std::next(this->data, ptrdiff_t(offset));
+	memcpy(p, &size32, sizeof(size32));
+	memcpy(std::next(p, sizeof(size32)), message.data(), message.size());
+
+	auto new_tail = tail + gap + size;
+
+	// NOTE: the consumer stores head before checking tail, while the producer stores tail before
+	//       checking head, so either the producer sees that the channel was emptied and rings the doorbell,
+	//       or the consumer sees the new message and does not reset the doorbell
+	this->hdr->tail.store(new_tail, std::memory_order_seq_cst);
+
+	if (this->hdr->head.load(std::memory_order_seq_cst) == tail) {
+		// the channel was empty
+		ring_doorbell(this->handle);
+	}
+
+	return true;
+}
+
+ipc_channel::record ipc_channel::get_record(uint64_t head, uint64_t tail) const
+{
+	const auto cap = this->capacity;
+
+	auto broken = []() {
+		return std::runtime_error("ipc_channel: shared memory contents are corrupted");
+	};
+
+	// the tail is written by the peer
+	auto available = tail - head;
+	if (available == 0 || available > cap) {
+		throw broken();
+	}
+
+	// the head is also in the shared memory, so it has to be aligned for the size to fit
+	auto offset = size_t(head & (cap - 1));
+	if (offset % message_alignment != 0) {
+		throw broken();
+	}
+
+	uint32_t size = 0;
+	memcpy(&size, std::next(this->data, ptrdiff_t(offset)), sizeof(size));
+
+	size_t gap = 0;
+	if (size == wrap_marker) {
+		gap = cap - offset;
+		offset = 0;
+		memcpy(&size, this->data, sizeof(size));
+	}
+
+	if (size > this->max_message_size()) {
+		throw broken();
+	}
+
+	auto consumed = gap + record_size(size);
+	if (consumed > available || offset + sizeof(size) + size > cap) {
+		throw broken();
+	}
+
+	return {offset + sizeof(size), size_t(size), head + consumed};
+}
+
+std::optional<utki::span<const uint8_t>> ipc_channel::front()
+{
+	// the head is only written by us
+	auto head = this->hdr->head.load(std::memory_order_relaxed);
+	auto tail = this->hdr->tail.load(std::memory_order_acquire);
+
+	if (head == tail) {
+		return std::nullopt;
+	}
+
+	auto r = this->get_record(head, tail);
+
+	return utki::make_span(std::next(this->data, ptrdiff_t(r.offset)), r.size);
+}
+
+void ipc_channel::pop()
+{
+	auto head = this->hdr->head.load(std::memory_order_relaxed);
+	auto tail = this->hdr->tail.load(std::memory_order_acquire);
+
+	utki::assert(head != tail, SL);
+
+	head = this->get_record(head, tail).next_head;
+
+	this->hdr->head.store(head, std::memory_order_seq_cst);
+
+	if (this->hdr->tail.load(std::memory_order_seq_cst) != head) {
+		return;
+	}
+
+	// the channel is empty, reset the doorbell
+	reset_doorbell(this->handle);
+
+	// the producer might have sent a message after we checked for emptiness and before resetting the doorbell,
+	// in which case it has rung the doorbell and we have just reset it, so ring it again
+	if (this->hdr->tail.load(std::memory_order_seq_cst) != head) {
+		ring_doorbell(this->handle);
+	}
+}
+
+#endif
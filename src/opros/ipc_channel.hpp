@@ -0,0 +1,172 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <atomic>
+#	include <cstdint>
+#	include <optional>
+
+#	include <utki/span.hpp>
+
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Shared memory message channel.
+ * Single producer single consumer ring buffer of messages in shared memory, with an eventfd
+ * used as doorbell. The channel can be shared between processes, either by inheriting the channel object
+ * through fork(), or by passing the memory and doorbell file descriptors to another process,
+ * e.g. over a unix socket, and attaching to them there.
+ * The waitable is the doorbell. It is ready to read when there are messages in the channel.
+ * The doorbell is rung only when a message is sent to the empty channel, so sending a message
+ * to a non-empty channel does not make any system calls. Receiving does not copy the message,
+ * it is accessed directly in the shared memory.
+ * Only one producer and one consumer are allowed at a time.
+ * The shared memory is not trusted, the consumer validates the records written by the producer,
+ * so that a broken or hostile peer cannot make it access memory outside of the ring.
+ */
+class ipc_channel final : public waitable
+{
+	struct header {
+		// read position, written by consumer
+		std::atomic<uint64_t> head;
+
+		// write position, written by producer
+		alignas(64) std::atomic<uint64_t> tail;
+
+		alignas(64) uint64_t capacity;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "lock-free atomics are needed for shared memory");
+
+	int memfd;
+
+	void* mapping;
+	size_t mapping_size;
+
+	header* hdr;
+	uint8_t* data;
+
+	// copy of the capacity from the shared memory header, validated on construction,
+	// so that the peer cannot change it afterwards
+	size_t capacity;
+
+	void map();
+
+	struct record {
+		size_t offset;
+		size_t size;
+
+		// head position after the record
+		uint64_t next_head;
+	};
+
+	// locates and validates the record at the head, the channel must not be empty
+	record get_record(uint64_t head, uint64_t tail) const;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Creates a new channel.
+	 * @param capacity - size of the ring buffer in bytes, rounded up to power of 2.
+	 * @throw std::system_error - in case creating the shared memory or the doorbell has failed.
+	 */
+	ipc_channel(size_t capacity);
+
+	/**
+	 * @brief Constructor.
+	 * Attaches to the existing channel, e.g. created by another process.
+	 * Takes ownership of the file descriptors.
+	 * @param memfd - shared memory file descriptor of the channel.
+	 * @param doorbell_fd - doorbell eventfd of the channel.
+	 * @throw std::system_error - in case mapping the shared memory has failed.
+	 * @throw std::invalid_argument - in case the shared memory is not a channel.
+	 */
+	ipc_channel(int memfd, int doorbell_fd);
+
+	ipc_channel(const ipc_channel&) = delete;
+	ipc_channel& operator=(const ipc_channel&) = delete;
+
+	ipc_channel(ipc_channel&&) = delete;
+	ipc_channel& operator=(ipc_channel&&) = delete;
+
+	~ipc_channel();
+
+	/**
+	 * @brief Get shared memory file descriptor.
+	 * To be passed to another process for attaching to the channel.
+	 * @return shared memory file descriptor.
+	 */
+	int get_memfd() const noexcept
+	{
+		return this->memfd;
+	}
+
+	/**
+	 * @brief Get maximum size of a single message.
+	 * @return maximum message size in bytes.
+	 */
+	size_t max_message_size() const noexcept;
+
+	/**
+	 * @brief Send message.
+	 * Copies the message to the channel.
+	 * @param message - message to send.
+	 * @return true if the message was sent.
+	 * @return false if there is not enough free space in the channel.
+	 * @throw std::invalid_argument - in case the message is bigger than max_message_size().
+	 * @throw std::runtime_error - in case the shared memory contents are corrupted by the peer.
+	 */
+	bool send(utki::span<const uint8_t> message);
+
+	/**
+	 * @brief Get the next message.
+	 * The message stays in the channel until pop() is called.
+	 * @return the next message.
+	 * @return std::nullopt if there are no messages in the channel.
+	 * @throw std::runtime_error - in case the shared memory contents are corrupted by the peer,
+	 *                             the channel cannot be used after that.
+	 */
+	std::optional<utki::span<const uint8_t>> front();
+
+	/**
+	 * @brief Remove the next message from the channel.
+	 * The message has to be present, i.e. front() has to return a message.
+	 * @throw std::runtime_error - in case the shared memory contents are corrupted by the peer,
+	 *                             the channel cannot be used after that.
+	 */
+	void pop();
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,546 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "kqueue_backend.hpp"
+
+#if CFG_OS == CFG_OS_MACOSX
+
+#	include <limits>
+#	include <ratio>
+#	include <system_error>
+
+#	include <sys/time.h>
+#	include <unistd.h>
+#	include <utki/string.hpp>
+
+namespace opros {
+
+namespace {
+// creates kqueue with the user event filter used by interrupt()
+OPROS_INLINE int create_kqueue()
+{
+	int queue = kqueue();
+	if (queue == -1) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): kqueue creation failed");
+	}
+
+	// user event filter used by interrupt(), EV_CLEAR makes several interrupts coalesce into one
+	using kevent_struct = struct kevent;
+	kevent_struct event{};
+	EV_SET(
+		&event, //
+		0,
+		EVFILT_USER,
+		EV_ADD | EV_CLEAR,
+		0,
+		0,
+		nullptr
+	);
+	if (kevent(queue, &event, 1, nullptr, 0, nullptr) < 0) {
+		auto err = errno;
+		close(queue);
+		throw std::system_error(err, std::generic_category(), "wait_set::wait_set(): kevent() failed to add user filter");
+	}
+
+	return queue;
+}
+} // namespace
+
+OPROS_INLINE kqueue_backend::kqueue_backend(unsigned capacity) :
+	// kevent() reports read and write events separately, so the total number of simultaneous events
+	// reported by kevent() can be more than the total number of waitable objects waited on,
+	// but it is ok to use buffer with less capacity to get the triggered events, then the events
+	// which did not fit into the buffer will be reported the next time.
+	// Using the buffer of the same size as wait_set capacity makes it easier to unify the behaviour
+	// across different platforms.
+	revents(capacity)
+{
+	if (capacity > std::numeric_limits<int>::max()) {
+		throw std::invalid_argument("wait_set(): given capacity is too big, should be <= INT_MAX");
+	}
+	utki::assert(int(capacity) > 0, SL);
+	this->queue = create_kqueue();
+}
+
+OPROS_INLINE kqueue_backend::~kqueue_backend()
+{
+	close(this->queue);
+}
+
+OPROS_INLINE void kqueue_backend::add_filter(
+	int handle, //
+	int16_t filter,
+	void* user_data
+)
+{
+	using kevent_struct = struct kevent;
+	kevent_struct event{};
+	kevent_struct out_event{};
+
+	EV_SET(
+		&event, //
+		handle,
+		filter,
+		EV_ADD | EV_RECEIPT,
+		0,
+		0,
+		user_data
+	);
+
+	// 0 to make effect of polling, because passing
+	// NULL will cause to wait indefinitely.
+	const timespec timeout = {0, 0};
+
+	int res = kevent(
+		this->queue, //
+		&event, // changelist: events/filters to add, modify or delete.
+		1, // number of entries in changelist.
+		&out_event, // eventlist: output buffer for triggered/receipt events.
+		1, // number of entries available in eventlist.
+		&timeout
+	);
+	if (res < 0) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::add(): add_filter(): kevent() failed");
+	}
+	utki::assert(res == 1, SL);
+
+	// EV_ERROR is always returned because of EV_RECEIPT, according to kevent() documentation.
+	utki::assert((out_event.flags & EV_ERROR) != 0, SL);
+
+	// data should be 0 if added successfully, otherwise it contains error code.
+	if (out_event.data != 0) {
+		utki::log_debug([&](auto& o) {
+			o << "wait_set::add(): out_event.data = " << out_event.data << std::endl;
+		});
+		throw std::runtime_error(
+			utki::cat("wait_set::add(): add_filter(): kevent() failed to add filter, out_event.data = ", out_event.data)
+		);
+	}
+}
+
+OPROS_INLINE void kqueue_backend::remove_filter(
+	int handle, //
+	int16_t filter
+) noexcept
+{
+	using kevent_struct = struct kevent;
+	kevent_struct event{};
+	kevent_struct out_event{};
+
+	EV_SET(
+		&event, //
+		handle,
+		filter,
+		EV_DELETE | EV_RECEIPT,
+		0,
+		0,
+		nullptr
+	);
+
+	// Set to 0 to make effect of polling, because passing NULL will cause to wait indefinitely.
+	const timespec timeout = {0, 0};
+
+	int res = kevent(
+		this->queue, //
+		&event, // changelist: events/filters to add, modify or delete.
+		1, // number of entries in changelist.
+		&out_event, // eventlist: output buffer for triggered/receipt events.
+		1, // number of entries available in eventlist.
+		&timeout
+	);
+	if (res < 0) {
+		// ignore the failure
+		utki::log_debug([&](auto& o) {
+			o << "wait_set::remove(): remove_filter(): kevent() failed" << std::endl;
+		});
+	}
+	utki::assert(res == 1, SL);
+
+	// EV_ERROR is always returned because of EV_RECEIPT, according to kevent() documentation.
+	utki::assert((out_event.flags & EV_ERROR) != 0, SL);
+}
+
+OPROS_INLINE void kqueue_backend::collect_pending_changes()
+{
+	utki::assert(this->changes.empty(), SL);
+
+	// NOTE: the changes stay pending until kevent() accepts the changelist
+	this->interests.for_each_pending_change([this](int handle, const auto& requested, const auto& applied) {
+		for (auto [filter, flag] : {
+				 std::make_pair(EVFILT_READ, ready::read),
+				 std::make_pair(EVFILT_WRITE, ready::write)
+			 })
+		{
+			bool is_requested = requested.wait_for.get(flag);
+			bool is_applied = applied.wait_for.get(flag);
+
+			uint16_t action{};
+			if (is_requested) {
+				if (is_applied && requested.user_data == applied.user_data) {
+					continue;
+				}
+				// EV_ADD also modifies the user data of already added filter
+				action = EV_ADD;
+			} else if (is_applied) {
+				action = EV_DELETE;
+			} else {
+				continue;
+			}
+
+			auto& event = this->changes.emplace_back();
+			EV_SET(
+				&event, //
+				handle,
+				filter,
+				action,
+				0,
+				0,
+				requested.user_data
+			);
+		}
+
+		// NOTE: errors of applying the changes are reported by kevent() as events with EV_ERROR flag
+	});
+}
+
+OPROS_INLINE bool kqueue_backend::handle_change_error(const struct kevent& e) noexcept
+{
+	auto i = this->interests.find(int(e.ident));
+	if (!i) {
+		return false;
+	}
+
+	auto flag = e.filter == EVFILT_WRITE ? ready::write : ready::read;
+
+	if (i->applied.wait_for.get(flag)) {
+		// adding the filter has failed, so it is not set in the kernel,
+		// drop it from the requested interest as well, so that requesting it again
+		// by a later change() is not skipped as redundant and the filter is re-added
+		i->applied.wait_for.set(flag, false);
+		i->requested.wait_for.set(flag, false);
+		return true;
+	}
+
+	// deleting the filter has failed, the filter which is not found has been deleted already,
+	// e.g. by the changelist of a failed kevent() call, which is passed again with the next wait
+	return e.data != ENOENT;
+}
+
+OPROS_INLINE void kqueue_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	auto handle = get_handle(w);
+
+	// NOTE: insert interest before doing the system call, so that in case insertion
+	// throws there would be no need to revert the system call
+	this->interests.insert(handle, {wait_for, user_data});
+
+	try {
+		utki::assert(this->interests.size() <= this->revents.size(), SL);
+
+		if (wait_for.get(ready::read)) {
+			this->add_filter(handle, EVFILT_READ, user_data);
+		}
+		if (wait_for.get(ready::write)) {
+			try {
+				this->add_filter(handle, EVFILT_WRITE, user_data);
+			} catch (...) {
+				if (wait_for.get(ready::read)) {
+					this->remove_filter(handle, EVFILT_READ);
+				}
+				throw;
+			}
+		}
+	} catch (...) {
+		this->interests.erase(handle);
+		throw;
+	}
+}
+
+OPROS_INLINE void kqueue_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	// the change is passed to the kernel along with the next wait
+	this->interests.request(get_handle(w), {wait_for, user_data});
+}
+
+OPROS_INLINE void* kqueue_backend::remove(waitable& w) noexcept
+{
+	auto handle = get_handle(w);
+
+	auto i = this->interests.find(handle);
+	if (!i) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::remove(): waitable is not added to wait set";
+			},
+			SL
+		);
+		return nullptr;
+	}
+	void* user_data = i->requested.user_data;
+
+	// only remove filters which are actually set in the kernel
+	const auto& applied = i->applied.wait_for;
+	if (applied.get(ready::read)) {
+		this->remove_filter(handle, EVFILT_READ);
+	}
+	if (applied.get(ready::write)) {
+		this->remove_filter(handle, EVFILT_WRITE);
+	}
+
+	this->interests.erase(handle);
+
+	return user_data;
+}
+
+OPROS_INLINE void kqueue_backend::clear()
+{
+	// NOTE: the kqueue is not replaced, so that interrupt() can use it without locking,
+	//       and the pending interrupt is kept
+
+	// delete all the filters set in the kernel with a single system call
+	this->changes.clear();
+	this->interests.for_each([this](int handle, const auto& i) {
+		for (auto [filter, flag] : {
+				 std::make_pair(EVFILT_READ, ready::read),
+				 std::make_pair(EVFILT_WRITE, ready::write)
+			 })
+		{
+			if (!i.applied.wait_for.get(flag)) {
+				continue;
+			}
+			auto& event = this->changes.emplace_back();
+			EV_SET(
+				&event, //
+				handle,
+				filter,
+				EV_DELETE | EV_RECEIPT,
+				0,
+				0,
+				nullptr
+			);
+		}
+	});
+
+	if (!this->changes.empty()) {
+		// with EV_RECEIPT every change is reported in the eventlist, so failing to delete a filter,
+		// e.g. because its file descriptor has been closed already, does not stop deleting the rest
+		try {
+			if (this->revents.size() < this->changes.size()) {
+				this->revents.resize(this->changes.size());
+			}
+		} catch (...) {
+			this->changes.clear();
+			throw;
+		}
+
+		utki::assert(this->changes.size() <= std::numeric_limits<int>::max(), SL);
+
+		// 0 to make effect of polling, because passing NULL will cause to wait indefinitely
+		const timespec timeout = {0, 0};
+
+		int res = kevent(
+			this->queue,
+			this->changes.data(),
+			int(this->changes.size()),
+			this->revents.data(),
+			int(this->changes.size()),
+			&timeout
+		);
+		auto err = errno;
+		this->changes.clear();
+		if (res < 0) {
+			throw std::system_error(err, std::generic_category(), "wait_set::clear(): kevent() failed");
+		}
+	}
+
+	this->interests.clear();
+}
+
+OPROS_INLINE void kqueue_backend::interrupt() noexcept
+{
+	// kevent() is a system call, so it is async-signal-safe
+	using kevent_struct = struct kevent;
+	kevent_struct event{};
+	EV_SET(
+		&event, //
+		0,
+		EVFILT_USER,
+		0,
+		NOTE_TRIGGER,
+		0,
+		nullptr
+	);
+	if (kevent(this->queue, &event, 1, nullptr, 0, nullptr) < 0) {
+		utki::assert(false, SL);
+	}
+}
+
+OPROS_INLINE bool kqueue_backend::reset() noexcept
+{
+	utki::assert(this->interests.size() == 0, SL);
+	this->changes.clear();
+
+	// no filters apart from the user one are registered, so polling the queue
+	// can only return the pending interrupt, which is consumed because of EV_CLEAR
+	using kevent_struct = struct kevent;
+	kevent_struct event{};
+	timespec ts{};
+	if (kevent(this->queue, nullptr, 0, &event, 1, &ts) < 0) {
+		return false;
+	}
+
+	return true;
+}
+
+OPROS_INLINE backend::wait_result kqueue_backend::wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events)
+{
+	// the pending changes are passed to the kernel along with the wait
+	this->collect_pending_changes();
+
+	// make room for the error entries of all the changes, so that kevent() reports the changes which
+	// cannot be applied as EV_ERROR entries instead of failing and leaving the rest of the changelist unprocessed
+	if (this->revents.size() < out_events.size() + this->changes.size()) {
+		try {
+			this->revents.resize(out_events.size() + this->changes.size());
+		} catch (...) {
+			this->changes.clear();
+			throw;
+		}
+	}
+
+	timespec ts = {
+		decltype(timespec::tv_sec)(timeout / std::milli::den), // seconds
+		decltype(timespec::tv_nsec)((timeout % std::milli::den) * std::micro::den) // nanoseconds
+	};
+
+	for (;;) {
+		utki::assert(this->revents.size() <= std::numeric_limits<int>::max(), SL);
+		utki::assert(this->changes.size() <= std::numeric_limits<int>::max(), SL);
+		int num_events_triggered = kevent(
+			this->queue,
+			this->changes.data(),
+			int(this->changes.size()),
+			this->revents.data(),
+			int(this->revents.size()),
+			(infinite) ? nullptr : &ts
+		);
+
+		if (num_events_triggered < 0) {
+			auto err = errno;
+			if (err == EINTR) {
+				// the changelist is processed before waiting for events, so no need to pass it again
+				// in case of retry
+				this->interests.commit_pending_changes();
+				this->changes.clear();
+				continue;
+			}
+			// the changelist might be not processed, so the changes are left pending
+			// and passed to the kernel again along with the next wait
+			this->changes.clear();
+			throw std::system_error(err, std::generic_category(), "wait_set::wait(): kevent() failed");
+		}
+
+		this->interests.commit_pending_changes();
+		this->changes.clear();
+
+		wait_result ret;
+
+		if (num_events_triggered == 0) {
+			// timeout hit
+			ret.timed_out = true;
+			return ret;
+		}
+
+		utki::assert(num_events_triggered > 0, SL);
+
+		utki::assert(out_events.size() <= this->revents.size(), SL);
+
+		size_t out_i = 0; // index into out_events
+
+		for (const auto& e : utki::make_span(this->revents.data(), size_t(num_events_triggered))) {
+			if (e.filter == EVFILT_USER) {
+				// interrupt() was called, the user event is reset automatically due to EV_CLEAR
+				ret.interrupted = true;
+				continue;
+			}
+
+			utki::flags<opros::ready> flags{false};
+
+			if ((e.flags & EV_ERROR) != 0) {
+				// a change from the changelist could not be applied
+				if (!this->handle_change_error(e)) {
+					continue;
+				}
+				flags.set(ready::error);
+			} else {
+				// no error condition, then set the flag based on filter type
+				if (e.filter == EVFILT_WRITE) {
+					flags.set(ready::write);
+					if ((e.flags & EV_EOF) != 0) {
+						// the reading end is closed, nothing can be written anymore
+						flags.set(ready::hangup);
+					}
+				} else if (e.filter == EVFILT_READ) {
+					flags.set(ready::read);
+					if ((e.flags & EV_EOF) != 0) {
+						// the writing end is closed, remaining data can still be read
+						flags.set(ready::read_hangup);
+					}
+				} else {
+					// unsupported event, skip it
+					continue;
+				}
+			}
+
+			if (out_i == out_events.size()) {
+				// the eventlist has extra room for change errors, the level-triggered events
+				// which do not fit into out_events are reported again by the next wait
+				continue;
+			}
+
+			auto& oe = out_events[out_i];
+			++out_i;
+
+			oe.flags = flags;
+			oe.user_data = e.udata;
+		}
+
+		utki::assert(out_i <= out_events.size(), SL);
+
+		// out_i can be less than number of events triggered because there can be unsupported events
+		// or interrupt event which are not counted
+		utki::assert(out_i <= size_t(num_events_triggered), SL);
+
+		ret.num_events = out_i;
+
+		return ret;
+	}
+}
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,93 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_MACOSX
+
+#	include <vector>
+
+#	include <sys/event.h>
+#	include <sys/types.h>
+
+#	include "backend.hpp"
+#	include "interest_table.hpp"
+
+namespace opros {
+
+/**
+ * @brief MacOS kqueue based backend.
+ */
+class kqueue_backend final : public backend
+{
+	int queue; // kqueue
+
+	std::vector<struct kevent> revents; // used for getting the result
+
+	interest_table interests;
+
+	// list of filter changes passed to kevent() along with the wait
+	std::vector<struct kevent> changes;
+
+	void add_filter(int handle, int16_t filter, void* user_data);
+	void remove_filter(int handle, int16_t filter) noexcept;
+
+	void collect_pending_changes();
+	bool handle_change_error(const struct kevent& e) noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables.
+	 */
+	kqueue_backend(unsigned capacity);
+
+	kqueue_backend(const kqueue_backend&) = delete;
+	kqueue_backend& operator=(const kqueue_backend&) = delete;
+
+	kqueue_backend(kqueue_backend&&) = delete;
+	kqueue_backend& operator=(kqueue_backend&&) = delete;
+
+	~kqueue_backend() override;
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
+
+#ifdef OPROS_HEADER_ONLY
+#	include "kqueue_backend.cpp"
+#endif
@@ -0,0 +1,206 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "pipe.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cerrno>
+#	include <climits>
+#	include <system_error>
+
+#	include <fcntl.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+template <typename function_type>
+std::optional<size_t> transfer(function_type&& f, const char* error_message)
+{
+	ssize_t res = 0;
+	do {
+		res = f();
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN) {
+			return std::nullopt;
+		}
+		throw std::system_error(errno, std::generic_category(), error_message);
+	}
+
+	return size_t(res);
+}
+
+std::array<int, 2> create_pipe()
+{
+	std::array<int, 2> fds{-1, -1};
+	if (pipe2(fds.data(), O_NONBLOCK | O_CLOEXEC) < 0) {
+		throw std::system_error(errno, std::generic_category(), "pipe::pipe(): pipe2() failed");
+	}
+	return fds;
+}
+} // namespace
+
+pipe_end::~pipe_end()
+{
+	close(this->handle);
+}
+
+std::optional<size_t> pipe_end::splice_from(int fd, size_t max_size)
+{
+	return transfer(
+		[&]() {
+			return splice(fd, nullptr, this->handle, nullptr, max_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		},
+		"pipe_end::splice_from(): splice() failed"
+	);
+}
+
+std::optional<size_t> pipe_end::splice_to(int fd, size_t max_size)
+{
+	return transfer(
+		[&]() {
+			return splice(this->handle, nullptr, fd, nullptr, max_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		},
+		"pipe_end::splice_to(): splice() failed"
+	);
+}
+
+std::optional<size_t> pipe_end::tee_to(pipe_end& to, size_t max_size)
+{
+	return transfer(
+		[&]() {
+			return tee(this->handle, to.handle, max_size, SPLICE_F_NONBLOCK);
+		},
+		"pipe_end::tee_to(): tee() failed"
+	);
+}
+
+std::optional<size_t> pipe_end::vmsplice(utki::span<const utki::span<const uint8_t>> buffers)
+{
+	auto num = std::min(buffers.size(), size_t(IOV_MAX));
+
+	if (this->iovecs.size() < num) {
+		this->iovecs.resize(num);
+	}
+	for (size_t i = 0; i != num; ++i) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast, "vmsplice() does not modify the data")
+		this->iovecs[i].iov_base = const_cast<uint8_t*>(buffers[i].data());
+		this->iovecs[i].iov_len = buffers[i].size();
+	}
+
+	return transfer(
+		[&]() {
+			return ::vmsplice(this->handle, this->iovecs.data(), num, SPLICE_F_NONBLOCK);
+		},
+		"pipe_end::vmsplice(): vmsplice() failed"
+	);
+}
+
+pipe::pipe(std::array<int, 2> fds) :
+	read(fds[0]),
+	write(fds[1])
+{}
+
+pipe::pipe() :
+	pipe(create_pipe())
+{}
+
+size_t pipe::get_capacity()
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	int res = fcntl(this->write.handle, F_GETPIPE_SZ);
+	if (res < 0) {
+		throw std::system_error(errno, std::generic_category(), "pipe::get_capacity(): fcntl() failed");
+	}
+	return size_t(res);
+}
+
+size_t pipe::set_capacity(size_t capacity)
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	int res = fcntl(this->write.handle, F_SETPIPE_SZ, int(std::min(capacity, size_t(INT_MAX))));
+	if (res < 0) {
+		throw std::system_error(errno, std::generic_category(), "pipe::set_capacity(): fcntl() failed");
+	}
+	return size_t(res);
+}
+
+splice_pump::splice_pump(waitable& source, waitable& destination, size_t capacity) :
+	source(source.get_handle()),
+	destination(destination.get_handle()),
+	buffer_capacity(capacity == 0 ? this->buffer.get_capacity() : this->buffer.set_capacity(capacity))
+{}
+
+splice_pump::state splice_pump::pump()
+{
+	while (true) {
+		bool progress = false;
+
+		if (!this->source_ended && this->num_buffered < this->buffer_capacity) {
+			auto res = this->buffer.get_write_end().splice_from(
+				this->source,
+				this->buffer_capacity - this->num_buffered
+			);
+			if (res) {
+				if (*res == 0) {
+					this->source_ended = true;
+				} else {
+					this->num_buffered += *res;
+					progress = true;
+				}
+			}
+		}
+
+		if (this->num_buffered != 0) {
+			auto res = this->buffer.get_read_end().splice_to(this->destination, this->num_buffered);
+			if (res && *res != 0) {
+				utki::assert(*res <= this->num_buffered, SL);
+				this->num_buffered -= *res;
+				progress = true;
+			}
+		}
+
+		if (!progress) {
+			break;
+		}
+	}
+
+	state ret{};
+	ret.finished = this->source_ended && this->num_buffered == 0;
+	// the pipe can be full even if it holds less than its capacity, since splice() can fill its page slots
+	// partially, so in case there is data in the pipe, then the destination is not ready and it is waited for
+	// before reading more from the source
+	ret.wait_source = !this->source_ended && this->num_buffered == 0;
+	ret.wait_destination = this->num_buffered != 0;
+	return ret;
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <array>
+#	include <optional>
+#	include <vector>
+
+#	include <sys/uio.h>
+
+#	include <utki/span.hpp>
+
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief End of a pipe.
+ * The read end is ready to read when there is data in the pipe or the write end is closed.
+ * The write end is ready to write when there is space in the pipe.
+ * Data is moved through the pipe without copying it to user space, using splice(), tee() and vmsplice().
+ * All operations are non-blocking.
+ */
+class pipe_end final : public waitable
+{
+	friend class pipe;
+
+	// reusable system call argument buffer
+	std::vector<iovec> iovecs;
+
+	pipe_end(int fd) :
+		waitable(fd)
+	{}
+
+public:
+	pipe_end(const pipe_end&) = delete;
+	pipe_end& operator=(const pipe_end&) = delete;
+
+	pipe_end(pipe_end&&) = delete;
+	pipe_end& operator=(pipe_end&&) = delete;
+
+	~pipe_end();
+
+	/**
+	 * @brief Move data from file descriptor to the pipe.
+	 * To be called on the write end.
+	 * @param fd - file descriptor to move the data from, should be in non-blocking mode.
+	 * @param max_size - maximum number of bytes to move.
+	 * @return number of moved bytes.
+	 * @return 0 in case of the end of the data of the file descriptor.
+	 * @return std::nullopt in case there is no data in the file descriptor or no space in the pipe.
+	 * @throw std::system_error - in case splice() has failed.
+	 */
+	std::optional<size_t> splice_from(int fd, size_t max_size);
+
+	/**
+	 * @brief Move data from the pipe to file descriptor.
+	 * To be called on the read end.
+	 * @param fd - file descriptor to move the data to, should be in non-blocking mode.
+	 * @param max_size - maximum number of bytes to move.
+	 * @return number of moved bytes.
+	 * @return 0 in case the pipe is empty and its write end is closed.
+	 * @return std::nullopt in case there is no data in the pipe or the file descriptor is not ready to write.
+	 * @throw std::system_error - in case splice() has failed.
+	 */
+	std::optional<size_t> splice_to(int fd, size_t max_size);
+
+	/**
+	 * @brief Duplicate data of the pipe to another pipe.
+	 * To be called on the read end. The data is not consumed from this pipe.
+	 * @param to - write end of another pipe.
+	 * @param max_size - maximum number of bytes to duplicate.
+	 * @return number of duplicated bytes.
+	 * @return 0 in case the pipe is empty and its write end is closed.
+	 * @return std::nullopt in case there is no data in the pipe or no space in the other pipe.
+	 * @throw std::system_error - in case tee() has failed.
+	 */
+	std::optional<size_t> tee_to(pipe_end& to, size_t max_size);
+
+	/**
+	 * @brief Map user memory to the pipe.
+	 * To be called on the write end. The pages of the buffers are referenced by the pipe instead of
+	 * copying the data, so the buffers must not be modified until the data is consumed from the pipe.
+	 * @param buffers - buffers holding the data.
+	 * @return number of bytes mapped to the pipe.
+	 * @return std::nullopt in case there is no space in the pipe.
+	 * @throw std::system_error - in case vmsplice() has failed.
+	 */
+	std::optional<size_t> vmsplice(utki::span<const utki::span<const uint8_t>> buffers);
+};
+
+/**
+ * @brief Pipe.
+ * Pair of connected pipe ends, each of them can be added to a wait_set.
+ */
+class pipe
+{
+	pipe_end read;
+	pipe_end write;
+
+	pipe(std::array<int, 2> fds);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Creates non-blocking pipe.
+	 * @throw std::system_error - in case creating the pipe has failed.
+	 */
+	pipe();
+
+	pipe(const pipe&) = delete;
+	pipe& operator=(const pipe&) = delete;
+
+	pipe(pipe&&) = delete;
+	pipe& operator=(pipe&&) = delete;
+
+	~pipe() = default;
+
+	/**
+	 * @brief Get read end of the pipe.
+	 * @return read end.
+	 */
+	pipe_end& get_read_end() noexcept
+	{
+		return this->read;
+	}
+
+	/**
+	 * @brief Get write end of the pipe.
+	 * @return write end.
+	 */
+	pipe_end& get_write_end() noexcept
+	{
+		return this->write;
+	}
+
+	/**
+	 * @brief Get pipe capacity.
+	 * @return capacity of the pipe in bytes.
+	 * @throw std::system_error - in case getting the capacity has failed.
+	 */
+	size_t get_capacity();
+
+	/**
+	 * @brief Set pipe capacity.
+	 * @param capacity - requested capacity in bytes, rounded up by the kernel to a power of two number of pages.
+	 * @return actual capacity of the pipe in bytes.
+	 * @throw std::system_error - in case setting the capacity has failed, e.g. it exceeds the system limit.
+	 */
+	size_t set_capacity(size_t capacity);
+};
+
+/**
+ * @brief Zero-copy data forwarder.
+ * Moves data from the source file descriptor to the destination file descriptor through an internal pipe
+ * with splice(), so the data is never copied to user space. Any of the source and the destination can be
+ * e.g. a socket, a pipe or a file. The pump is driven by readiness: the source and the destination
+ * are added to a wait_set and pump() is called when any of them triggers, it returns what to wait for next.
+ */
+class splice_pump
+{
+	const int source;
+	const int destination;
+
+	opros::pipe buffer;
+	size_t buffer_capacity;
+
+	size_t num_buffered = 0;
+
+	bool source_ended = false;
+
+public:
+	/**
+	 * @brief State of the pump.
+	 */
+	struct state {
+		/**
+		 * @brief Whether to wait for the source to be ready to read.
+		 */
+		bool wait_source;
+
+		/**
+		 * @brief Whether to wait for the destination to be ready to write.
+		 */
+		bool wait_destination;
+
+		/**
+		 * @brief Whether the source has ended and all its data is moved to the destination.
+		 */
+		bool finished;
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param source - waitable to read data from, should be in non-blocking mode.
+	 * @param destination - waitable to write data to, should be in non-blocking mode.
+	 * @param capacity - capacity of the internal pipe, 0 for default.
+	 * @throw std::system_error - in case creating the pipe has failed.
+	 */
+	splice_pump(waitable& source, waitable& destination, size_t capacity = 0);
+
+	/**
+	 * @brief Move data.
+	 * Moves as much data as possible without blocking.
+	 * @return state of the pump.
+	 * @throw std::system_error - in case moving the data has failed.
+	 */
+	state pump();
+
+	/**
+	 * @brief Get number of bytes in the internal pipe.
+	 * @return number of bytes read from the source but not yet written to the destination.
+	 */
+	size_t get_num_buffered() const noexcept
+	{
+		return this->num_buffered;
+	}
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,57 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_WINDOWS
+#	include "windows_backend.hpp"
+#elif CFG_OS == CFG_OS_LINUX
+#	include "poll_backend.hpp"
+#elif CFG_OS == CFG_OS_MACOSX
+#	include "kqueue_backend.hpp"
+#else
+#	error "Unsupported OS"
+#endif
+
+namespace opros {
+
+/**
+ * @brief Platform-specific backend.
+ * Backend used by wait_set by default, selected at compile time.
+ * On Linux it is poll_backend, which promotes itself to epoll when the number of
+ * added waitables grows, on MacOS it is kqueue_backend and on Windows it is windows_backend.
+ */
+#if CFG_OS == CFG_OS_WINDOWS
+using platform_backend = windows_backend;
+#elif CFG_OS == CFG_OS_LINUX
+using platform_backend = poll_backend;
+#elif CFG_OS == CFG_OS_MACOSX
+using platform_backend = kqueue_backend;
+#endif
+
+} // namespace opros
@@ -0,0 +1,330 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "poll_backend.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <limits>
+#	include <system_error>
+
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+
+namespace opros {
+
+namespace {
+OPROS_INLINE short to_poll_events(utki::flags<ready> wait_for)
+{
+	// NOTE: POLLERR and POLLHUP are always reported, no need to request those
+	return short(
+		(wait_for.get(ready::read) ? (unsigned(POLLIN) | unsigned(POLLRDHUP)) : 0) |
+		(wait_for.get(ready::priority) ? unsigned(POLLPRI) : 0) |
+		(wait_for.get(ready::write) ? unsigned(POLLOUT) : 0)
+	);
+}
+} // namespace
+
+OPROS_INLINE poll_backend::poll_backend(unsigned capacity) :
+	capacity(capacity)
+{
+	if (capacity >= unsigned(std::numeric_limits<int>::max())) {
+		throw std::invalid_argument("wait_set(): given capacity is too big, should be < INT_MAX");
+	}
+
+	this->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (this->interrupt_fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): eventfd() failed");
+	}
+
+	auto& p = this->pollfds.front();
+	p.fd = this->interrupt_fd;
+	p.events = POLLIN;
+}
+
+OPROS_INLINE poll_backend::~poll_backend()
+{
+	// destroy epoll backend before closing the interrupt eventfd it uses
+	this->promoted.reset();
+	close(this->interrupt_fd);
+}
+
+OPROS_INLINE unsigned poll_backend::find(const waitable& w) const noexcept
+{
+	unsigned i = 0;
+	for (; i != this->size; ++i) {
+		if (this->entries[i].w == &w) {
+			break;
+		}
+	}
+	return i;
+}
+
+OPROS_INLINE void poll_backend::promote()
+{
+	auto epoll = std::make_unique<epoll_backend>(this->capacity, this->interrupt_fd);
+
+	for (const auto& e : utki::make_span(this->entries.data(), this->size)) {
+		epoll->add(*e.w, e.wait_for, e.user_data);
+	}
+
+	this->promoted = std::move(epoll);
+	this->size = 0;
+}
+
+OPROS_INLINE void poll_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	if (this->promoted) {
+		this->promoted->add(w, wait_for, user_data);
+		return;
+	}
+
+	if (get_handle(w) < 0) {
+		throw std::invalid_argument("wait_set::add(): invalid handle");
+	}
+
+	if (this->find(w) != this->size) {
+		throw std::logic_error("wait_set::add(): the waitable is already added to this wait set");
+	}
+
+	// the poll() reports all the ready waitables at once, so the number of them must not exceed the capacity,
+	// while epoll returns at most capacity events and leaves the rest for the next wait
+	if (this->size == this->entries.size() || this->size == this->capacity) {
+		this->promote();
+		this->promoted->add(w, wait_for, user_data);
+		return;
+	}
+
+	auto& e = this->entries[this->size];
+	e.w = &w;
+	e.wait_for = wait_for;
+	e.user_data = user_data;
+
+	auto& p = this->pollfds[size_t(this->size) + 1];
+	p.fd = get_handle(w);
+	p.events = to_poll_events(wait_for);
+
+	++this->size;
+}
+
+OPROS_INLINE void poll_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	if (this->promoted) {
+		this->promoted->change(w, wait_for, user_data);
+		return;
+	}
+
+	unsigned i = this->find(w);
+	if (i == this->size) {
+		throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
+	}
+
+	auto& e = this->entries[i];
+	e.wait_for = wait_for;
+	e.user_data = user_data;
+
+	this->pollfds[size_t(i) + 1].events = to_poll_events(wait_for);
+}
+
+OPROS_INLINE void* poll_backend::remove(waitable& w) noexcept
+{
+	if (this->promoted) {
+		return this->promoted->remove(w);
+	}
+
+	unsigned i = this->find(w);
+	if (i == this->size) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::remove(): waitable is not added to wait set";
+			},
+			SL
+		);
+		return nullptr;
+	}
+
+	void* user_data = this->entries[i].user_data;
+
+	// move the last entry in place of the removed one
+	--this->size;
+	this->entries[i] = this->entries[this->size];
+	this->pollfds[size_t(i) + 1] = this->pollfds[size_t(this->size) + 1];
+
+	return user_data;
+}
+
+OPROS_INLINE void poll_backend::clear()
+{
+	if (this->promoted) {
+		this->promoted->clear();
+		return;
+	}
+
+	this->size = 0;
+}
+
+OPROS_INLINE void poll_backend::interrupt() noexcept
+{
+	// eventfd_write() is just a write() to the eventfd, so it is async-signal-safe
+	if (eventfd_write(this->interrupt_fd, 1) < 0) {
+		utki::assert(false, SL);
+	}
+}
+
+OPROS_INLINE bool poll_backend::reset() noexcept
+{
+	if (this->promoted) {
+		// the promoted backend shares the interrupt eventfd, so it will drain it
+		return this->promoted->reset();
+	}
+
+	utki::assert(this->size == 0, SL);
+
+	// drop pending interrupt
+	eventfd_t value = 0;
+	if (eventfd_read(this->interrupt_fd, &value) < 0) {
+		utki::assert(errno == EAGAIN, SL);
+	}
+
+	return true;
+}
+
+OPROS_INLINE backend::wait_result poll_backend::wait_internal(int timeout, utki::span<event_info> out_events)
+{
+	int num_ready{};
+
+	while (true) {
+		num_ready = poll(this->pollfds.data(), nfds_t(this->size) + 1, timeout);
+
+		if (num_ready < 0) {
+			// if interrupted by signal, try waiting again.
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "wait_set::wait(): poll() failed");
+		}
+		break;
+	}
+
+	wait_result ret;
+
+	if (num_ready == 0) {
+		// timeout hit
+		ret.timed_out = true;
+		return ret;
+	}
+
+	if (this->pollfds.front().revents != 0) {
+		// reset the eventfd counter, so that all interrupts issued so far are coalesced into one
+		eventfd_t value = 0;
+		if (eventfd_read(this->interrupt_fd, &value) < 0) {
+			// the eventfd is non-blocking, so EAGAIN means there was a race with
+			// another reader, which cannot happen, so ignore the failure
+			utki::assert(errno == EAGAIN, SL);
+		}
+		ret.interrupted = true;
+	}
+
+	size_t out_i = 0;
+	for (unsigned i = 0; i != this->size; ++i) {
+		auto revents = unsigned(this->pollfds[size_t(i) + 1].revents);
+		if (revents == 0) {
+			continue;
+		}
+
+		utki::flags<ready> flags;
+
+		if ((revents & (unsigned(POLLERR) | unsigned(POLLNVAL))) != 0) {
+			flags.set(ready::error);
+		}
+		if ((revents & unsigned(POLLHUP)) != 0) {
+			flags.set(ready::hangup);
+		}
+		if ((revents & unsigned(POLLIN)) != 0) {
+			flags.set(ready::read);
+		}
+		if ((revents & unsigned(POLLRDHUP)) != 0) {
+			flags.set(ready::read_hangup);
+		}
+		if ((revents & unsigned(POLLPRI)) != 0) {
+			flags.set(ready::priority);
+		}
+		if ((revents & unsigned(POLLOUT)) != 0) {
+			flags.set(ready::write);
+		}
+
+		if (flags.is_clear()) {
+			continue;
+		}
+
+		utki::assert(out_i < out_events.size(), SL);
+		auto& oe = out_events[out_i];
+		++out_i;
+
+		oe.flags = flags;
+		oe.user_data = this->entries[i].user_data;
+	}
+
+	ret.num_events = out_i;
+
+	return ret;
+}
+
+OPROS_INLINE backend::wait_result poll_backend::wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events)
+{
+	if (this->promoted) {
+		return this->promoted->wait(infinite, timeout, out_events);
+	}
+
+	if (infinite) {
+		return this->wait_internal(-1, out_events);
+	}
+
+	// poll() gets timeout as int argument, while we have timeout
+	// as uint32_t, so the requested timeout can be bigger than int can hold
+	// (negative values of the int are not used)
+
+	auto max_time_step = uint32_t(std::numeric_limits<int>::max());
+
+	while (timeout >= max_time_step) {
+		auto res = this->wait_internal(int(max_time_step), out_events);
+		if (!res.timed_out) {
+			return res;
+		}
+		timeout -= max_time_step;
+		if (timeout == 0) {
+			// timeout hit
+			return res;
+		}
+	}
+
+	return this->wait_internal(int(timeout), out_events);
+}
+
+} // namespace opros
+
+#endif
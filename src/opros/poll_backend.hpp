@@ -0,0 +1,127 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <array>
+#	include <memory>
+
+#	include <poll.h>
+
+#	include "backend.hpp"
+#	include "epoll_backend.hpp"
+
+namespace opros {
+
+/**
+ * @brief Linux poll() based backend for small wait sets.
+ * Keeps the array of pollfd structures inline, so it does not need any kernel object
+ * apart from the eventfd used by interrupt(). Adding, changing and removing waitables
+ * does not make any system calls.
+ * When the number of added waitables exceeds max_poll_size or the capacity the backend
+ * promotes itself to epoll, i.e. creates epoll_backend and moves all the waitables to it.
+ */
+class poll_backend final : public backend
+{
+public:
+	/**
+	 * @brief Maximum number of waitables handled with poll().
+	 */
+	constexpr static const unsigned max_poll_size = 3;
+
+private:
+	const unsigned capacity;
+
+	int interrupt_fd; // eventfd used by interrupt()
+
+	struct entry {
+		waitable* w;
+		utki::flags<ready> wait_for;
+		void* user_data;
+	};
+
+	unsigned size = 0;
+
+	std::array<entry, max_poll_size> entries;
+
+	// the first pollfd is for the interrupt eventfd, the rest correspond to entries
+	std::array<pollfd, max_poll_size + 1> pollfds;
+
+	// set when the number of waitables exceeds max_poll_size,
+	// NOTE: must be declared after the interrupt_fd because it uses it
+	std::unique_ptr<epoll_backend> promoted;
+
+	void promote();
+
+	unsigned find(const waitable& w) const noexcept;
+
+	wait_result wait_internal(int timeout, utki::span<event_info> out_events);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables.
+	 */
+	poll_backend(unsigned capacity);
+
+	poll_backend(const poll_backend&) = delete;
+	poll_backend& operator=(const poll_backend&) = delete;
+
+	poll_backend(poll_backend&&) = delete;
+	poll_backend& operator=(poll_backend&&) = delete;
+
+	~poll_backend() override;
+
+	/**
+	 * @brief Check if the backend was promoted to epoll.
+	 * @return true if the backend uses epoll.
+	 * @return false if the backend uses poll().
+	 */
+	bool is_promoted() const noexcept
+	{
+		return bool(this->promoted);
+	}
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
+
+#ifdef OPROS_HEADER_ONLY
+#	include "poll_backend.cpp"
+#endif
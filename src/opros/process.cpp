@@ -0,0 +1,107 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "process.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <cerrno>
+#	include <csignal>
+#	include <system_error>
+
+#	include <sys/syscall.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+// older system headers might not define these
+#	ifndef SYS_pidfd_open
+constexpr const long sys_pidfd_open = 434;
+#	else
+constexpr const long sys_pidfd_open = SYS_pidfd_open;
+#	endif
+
+#	ifndef SYS_pidfd_send_signal
+constexpr const long sys_pidfd_send_signal = 424;
+#	else
+constexpr const long sys_pidfd_send_signal = SYS_pidfd_send_signal;
+#	endif
+
+constexpr const auto p_pidfd = idtype_t(3);
+
+int open_pidfd(pid_t pid)
+{
+	// pidfd is opened with O_CLOEXEC flag by the kernel
+	auto fd = int(syscall(sys_pidfd_open, pid, 0));
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "process::process(): pidfd_open() failed");
+	}
+	return fd;
+}
+} // namespace
+
+process::process(pid_t pid) :
+	waitable(open_pidfd(pid)),
+	pid(pid)
+{}
+
+process::~process()
+{
+	close(this->handle);
+}
+
+std::optional<process::exit_status> process::reap()
+{
+	siginfo_t info{};
+
+	while (waitid(p_pidfd, id_t(this->handle), &info, WEXITED | WNOHANG) < 0) {
+		if (errno == EINTR) {
+			continue;
+		}
+		throw std::system_error(errno, std::generic_category(), "process::reap(): waitid() failed");
+	}
+
+	// with WNOHANG the si_pid is 0 if the process has not exited yet
+	if (info.si_pid == 0) {
+		return std::nullopt;
+	}
+
+	return exit_status{
+		info.si_code != CLD_EXITED, // signaled
+		info.si_status // code
+	};
+}
+
+void process::send_signal(int sig)
+{
+	if (syscall(sys_pidfd_send_signal, this->handle, sig, nullptr, 0) < 0) {
+		throw std::system_error(errno, std::generic_category(), "process::send_signal(): pidfd_send_signal() failed");
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <optional>
+
+#	include <sys/types.h>
+
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Child process waitable.
+ * Waitable which becomes ready to read when the process exits.
+ * It is based on process file descriptor (pidfd), so it requires Linux 5.3 or later,
+ * reaping the process requires Linux 5.4 or later.
+ * Unlike SIGCHLD handling, each process is tracked individually and reaping it
+ * does not affect other child processes.
+ */
+class process final : public waitable
+{
+	const pid_t pid;
+
+public:
+	/**
+	 * @brief Process exit status.
+	 */
+	struct exit_status {
+		/**
+		 * @brief Whether the process was terminated by a signal.
+		 */
+		bool signaled;
+
+		/**
+		 * @brief Exit code of the process or number of the signal which has terminated it.
+		 */
+		int code;
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param pid - process id of a child process.
+	 * @throw std::system_error - in case opening the pidfd has failed,
+	 *                            e.g. there is no such process or the kernel does not support pidfd.
+	 */
+	process(pid_t pid);
+
+	process(const process&) = delete;
+	process& operator=(const process&) = delete;
+
+	process(process&&) = delete;
+	process& operator=(process&&) = delete;
+
+	~process();
+
+	/**
+	 * @brief Get process id.
+	 * @return process id of the process.
+	 */
+	pid_t get_pid() const noexcept
+	{
+		return this->pid;
+	}
+
+	/**
+	 * @brief Reap the exited process.
+	 * Does not block.
+	 * The process can be reaped only once, after that it is not possible to
+	 * get its exit status again, though the waitable stays ready to read.
+	 * @return exit status in case the process has exited.
+	 * @return std::nullopt in case the process is still running.
+	 * @throw std::system_error - in case waitid() has failed, e.g. the process is already reaped.
+	 */
+	std::optional<exit_status> reap();
+
+	/**
+	 * @brief Send signal to the process.
+	 * Unlike kill(), it is not affected by process id reuse.
+	 * @param sig - signal to send.
+	 * @throw std::system_error - in case sending the signal has failed.
+	 */
+	void send_signal(int sig);
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,241 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "simulation_backend.hpp"
+
+#include <stdexcept>
+
+using namespace opros;
+
+namespace {
+utki::flags<ready> get_reported_flags(utki::flags<ready> readiness, utki::flags<ready> wait_for)
+{
+	// error and hangup are always reported, regardless of the wait flags
+	wait_for.set(ready::error);
+	wait_for.set(ready::hangup);
+	if (wait_for.get(ready::read)) {
+		wait_for.set(ready::read_hangup);
+	}
+	return readiness & wait_for;
+}
+} // namespace
+
+void simulation_backend::update_ready_list(const waitable& w, registration& r)
+{
+	if (r.in_ready_list) {
+		// will be checked for actual readiness when collecting events
+		return;
+	}
+
+	if (get_reported_flags(r.readiness, r.wait_for).is_clear()) {
+		return;
+	}
+
+	this->ready_list.push_back({&w, r.generation});
+	r.in_ready_list = true;
+
+	this->cv.notify_one();
+}
+
+void simulation_backend::set_readiness(const waitable& w, utki::flags<ready> readiness)
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("simulation_backend::set_readiness(): the waitable is not added to the wait set");
+	}
+
+	i->second.readiness = readiness;
+	this->update_ready_list(w, i->second);
+}
+
+utki::flags<ready> simulation_backend::get_readiness(const waitable& w)
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("simulation_backend::get_readiness(): the waitable is not added to the wait set");
+	}
+
+	return i->second.readiness;
+}
+
+void simulation_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto res = this->registrations.try_emplace(&w);
+	if (!res.second) {
+		throw std::logic_error("wait_set::add(): the waitable is already added to this wait set");
+	}
+
+	auto& r = res.first->second;
+	r.wait_for = wait_for;
+	r.user_data = user_data;
+	r.readiness.clear();
+	r.generation = this->next_generation;
+	++this->next_generation;
+}
+
+void simulation_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
+	}
+
+	auto& r = i->second;
+	r.wait_for = wait_for;
+	r.user_data = user_data;
+	this->update_ready_list(w, r);
+}
+
+void* simulation_backend::remove(waitable& w) noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	auto i = this->registrations.find(&w);
+	if (i == this->registrations.end()) {
+		utki::assert(
+			false,
+			[&](auto& o) {
+				o << "wait_set::remove(): waitable is not added to wait set";
+			},
+			SL
+		);
+		return nullptr;
+	}
+
+	void* user_data = i->second.user_data;
+
+	// NOTE: the waitable can still be in the ready list, it will be
+	//       skipped when collecting events since it will not be found among registrations
+	this->registrations.erase(i);
+
+	return user_data;
+}
+
+void simulation_backend::interrupt() noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->interrupt_pending = true;
+	this->cv.notify_one();
+}
+
+void simulation_backend::clear()
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->registrations.clear();
+	this->ready_list.clear();
+}
+
+bool simulation_backend::reset() noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	utki::assert(this->registrations.empty(), SL);
+	this->ready_list.clear();
+	this->interrupt_pending = false;
+	return true;
+}
+
+size_t simulation_backend::collect_events(utki::span<event_info> out_events)
+{
+	size_t num_events = 0;
+
+	this->ready_list_unreached.clear();
+	this->ready_list_reported.clear();
+
+	for (const auto& e : this->ready_list) {
+		auto i = this->registrations.find(e.w);
+		if (i == this->registrations.end() || i->second.generation != e.generation) {
+			// the waitable was removed
+			continue;
+		}
+		auto& r = i->second;
+
+		auto flags = get_reported_flags(r.readiness, r.wait_for);
+		if (flags.is_clear()) {
+			r.in_ready_list = false;
+			continue;
+		}
+
+		if (num_events == out_events.size()) {
+			this->ready_list_unreached.push_back(e);
+			continue;
+		}
+
+		auto& oe = out_events[num_events];
+		oe.flags = flags;
+		oe.user_data = r.user_data;
+		++num_events;
+
+		this->ready_list_reported.push_back(e);
+	}
+
+	// the waitables which did not fit into the output buffer go first next time
+	this->ready_list.swap(this->ready_list_unreached);
+	this->ready_list.insert(
+		this->ready_list.end(),
+		this->ready_list_reported.begin(),
+		this->ready_list_reported.end()
+	);
+
+	return num_events;
+}
+
+backend::wait_result simulation_backend::wait(bool infinite, uint32_t, utki::span<event_info> out_events)
+{
+	std::unique_lock<decltype(this->mutex)> lock(this->mutex);
+
+	wait_result ret;
+
+	for (;;) {
+		ret.num_events = this->collect_events(out_events);
+
+		if (this->interrupt_pending) {
+			this->interrupt_pending = false;
+			ret.interrupted = true;
+		}
+
+		if (ret.num_events != 0 || ret.interrupted) {
+			return ret;
+		}
+
+		if (!infinite) {
+			// simulated time passes instantly, so the timeout value does not matter
+			ret.timed_out = true;
+			return ret;
+		}
+
+		this->cv.wait(lock, [this]() {
+			return this->interrupt_pending || !this->ready_list.empty();
+		});
+	}
+}
@@ -0,0 +1,170 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "backend.hpp"
+
+namespace opros {
+
+/**
+ * @brief Waitable for use with simulation_backend.
+ * This waitable does not have any underlying OS handle.
+ */
+class simulated_waitable : public waitable
+{
+public:
+	simulated_waitable() :
+		waitable(
+#if CFG_OS == CFG_OS_WINDOWS
+			nullptr
+#else
+			-1
+#endif
+		)
+	{}
+
+	simulated_waitable(const simulated_waitable&) = delete;
+	simulated_waitable& operator=(const simulated_waitable&) = delete;
+
+	simulated_waitable(simulated_waitable&&) = delete;
+	simulated_waitable& operator=(simulated_waitable&&) = delete;
+
+	~simulated_waitable()
+#if CFG_OS == CFG_OS_WINDOWS
+		override
+#endif
+		= default;
+
+#if CFG_OS == CFG_OS_WINDOWS
+
+protected:
+	void set_waiting_flags(utki::flags<ready>) override {}
+
+	utki::flags<ready> get_readiness_flags() override
+	{
+		return false;
+	}
+#endif
+};
+
+/**
+ * @brief In-memory backend with programmatically injected readiness.
+ * The backend does not use any OS objects, readiness of the added waitables
+ * is set with set_readiness(). Readiness is level-triggered, i.e. the waitable
+ * is reported by every wait() while its readiness matches the wait flags,
+ * the ready::error and ready::hangup flags are always reported, same as for OS backends.
+ * The events are reported in the order the waitables became ready, in case not all of them
+ * fit into the wait_set's buffer, the rest are reported first by the next wait().
+ * Waiting with finite timeout never blocks, if nothing is ready it returns as timed out
+ * right away, as if the simulated time had passed instantly. Waiting without timeout
+ * blocks until some waitable becomes ready or the wait is interrupted.
+ * All functions are thread-safe.
+ *
+ * Any waitable can be added to the wait_set using simulation backend, its handle is ignored.
+ * The simulated_waitable can be used to have waitables without any OS resources.
+ */
+class simulation_backend final : public backend
+{
+	struct registration {
+		utki::flags<ready> wait_for;
+		void* user_data;
+		utki::flags<ready> readiness;
+
+		// used to distinguish stale ready list entries of the waitables
+		// which were removed and added again
+		uint64_t generation;
+
+		bool in_ready_list = false;
+	};
+
+	struct ready_list_entry {
+		const waitable* w;
+		uint64_t generation;
+	};
+
+	std::mutex mutex;
+	std::condition_variable cv;
+
+	std::unordered_map<const waitable*, registration> registrations;
+
+	uint64_t next_generation = 0;
+
+	// waitables which could be ready, in the order of reporting
+	std::vector<ready_list_entry> ready_list;
+
+	// buffers used to reorder ready list entries during wait
+	std::vector<ready_list_entry> ready_list_unreached;
+	std::vector<ready_list_entry> ready_list_reported;
+
+	bool interrupt_pending = false;
+
+	void update_ready_list(const waitable& w, registration& r);
+
+	size_t collect_events(utki::span<event_info> out_events);
+
+public:
+	simulation_backend() = default;
+
+	simulation_backend(const simulation_backend&) = delete;
+	simulation_backend& operator=(const simulation_backend&) = delete;
+
+	simulation_backend(simulation_backend&&) = delete;
+	simulation_backend& operator=(simulation_backend&&) = delete;
+
+	~simulation_backend() override = default;
+
+	/**
+	 * @brief Set readiness of the waitable.
+	 * @param w - waitable added to the wait_set.
+	 * @param readiness - new readiness flags of the waitable.
+	 * @throw std::logic_error - in case the waitable is not added to the wait_set.
+	 */
+	void set_readiness(const waitable& w, utki::flags<ready> readiness);
+
+	/**
+	 * @brief Get readiness of the waitable.
+	 * @param w - waitable added to the wait_set.
+	 * @return Readiness flags of the waitable.
+	 * @throw std::logic_error - in case the waitable is not added to the wait_set.
+	 */
+	utki::flags<ready> get_readiness(const waitable& w);
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
@@ -0,0 +1,224 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "tcp_socket.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cerrno>
+#	include <climits>
+#	include <system_error>
+
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+endpoint get_local_address(int fd, const char* error_message)
+{
+	endpoint ret;
+	socklen_t size = endpoint::capacity();
+	if (getsockname(fd, ret.get_sockaddr(), &size) < 0) {
+		throw std::system_error(errno, std::generic_category(), error_message);
+	}
+	ret.set_size(size);
+	return ret;
+}
+} // namespace
+
+tcp_socket::tcp_socket(const endpoint& remote) :
+	waitable([&]() {
+		int fd = ::socket(remote.get_family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "tcp_socket::tcp_socket(): socket() failed");
+		}
+		if (::connect(fd, remote.get_sockaddr(), remote.size()) < 0 && errno != EINPROGRESS) {
+			auto err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "tcp_socket::tcp_socket(): connect() failed");
+		}
+		return fd;
+	}())
+{}
+
+tcp_socket::~tcp_socket()
+{
+	close(this->handle);
+}
+
+int tcp_socket::get_error()
+{
+	int error = 0;
+	socklen_t size = sizeof(error);
+	if (getsockopt(this->handle, SOL_SOCKET, SO_ERROR, &error, &size) < 0) {
+		return errno;
+	}
+	return error;
+}
+
+void tcp_socket::set_nodelay(bool enable)
+{
+	int value = enable ? 1 : 0;
+	if (setsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) < 0) {
+		throw std::system_error(errno, std::generic_category(), "tcp_socket::set_nodelay(): setsockopt() failed");
+	}
+}
+
+endpoint tcp_socket::get_remote_endpoint() const
+{
+	endpoint ret;
+	socklen_t size = endpoint::capacity();
+	if (getpeername(this->handle, ret.get_sockaddr(), &size) < 0) {
+		throw std::system_error(errno, std::generic_category(), "tcp_socket::get_remote_endpoint(): getpeername() failed");
+	}
+	ret.set_size(size);
+	return ret;
+}
+
+std::optional<size_t> tcp_socket::receive(utki::span<const utki::span<uint8_t>> buffers)
+{
+	auto num = std::min(buffers.size(), size_t(IOV_MAX));
+
+	if (this->iovecs.size() < num) {
+		this->iovecs.resize(num);
+	}
+
+	for (size_t i = 0; i != num; ++i) {
+		this->iovecs[i].iov_base = buffers[i].data();
+		this->iovecs[i].iov_len = buffers[i].size();
+	}
+
+	ssize_t res = 0;
+	do {
+		res = readv(this->handle, this->iovecs.data(), int(num));
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return std::nullopt;
+		}
+		throw std::system_error(errno, std::generic_category(), "tcp_socket::receive(): readv() failed");
+	}
+
+	return size_t(res);
+}
+
+size_t tcp_socket::send(utki::span<const utki::span<const uint8_t>> buffers)
+{
+	auto num = std::min(buffers.size(), size_t(IOV_MAX));
+
+	if (this->iovecs.size() < num) {
+		this->iovecs.resize(num);
+	}
+
+	for (size_t i = 0; i != num; ++i) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast, "writev() does not modify the data")
+		this->iovecs[i].iov_base = const_cast<uint8_t*>(buffers[i].data());
+		this->iovecs[i].iov_len = buffers[i].size();
+	}
+
+	// sendmsg() is used instead of writev() to avoid SIGPIPE in case the peer has closed the connection
+	msghdr h{};
+	h.msg_iov = this->iovecs.data();
+	h.msg_iovlen = num;
+
+	ssize_t res = 0;
+	do {
+		res = sendmsg(this->handle, &h, MSG_DONTWAIT | MSG_NOSIGNAL);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		}
+		throw std::system_error(errno, std::generic_category(), "tcp_socket::send(): sendmsg() failed");
+	}
+
+	return size_t(res);
+}
+
+tcp_acceptor::tcp_acceptor(const endpoint& local, int backlog) :
+	waitable([&]() {
+		int fd = ::socket(local.get_family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "tcp_acceptor::tcp_acceptor(): socket() failed");
+		}
+
+		int reuse = 1;
+		if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+			auto err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "tcp_acceptor::tcp_acceptor(): setsockopt() failed");
+		}
+
+		if (::bind(fd, local.get_sockaddr(), local.size()) < 0) {
+			auto err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "tcp_acceptor::tcp_acceptor(): bind() failed");
+		}
+
+		if (::listen(fd, backlog) < 0) {
+			auto err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "tcp_acceptor::tcp_acceptor(): listen() failed");
+		}
+		return fd;
+	}())
+{}
+
+tcp_acceptor::~tcp_acceptor()
+{
+	close(this->handle);
+}
+
+endpoint tcp_acceptor::get_local_endpoint() const
+{
+	return get_local_address(this->handle, "tcp_acceptor::get_local_endpoint(): getsockname() failed");
+}
+
+std::unique_ptr<tcp_socket> tcp_acceptor::accept()
+{
+	int fd = -1;
+	do {
+		fd = accept4(this->handle, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	} while (fd < 0 && errno == EINTR);
+
+	if (fd < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return nullptr;
+		}
+		throw std::system_error(errno, std::generic_category(), "tcp_acceptor::accept(): accept4() failed");
+	}
+
+	// tcp_socket constructor is private, so std::make_unique() cannot be used
+	return std::unique_ptr<tcp_socket>(new tcp_socket(fd));
+}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <memory>
+#	include <optional>
+#	include <vector>
+
+#	include <sys/uio.h>
+#	include <utki/span.hpp>
+
+#	include "endpoint.hpp"
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Non-blocking TCP connection socket.
+ * The waitable is ready to read when there is data to receive or the peer has closed the connection,
+ * and ready to write when data can be sent. Data is received to and sent from several caller-provided
+ * buffers with a single system call, so the buffers can be taken from a buffer pool and the stream
+ * can be drained into several of them at once.
+ */
+class tcp_socket final : public waitable
+{
+	friend class tcp_acceptor;
+
+	// reusable system call argument buffer
+	std::vector<iovec> iovecs;
+
+	tcp_socket(int fd) :
+		waitable(fd)
+	{}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Starts connecting to the remote address. Does not block, the socket becomes ready to write
+	 * when the connection is established or has failed, see get_error().
+	 * @param remote - address to connect to.
+	 * @throw std::system_error - in case creating the socket or starting the connection has failed.
+	 */
+	tcp_socket(const endpoint& remote);
+
+	tcp_socket(const tcp_socket&) = delete;
+	tcp_socket& operator=(const tcp_socket&) = delete;
+
+	tcp_socket(tcp_socket&&) = delete;
+	tcp_socket& operator=(tcp_socket&&) = delete;
+
+	~tcp_socket();
+
+	/**
+	 * @brief Get pending socket error.
+	 * Can be used to check if the connection has been established successfully after the socket
+	 * has become ready to write. Clears the pending error.
+	 * @return error code of the socket, 0 if there is no error.
+	 */
+	int get_error();
+
+	/**
+	 * @brief Enable or disable Nagle's algorithm.
+	 * @param enable - true to disable Nagle's algorithm, i.e. to send data right away.
+	 * @throw std::system_error - in case setting the option has failed.
+	 */
+	void set_nodelay(bool enable);
+
+	/**
+	 * @brief Get remote address.
+	 * @return address of the peer.
+	 * @throw std::system_error - in case the socket is not connected.
+	 */
+	endpoint get_remote_endpoint() const;
+
+	/**
+	 * @brief Receive data.
+	 * Fills the buffers one after another with single readv() call. Does not block.
+	 * @param buffers - buffers to receive the data to.
+	 * @return total number of received bytes.
+	 * @return 0 in case the peer has closed the connection.
+	 * @return std::nullopt in case there is no data to receive.
+	 * @throw std::system_error - in case receiving has failed.
+	 */
+	std::optional<size_t> receive(utki::span<const utki::span<uint8_t>> buffers);
+
+	/**
+	 * @brief Send data.
+	 * Sends data from the buffers one after another with single system call. Does not block.
+	 * @param buffers - buffers holding the data to send.
+	 * @return total number of sent bytes, can be less than the total size of the buffers.
+	 *         0 in case the socket is not ready to send.
+	 * @throw std::system_error - in case sending has failed.
+	 */
+	size_t send(utki::span<const utki::span<const uint8_t>> buffers);
+};
+
+/**
+ * @brief Non-blocking TCP listening socket.
+ * The waitable is ready to read when there are incoming connections to accept.
+ */
+class tcp_acceptor final : public waitable
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * Creates socket listening on the given local address.
+	 * @param local - local address to listen on. Port 0 means any free port.
+	 * @param backlog - maximum length of the queue of pending connections.
+	 * @throw std::system_error - in case creating the socket or starting listening has failed.
+	 */
+	tcp_acceptor(const endpoint& local, int backlog = 128);
+
+	tcp_acceptor(const tcp_acceptor&) = delete;
+	tcp_acceptor& operator=(const tcp_acceptor&) = delete;
+
+	tcp_acceptor(tcp_acceptor&&) = delete;
+	tcp_acceptor& operator=(tcp_acceptor&&) = delete;
+
+	~tcp_acceptor();
+
+	/**
+	 * @brief Get local address.
+	 * @return address the socket is listening on.
+	 */
+	endpoint get_local_endpoint() const;
+
+	/**
+	 * @brief Accept incoming connection.
+	 * Does not block.
+	 * @return accepted connection socket.
+	 * @return nullptr in case there are no incoming connections.
+	 * @throw std::system_error - in case accepting has failed.
+	 */
+	std::unique_ptr<tcp_socket> accept();
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,200 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+
+#include "trace_recorder.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+namespace opros {
+
+namespace {
+OPROS_INLINE size_t round_up_to_power_of_2(size_t n)
+{
+	size_t ret = 1;
+	while (ret < n) {
+		ret <<= 1;
+	}
+	return ret;
+}
+
+OPROS_INLINE const char* to_name(trace_recorder::record_type type)
+{
+	switch (type) {
+		case trace_recorder::record_type::wait_begin:
+		case trace_recorder::record_type::wait_end:
+			return "wait";
+		case trace_recorder::record_type::interrupt:
+			return "interrupt";
+		case trace_recorder::record_type::event:
+			return "event";
+		case trace_recorder::record_type::add:
+			return "add";
+		case trace_recorder::record_type::change:
+			return "change";
+		case trace_recorder::record_type::remove:
+			return "remove";
+	}
+	return "unknown";
+}
+
+OPROS_INLINE void write_flags(std::ostream& o, utki::flags<ready> flags)
+{
+	o << '"';
+	bool first = true;
+	for (auto [flag, name] : {
+			 std::make_pair(ready::read, "read"),
+			 std::make_pair(ready::write, "write"),
+			 std::make_pair(ready::error, "error"),
+			 std::make_pair(ready::hangup, "hangup"),
+			 std::make_pair(ready::read_hangup, "read_hangup"),
+			 std::make_pair(ready::priority, "priority")
+		 })
+	{
+		if (!flags.get(flag)) {
+			continue;
+		}
+		if (!first) {
+			o << '|';
+		}
+		first = false;
+		o << name;
+	}
+	o << '"';
+}
+} // namespace
+
+OPROS_INLINE trace_recorder::trace_recorder(size_t capacity) :
+	mask(round_up_to_power_of_2(std::max(capacity, size_t(1))) - 1),
+	slots(new slot[this->mask + 1]) // NOLINT(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays)
+{}
+
+OPROS_INLINE void trace_recorder::clear() noexcept
+{
+	for (size_t i = 0; i != this->capacity(); ++i) {
+		this->slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+	this->head.store(0, std::memory_order_relaxed);
+}
+
+OPROS_INLINE void trace_recorder::dump_chrome_trace(std::ostream& o) const
+{
+	uint64_t end = this->head.load(std::memory_order_acquire);
+	uint64_t begin = end > this->capacity() ? end - this->capacity() : 0;
+
+	// take a consistent copy of the records first
+	std::vector<entry> records;
+	records.reserve(size_t(end - begin));
+	for (uint64_t index = begin; index != end; ++index) {
+		const auto& s = this->slots[index & this->mask];
+
+		uint64_t seq = s.sequence.load(std::memory_order_acquire);
+		if (seq != index * 2 + 2) {
+			// the record is being written or was overwritten
+			continue;
+		}
+
+		entry r = s.rec;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s.sequence.load(std::memory_order_relaxed) != seq) {
+			// the record was overwritten while copying
+			continue;
+		}
+
+		records.push_back(r);
+	}
+
+	// timestamps are relative to the earliest record to keep the numbers short,
+	// the records are in the order of reserving the slots, which is not necessarily the order
+	// of the timestamps when several threads record concurrently
+	uint64_t origin = 0;
+	if (!records.empty()) {
+		auto earliest = std::min_element(records.begin(), records.end(), [](const auto& a, const auto& b) {
+			return a.timestamp < b.timestamp;
+		});
+		origin = earliest->timestamp;
+	}
+
+	auto stream_flags = o.flags();
+	auto stream_fill = o.fill();
+	o << R"({"displayTimeUnit":"ns","traceEvents":[)";
+
+	bool first = true;
+	for (const auto& r : records) {
+		if (!first) {
+			o << ',';
+		}
+		first = false;
+
+		o << '\n' << R"({"name":")" << to_name(r.type) << R"(","ph":")";
+		switch (r.type) {
+			case record_type::wait_begin:
+				o << 'B';
+				break;
+			case record_type::wait_end:
+				o << 'E';
+				break;
+			default:
+				// instant event with thread scope
+				o << R"(i","s":"t)";
+				break;
+		}
+
+		// timestamps in chrome trace format are in microseconds
+		constexpr uint64_t nanoseconds_in_microsecond = 1000;
+		auto ts = r.timestamp - origin;
+		o << R"(","pid":0,"tid":)" << r.thread << R"(,"ts":)" << (ts / nanoseconds_in_microsecond) << '.'
+		  << std::setw(3) << std::setfill('0') << (ts % nanoseconds_in_microsecond);
+
+		switch (r.type) {
+			case record_type::wait_begin:
+			case record_type::wait_end:
+			case record_type::interrupt:
+				break;
+			case record_type::event:
+			case record_type::add:
+			case record_type::change:
+				o << R"(,"args":{"user_data":")" << r.user_data << R"(","flags":)";
+				write_flags(o, r.flags);
+				o << '}';
+				break;
+			case record_type::remove:
+				o << R"(,"args":{"user_data":")" << r.user_data << R"("})";
+				break;
+		}
+
+		o << '}';
+	}
+
+	o << "\n]}\n";
+	o.flags(stream_flags);
+	o.fill(stream_fill);
+}
+
+} // namespace opros
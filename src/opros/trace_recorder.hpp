@@ -0,0 +1,226 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+#include <utki/flags.hpp>
+
+#include "config.hpp"
+#include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Recorder of wait_set activity.
+ * Lock-free ring buffer of timestamped records about wait_set operations.
+ * When the ring buffer is full, the oldest records are overwritten.
+ * Recording a single record is just an atomic increment and a few stores,
+ * so the recorder can stay enabled under load.
+ * Recorder can be attached to a wait_set with wait_set::set_trace_recorder().
+ * The same recorder can be attached to several wait_sets.
+ */
+class trace_recorder
+{
+public:
+	/**
+	 * @brief Type of the record.
+	 */
+	enum class record_type : uint8_t {
+		/**
+		 * @brief wait() was entered.
+		 */
+		wait_begin,
+
+		/**
+		 * @brief wait() is about to return.
+		 */
+		wait_end,
+
+		/**
+		 * @brief wait() was interrupted with wait_set::interrupt().
+		 */
+		interrupt,
+
+		/**
+		 * @brief wait() reported a triggered event.
+		 * The flags field holds the readiness flags of the event.
+		 */
+		event,
+
+		/**
+		 * @brief A waitable was added to the wait_set.
+		 * The flags field holds the wait flags.
+		 */
+		add,
+
+		/**
+		 * @brief A waitable's wait flags were changed.
+		 * The flags field holds the new wait flags.
+		 */
+		change,
+
+		/**
+		 * @brief A waitable was removed from the wait_set.
+		 */
+		remove
+	};
+
+	/**
+	 * @brief Trace record.
+	 */
+	struct entry {
+		/**
+		 * @brief Timestamp in nanoseconds, as returned by now().
+		 */
+		uint64_t timestamp;
+
+		/**
+		 * @brief User data of the waitable the record is about.
+		 */
+		const void* user_data;
+
+		/**
+		 * @brief Identifier of the thread which has made the record.
+		 */
+		uint32_t thread;
+
+		record_type type;
+
+		utki::flags<ready> flags;
+	};
+
+private:
+	struct slot {
+		// odd value means the record is being written
+		std::atomic<uint64_t> sequence{0};
+		entry rec;
+	};
+
+	const size_t mask;
+	std::unique_ptr<slot[]> slots; // NOLINT(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays)
+
+	std::atomic<uint64_t> head{0};
+
+	static uint32_t get_thread_id() noexcept
+	{
+		static std::atomic<uint32_t> next_id{0};
+		thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of records to keep, rounded up to power of 2.
+	 */
+	trace_recorder(size_t capacity = 1 << 16);
+
+	trace_recorder(const trace_recorder&) = delete;
+	trace_recorder& operator=(const trace_recorder&) = delete;
+
+	trace_recorder(trace_recorder&&) = delete;
+	trace_recorder& operator=(trace_recorder&&) = delete;
+
+	~trace_recorder() = default;
+
+	/**
+	 * @brief Get maximum number of records kept.
+	 * @return Capacity of the ring buffer.
+	 */
+	size_t capacity() const noexcept
+	{
+		return this->mask + 1;
+	}
+
+	/**
+	 * @brief Get current timestamp.
+	 * @return Monotonic timestamp in nanoseconds.
+	 */
+	static uint64_t now() noexcept
+	{
+		return uint64_t(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+				.count()
+		);
+	}
+
+	/**
+	 * @brief Add a record.
+	 * Thread-safe.
+	 * @param type - type of the record.
+	 * @param timestamp - timestamp of the record, as returned by now().
+	 * @param user_data - user data of the waitable the record is about.
+	 * @param flags - readiness or wait flags of the record.
+	 */
+	void record(
+		record_type type,
+		uint64_t timestamp,
+		const void* user_data = nullptr,
+		utki::flags<ready> flags = false
+	) noexcept
+	{
+		uint64_t index = this->head.fetch_add(1, std::memory_order_relaxed);
+		auto& s = this->slots[index & this->mask];
+
+		s.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		s.rec.timestamp = timestamp;
+		s.rec.user_data = user_data;
+		s.rec.thread = get_thread_id();
+		s.rec.type = type;
+		s.rec.flags = flags;
+
+		s.sequence.store(index * 2 + 2, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Discard all records.
+	 * Should not be called concurrently with record().
+	 */
+	void clear() noexcept;
+
+	/**
+	 * @brief Write the records in Chrome trace event format.
+	 * The output is JSON which can be loaded to chrome://tracing or Perfetto UI.
+	 * Each wait() call is shown as a duration event, other records are shown as instant events.
+	 * Can be called concurrently with record(), records being written at the moment are skipped.
+	 * @param o - output stream to write JSON to.
+	 */
+	void dump_chrome_trace(std::ostream& o) const;
+};
+
+} // namespace opros
+
+#ifdef OPROS_HEADER_ONLY
+#	include "trace_recorder.cpp"
+#endif
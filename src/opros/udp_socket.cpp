@@ -0,0 +1,168 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "udp_socket.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cerrno>
+#	include <limits>
+#	include <system_error>
+
+#	include <unistd.h>
+
+using namespace opros;
+
+udp_socket::udp_socket(const endpoint& local) :
+	waitable([&]() {
+		int fd = ::socket(local.get_family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "udp_socket::udp_socket(): socket() failed");
+		}
+		if (::bind(fd, local.get_sockaddr(), local.size()) < 0) {
+			auto err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "udp_socket::udp_socket(): bind() failed");
+		}
+		return fd;
+	}())
+{}
+
+udp_socket::~udp_socket()
+{
+	close(this->handle);
+}
+
+endpoint udp_socket::get_local_endpoint() const
+{
+	endpoint ret;
+	socklen_t size = endpoint::capacity();
+	if (getsockname(this->handle, ret.get_sockaddr(), &size) < 0) {
+		throw std::system_error(errno, std::generic_category(), "udp_socket::get_local_endpoint(): getsockname() failed");
+	}
+	ret.set_size(size);
+	return ret;
+}
+
+void udp_socket::prepare_headers(size_t size)
+{
+	if (this->headers.size() < size) {
+		this->headers.resize(size);
+		this->iovecs.resize(size);
+	}
+}
+
+size_t udp_socket::receive(utki::span<datagram> batch)
+{
+	if (batch.empty()) {
+		return 0;
+	}
+
+	auto num = unsigned(std::min(batch.size(), size_t(std::numeric_limits<unsigned>::max())));
+
+	this->prepare_headers(num);
+
+	for (size_t i = 0; i != num; ++i) {
+		auto& d = batch[i];
+		auto& iov = this->iovecs[i];
+		iov.iov_base = d.buffer.data();
+		iov.iov_len = d.buffer.size();
+
+		auto& h = this->headers[i].msg_hdr;
+		h = {};
+		h.msg_name = d.peer.get_sockaddr();
+		h.msg_namelen = endpoint::capacity();
+		h.msg_iov = &iov;
+		h.msg_iovlen = 1;
+	}
+
+	int res = 0;
+	do {
+		res = recvmmsg(this->handle, this->headers.data(), num, MSG_DONTWAIT, nullptr);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		}
+		throw std::system_error(errno, std::generic_category(), "udp_socket::receive(): recvmmsg() failed");
+	}
+
+	for (size_t i = 0; i != size_t(res); ++i) {
+		auto& d = batch[i];
+		const auto& h = this->headers[i];
+		d.size = h.msg_len;
+		d.peer.set_size(h.msg_hdr.msg_namelen);
+		d.truncated = (unsigned(h.msg_hdr.msg_flags) & MSG_TRUNC) != 0;
+	}
+
+	return size_t(res);
+}
+
+size_t udp_socket::send(utki::span<const datagram> batch)
+{
+	if (batch.empty()) {
+		return 0;
+	}
+
+	auto num = unsigned(std::min(batch.size(), size_t(std::numeric_limits<unsigned>::max())));
+
+	this->prepare_headers(num);
+
+	for (size_t i = 0; i != num; ++i) {
+		const auto& d = batch[i];
+		utki::assert(d.size <= d.buffer.size(), SL);
+
+		auto& iov = this->iovecs[i];
+		iov.iov_base = d.buffer.data();
+		iov.iov_len = d.size;
+
+		auto& h = this->headers[i].msg_hdr;
+		h = {};
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast, "sendmmsg() does not modify the address")
+		h.msg_name = const_cast<sockaddr*>(d.peer.get_sockaddr());
+		h.msg_namelen = d.peer.size();
+		h.msg_iov = &iov;
+		h.msg_iovlen = 1;
+	}
+
+	int res = 0;
+	do {
+		res = sendmmsg(this->handle, this->headers.data(), num, MSG_DONTWAIT);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		}
+		throw std::system_error(errno, std::generic_category(), "udp_socket::send(): sendmmsg() failed");
+	}
+
+	return size_t(res);
+}
+
+#endif
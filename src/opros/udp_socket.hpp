@@ -0,0 +1,140 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <vector>
+
+#	include <sys/socket.h>
+#	include <sys/uio.h>
+#	include <utki/span.hpp>
+
+#	include "endpoint.hpp"
+#	include "waitable.hpp"
+
+namespace opros {
+
+/**
+ * @brief Non-blocking UDP socket.
+ * The waitable is ready to read when there are datagrams to receive and ready to write
+ * when datagrams can be sent.
+ * Datagrams are received and sent in batches with a single system call,
+ * so one readiness notification can be handled by draining up to a batch of datagrams at once.
+ * The datagram buffers are provided by the caller, so that those can be taken from a buffer pool
+ * and reused without copying.
+ */
+class udp_socket final : public waitable
+{
+	// reusable system call argument buffers
+	std::vector<mmsghdr> headers;
+	std::vector<iovec> iovecs;
+
+	void prepare_headers(size_t size);
+
+public:
+	/**
+	 * @brief Datagram.
+	 */
+	struct datagram {
+		/**
+		 * @brief Datagram data buffer.
+		 * For receiving, the buffer to receive the datagram to.
+		 * For sending, the buffer holding the datagram data.
+		 */
+		utki::span<uint8_t> buffer;
+
+		/**
+		 * @brief Size of the datagram.
+		 * For receiving, set to the size of the received datagram.
+		 * For sending, the number of bytes from the buffer to send.
+		 */
+		size_t size = 0;
+
+		/**
+		 * @brief Peer address.
+		 * For receiving, set to the address of the sender.
+		 * For sending, the address of the recipient.
+		 */
+		endpoint peer;
+
+		/**
+		 * @brief Whether the received datagram was bigger than the buffer and was truncated.
+		 */
+		bool truncated = false;
+	};
+
+	/**
+	 * @brief Constructor.
+	 * Creates socket bound to the given local address.
+	 * @param local - local address to bind to. Port 0 means any free port.
+	 * @throw std::system_error - in case creating or binding the socket has failed.
+	 */
+	udp_socket(const endpoint& local);
+
+	udp_socket(const udp_socket&) = delete;
+	udp_socket& operator=(const udp_socket&) = delete;
+
+	udp_socket(udp_socket&&) = delete;
+	udp_socket& operator=(udp_socket&&) = delete;
+
+	~udp_socket();
+
+	/**
+	 * @brief Get local address.
+	 * @return address the socket is bound to.
+	 */
+	endpoint get_local_endpoint() const;
+
+	/**
+	 * @brief Receive datagrams.
+	 * Receives as many datagrams as are available, up to the number of the given datagram buffers,
+	 * with single recvmmsg() call. Does not block.
+	 * @param batch - datagrams to receive to. The buffers must be set, the sizes and peers are filled in
+	 *                for the received datagrams.
+	 * @return number of received datagrams, they are in the beginning of the batch.
+	 *         0 in case there were no datagrams to receive.
+	 * @throw std::system_error - in case receiving has failed.
+	 */
+	size_t receive(utki::span<datagram> batch);
+
+	/**
+	 * @brief Send datagrams.
+	 * Sends the datagrams with single sendmmsg() call. Does not block.
+	 * @param batch - datagrams to send.
+	 * @return number of sent datagrams, from the beginning of the batch.
+	 *         0 in case the socket is not ready to send.
+	 * @throw std::system_error - in case sending has failed.
+	 */
+	size_t send(utki::span<const datagram> batch);
+};
+
+} // namespace opros
+
+#endif
@@ -0,0 +1,389 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "uring.hpp"
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <algorithm>
+#	include <cstring>
+#	include <system_error>
+
+#	include <linux/io_uring.h>
+#	include <sys/eventfd.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+
+using namespace opros;
+
+namespace {
+int io_uring_setup(unsigned entries, io_uring_params* p)
+{
+	return int(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+	return int(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+int create_eventfd()
+{
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "uring::uring(): eventfd() failed");
+	}
+	return fd;
+}
+
+template <typename type>
+type* at_offset(void* base, size_t offset) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return reinterpret_cast<type*>(std::next(static_cast<uint8_t*>(base), ptrdiff_t(offset)));
+}
+
+// NOTE: the ring heads and tails are shared with the kernel, so those are accessed with atomic builtins
+
+unsigned load_acquire(const unsigned* p) noexcept
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void store_release(unsigned* p, unsigned v) noexcept
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+} // namespace
+
+uring::uring(unsigned entries) :
+	waitable(create_eventfd())
+{
+	io_uring_params params{};
+
+	this->ring_fd = io_uring_setup(entries, &params);
+	if (this->ring_fd < 0) {
+		auto err = errno;
+		close(this->handle);
+		throw std::system_error(err, std::generic_category(), "uring::uring(): io_uring_setup() failed");
+	}
+
+	try {
+		this->sq_ring.size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		this->cq_ring.size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+		bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap) {
+			this->sq_ring.size = std::max(this->sq_ring.size, this->cq_ring.size);
+		}
+
+		auto map = [this](mapping& m, off_t offset) {
+			m.ptr = mmap(nullptr, m.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, offset);
+			if (m.ptr == MAP_FAILED) {
+				m.ptr = nullptr;
+				throw std::system_error(errno, std::generic_category(), "uring::uring(): mmap() failed");
+			}
+		};
+
+		map(this->sq_ring, IORING_OFF_SQ_RING);
+
+		void* cq_ring_ptr = this->sq_ring.ptr;
+		if (!single_mmap) {
+			map(this->cq_ring, IORING_OFF_CQ_RING);
+			cq_ring_ptr = this->cq_ring.ptr;
+		}
+
+		this->sqes_mapping.size = params.sq_entries * sizeof(io_uring_sqe);
+		map(this->sqes_mapping, IORING_OFF_SQES);
+
+		this->sq_head = at_offset<unsigned>(this->sq_ring.ptr, params.sq_off.head);
+		this->sq_tail = at_offset<unsigned>(this->sq_ring.ptr, params.sq_off.tail);
+		this->sq_flags = at_offset<unsigned>(this->sq_ring.ptr, params.sq_off.flags);
+		this->sq_mask = *at_offset<unsigned>(this->sq_ring.ptr, params.sq_off.ring_mask);
+		this->sq_entries = params.sq_entries;
+		this->sq_array = at_offset<unsigned>(this->sq_ring.ptr, params.sq_off.array);
+		this->sqes = static_cast<io_uring_sqe*>(this->sqes_mapping.ptr);
+		this->sq_local_tail = *this->sq_tail;
+		this->sq_submitted_tail = this->sq_local_tail;
+
+		this->cq_head = at_offset<unsigned>(cq_ring_ptr, params.cq_off.head);
+		this->cq_tail = at_offset<unsigned>(cq_ring_ptr, params.cq_off.tail);
+		this->cq_mask = *at_offset<unsigned>(cq_ring_ptr, params.cq_off.ring_mask);
+		this->cqes = at_offset<io_uring_cqe>(cq_ring_ptr, params.cq_off.cqes);
+
+		if (io_uring_register(this->ring_fd, IORING_REGISTER_EVENTFD, &this->handle, 1) < 0) {
+			throw std::system_error(errno, std::generic_category(), "uring::uring(): registering eventfd failed");
+		}
+
+		this->completions.reserve(params.cq_entries);
+	} catch (...) {
+		this->destroy();
+		throw;
+	}
+}
+
+uring::~uring()
+{
+	this->destroy();
+}
+
+void uring::destroy() noexcept
+{
+	for (auto m : {this->sqes_mapping, this->cq_ring, this->sq_ring}) {
+		if (m.ptr) {
+			munmap(m.ptr, m.size);
+		}
+	}
+	close(this->ring_fd);
+	close(this->handle);
+}
+
+void uring::register_buffers(utki::span<const utki::span<uint8_t>> buffers)
+{
+	std::vector<iovec> iovecs;
+	iovecs.reserve(buffers.size());
+	for (const auto& b : buffers) {
+		iovecs.push_back({b.data(), b.size()});
+	}
+
+	if (io_uring_register(this->ring_fd, IORING_REGISTER_BUFFERS, iovecs.data(), unsigned(iovecs.size())) < 0) {
+		throw std::system_error(errno, std::generic_category(), "uring::register_buffers(): io_uring_register() failed");
+	}
+}
+
+void uring::unregister_buffers()
+{
+	if (io_uring_register(this->ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0) < 0) {
+		throw std::system_error(
+			errno,
+			std::generic_category(),
+			"uring::unregister_buffers(): io_uring_register() failed"
+		);
+	}
+}
+
+io_uring_sqe* uring::get_sqe() noexcept
+{
+	unsigned tail = this->sq_local_tail;
+	unsigned head = load_acquire(this->sq_head);
+
+	if (tail - head == this->sq_entries) {
+		return nullptr;
+	}
+
+	unsigned index = tail & this->sq_mask;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	auto sqe = &this->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	this->sq_array[index] = index;
+
+	// the tail is published to the kernel in submit()
+	++this->sq_local_tail;
+
+	return sqe;
+}
+
+namespace {
+void prepare_rw(
+	io_uring_sqe& sqe,
+	uint8_t opcode,
+	int fd,
+	const void* addr,
+	size_t len,
+	uint64_t offset,
+	uint64_t user_data
+)
+{
+	sqe.opcode = opcode;
+	sqe.fd = fd;
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	sqe.addr = reinterpret_cast<uint64_t>(addr);
+	sqe.len = uint32_t(len);
+	sqe.off = offset;
+	sqe.user_data = user_data;
+}
+} // namespace
+
+bool uring::queue_read(int fd, utki::span<uint8_t> buf, uint64_t offset, uint64_t user_data) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_READ, fd, buf.data(), buf.size(), offset, user_data);
+	return true;
+}
+
+bool uring::queue_read_fixed(
+	int fd,
+	utki::span<uint8_t> buf,
+	unsigned buf_index,
+	uint64_t offset,
+	uint64_t user_data
+) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_READ_FIXED, fd, buf.data(), buf.size(), offset, user_data);
+	sqe->buf_index = uint16_t(buf_index);
+	return true;
+}
+
+bool uring::queue_write(int fd, utki::span<const uint8_t> buf, uint64_t offset, uint64_t user_data) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_WRITE, fd, buf.data(), buf.size(), offset, user_data);
+	return true;
+}
+
+bool uring::queue_write_fixed(
+	int fd,
+	utki::span<const uint8_t> buf,
+	unsigned buf_index,
+	uint64_t offset,
+	uint64_t user_data
+) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_WRITE_FIXED, fd, buf.data(), buf.size(), offset, user_data);
+	sqe->buf_index = uint16_t(buf_index);
+	return true;
+}
+
+bool uring::queue_fsync(int fd, bool data_only, uint64_t user_data) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_FSYNC, fd, nullptr, 0, 0, user_data);
+	sqe->fsync_flags = data_only ? IORING_FSYNC_DATASYNC : 0;
+	return true;
+}
+
+bool uring::queue_openat(int dir_fd, const char* path, int flags, mode_t mode, uint64_t user_data) noexcept
+{
+	auto sqe = this->get_sqe();
+	if (!sqe) {
+		return false;
+	}
+	prepare_rw(*sqe, IORING_OP_OPENAT, dir_fd, path, mode, 0, user_data);
+	sqe->open_flags = uint32_t(flags);
+	return true;
+}
+
+unsigned uring::submit()
+{
+	unsigned to_submit = this->num_queued_operations();
+	if (to_submit == 0) {
+		return 0;
+	}
+
+	// publish queued entries to the kernel
+	store_release(this->sq_tail, this->sq_local_tail);
+
+	int res{};
+	while (true) {
+		res = io_uring_enter(this->ring_fd, to_submit, 0, 0);
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "uring::submit(): io_uring_enter() failed");
+		}
+		break;
+	}
+
+	// the kernel consumes submission queue entries in order, so the rest stay queued
+	this->sq_submitted_tail += unsigned(res);
+
+	return unsigned(res);
+}
+
+utki::span<const uring::completion> uring::get_completions()
+{
+	// reset the eventfd before fetching completions, so that completions arriving
+	// after fetching would trigger the waitable again
+	eventfd_t value = 0;
+	if (eventfd_read(this->handle, &value) < 0) {
+		utki::assert(errno == EAGAIN, SL);
+	}
+
+	this->completions.clear();
+
+	for (;;) {
+		// the head is only written by us, so no need to load it atomically
+		unsigned head = *this->cq_head;
+		unsigned tail = load_acquire(this->cq_tail);
+
+		for (; head != tail; ++head) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			const auto& cqe = this->cqes[head & this->cq_mask];
+			this->completions.push_back({cqe.user_data, cqe.res, cqe.flags});
+		}
+
+		store_release(this->cq_head, head);
+
+		// completions which did not fit into the completion queue are kept by the kernel
+		// in the overflow list, those are flushed to the completion queue by io_uring_enter()
+		if ((load_acquire(this->sq_flags) & IORING_SQ_CQ_OVERFLOW) == 0) {
+			break;
+		}
+
+		if (io_uring_enter(this->ring_fd, 0, 0, IORING_ENTER_GETEVENTS) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "uring::get_completions(): io_uring_enter() failed");
+		}
+
+		if (load_acquire(this->cq_tail) == head) {
+			// nothing has been flushed
+			break;
+		}
+	}
+
+	return this->completions;
+}
+
+#endif
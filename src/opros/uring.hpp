@@ -0,0 +1,261 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_LINUX
+
+#	include <cstdint>
+#	include <vector>
+
+#	include <sys/types.h>
+#	include <sys/uio.h>
+#	include <utki/span.hpp>
+
+#	include "waitable.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace opros {
+
+/**
+ * @brief io_uring based asynchronous I/O waitable.
+ * Owns an io_uring instance with an eventfd registered to it. The waitable becomes
+ * ready to read when there are completions in the completion queue.
+ * Operations are queued with queue_*() functions and passed to the kernel all at once
+ * with submit(). When the waitable triggers, the completions are fetched with get_completions().
+ * Requires Linux 5.6 or later.
+ */
+class uring final : public waitable
+{
+public:
+	/**
+	 * @brief Completion of an operation.
+	 */
+	struct completion {
+		/**
+		 * @brief User data given when the operation was queued.
+		 */
+		uint64_t user_data;
+
+		/**
+		 * @brief Result of the operation.
+		 * Same as the return value of the corresponding system call,
+		 * except that the error is returned as negative errno value.
+		 */
+		int32_t result;
+
+		/**
+		 * @brief Completion flags.
+		 */
+		uint32_t flags;
+	};
+
+private:
+	int ring_fd;
+
+	struct mapping {
+		void* ptr = nullptr;
+		size_t size = 0;
+	};
+
+	mapping sq_ring;
+	mapping cq_ring;
+	mapping sqes_mapping;
+
+	unsigned* sq_head;
+	unsigned* sq_tail;
+	unsigned* sq_flags;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	unsigned* sq_array;
+	io_uring_sqe* sqes;
+
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned cq_mask;
+	io_uring_cqe* cqes;
+
+	// tail of the submission queue including the entries not yet published to the kernel
+	unsigned sq_local_tail;
+
+	// position in the submission queue up to which the entries were submitted with io_uring_enter()
+	unsigned sq_submitted_tail;
+
+	std::vector<completion> completions;
+
+	void destroy() noexcept;
+
+	io_uring_sqe* get_sqe() noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param entries - submission queue size, the completion queue is twice as big.
+	 * @throw std::system_error - in case io_uring could not be created,
+	 *                            e.g. it is not supported by the kernel.
+	 */
+	uring(unsigned entries = 256);
+
+	uring(const uring&) = delete;
+	uring& operator=(const uring&) = delete;
+
+	uring(uring&&) = delete;
+	uring& operator=(uring&&) = delete;
+
+	~uring();
+
+	/**
+	 * @brief Register buffers for fixed buffer operations.
+	 * The buffers must stay valid until unregistered or the uring is destroyed.
+	 * @param buffers - buffers to register.
+	 * @throw std::system_error - in case registration has failed.
+	 */
+	void register_buffers(utki::span<const utki::span<uint8_t>> buffers);
+
+	/**
+	 * @brief Unregister buffers registered by register_buffers().
+	 * @throw std::system_error - in case unregistration has failed.
+	 */
+	void unregister_buffers();
+
+	/**
+	 * @brief Queue read operation.
+	 * The buffer must stay valid until the operation completes.
+	 * @param fd - file descriptor to read from.
+	 * @param buf - buffer to read to.
+	 * @param offset - file offset to read at, uint64_t(-1) to use the current file position.
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_read(int fd, utki::span<uint8_t> buf, uint64_t offset, uint64_t user_data) noexcept;
+
+	/**
+	 * @brief Queue read operation to a registered buffer.
+	 * @param fd - file descriptor to read from.
+	 * @param buf - part of the registered buffer to read to.
+	 * @param buf_index - index of the registered buffer.
+	 * @param offset - file offset to read at, uint64_t(-1) to use the current file position.
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_read_fixed(
+		int fd,
+		utki::span<uint8_t> buf,
+		unsigned buf_index,
+		uint64_t offset,
+		uint64_t user_data
+	) noexcept;
+
+	/**
+	 * @brief Queue write operation.
+	 * The buffer must stay valid until the operation completes.
+	 * @param fd - file descriptor to write to.
+	 * @param buf - data to write.
+	 * @param offset - file offset to write at, uint64_t(-1) to use the current file position.
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_write(int fd, utki::span<const uint8_t> buf, uint64_t offset, uint64_t user_data) noexcept;
+
+	/**
+	 * @brief Queue write operation from a registered buffer.
+	 * @param fd - file descriptor to write to.
+	 * @param buf - part of the registered buffer to write.
+	 * @param buf_index - index of the registered buffer.
+	 * @param offset - file offset to write at, uint64_t(-1) to use the current file position.
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_write_fixed(
+		int fd,
+		utki::span<const uint8_t> buf,
+		unsigned buf_index,
+		uint64_t offset,
+		uint64_t user_data
+	) noexcept;
+
+	/**
+	 * @brief Queue fsync operation.
+	 * @param fd - file descriptor to sync.
+	 * @param data_only - whether to sync only data, like fdatasync().
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_fsync(int fd, bool data_only, uint64_t user_data) noexcept;
+
+	/**
+	 * @brief Queue openat operation.
+	 * The result of the completion is the opened file descriptor.
+	 * @param dir_fd - directory file descriptor, AT_FDCWD for current working directory.
+	 * @param path - path of the file to open, must stay valid until submit() returns.
+	 * @param flags - open flags.
+	 * @param mode - file mode, used when creating the file.
+	 * @param user_data - user data to report with the completion.
+	 * @return true if the operation is queued.
+	 * @return false if the submission queue is full, submit() is needed.
+	 */
+	bool queue_openat(int dir_fd, const char* path, int flags, mode_t mode, uint64_t user_data) noexcept;
+
+	/**
+	 * @brief Get number of queued, but not yet submitted operations.
+	 * @return number of queued operations.
+	 */
+	unsigned num_queued_operations() const noexcept
+	{
+		return this->sq_local_tail - this->sq_submitted_tail;
+	}
+
+	/**
+	 * @brief Submit queued operations to the kernel.
+	 * Does not wait for completions.
+	 * @return number of submitted operations.
+	 * @throw std::system_error - in case submission has failed.
+	 */
+	unsigned submit();
+
+	/**
+	 * @brief Get completions.
+	 * Does not block. Fetches all completions from the completion queue.
+	 * In case the completion queue has overflown, the completions kept by the kernel
+	 * in its overflow list are flushed to the completion queue and fetched as well.
+	 * @return completions, valid till the next call to get_completions().
+	 * @throw std::system_error - in case flushing the overflown completions has failed.
+	 */
+	utki::span<const completion> get_completions();
+};
+
+} // namespace opros
+
+#endif
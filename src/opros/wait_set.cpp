@@ -26,623 +26,275 @@ SOFTWARE.
 
 #include "wait_set.hpp"
 
-#include <cstring>
-#include <ratio>
-
-#include <utki/string.hpp>
-#include <utki/util.hpp>
-
-#if CFG_OS == CFG_OS_MACOSX
-#	include <sys/time.h>
-#endif
-
-using namespace opros;
-
-wait_set::wait_set(unsigned capacity) :
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace opros {
+
+OPROS_INLINE wait_set::wait_set(unsigned capacity) :
+	wait_set(capacity, wait_set_pool::item{capacity, nullptr, {}}, nullptr)
+{}
+
+OPROS_INLINE wait_set::wait_set(unsigned capacity, std::unique_ptr<opros::backend> backend) :
+	wait_set(
+		capacity,
+		[&]() {
+			if (!backend) {
+				throw std::invalid_argument("wait_set::wait_set(): backend is nullptr");
+			}
+			return wait_set_pool::item{capacity, std::move(backend), {}};
+		}(),
+		nullptr,
+		true
+	)
+{}
+
+OPROS_INLINE wait_set::wait_set(unsigned capacity, wait_set_pool& pool) :
+	wait_set(capacity, pool.acquire(capacity), &pool)
+{}
+
+OPROS_INLINE wait_set::wait_set(
+	unsigned capacity, //
+	wait_set_pool::item&& resources,
+	wait_set_pool* pool,
+	bool custom_backend
+) :
 	wait_set_capacity(capacity),
-	out_events_variant([this]() {
-		decltype(this->out_events_variant) ret;
-		if (this->wait_set_capacity <= static_capacity_threshold) {
-			ret.emplace<out_events_array_type>();
-		} else {
-			ret.emplace<out_events_vector_type>(this->wait_set_capacity);
-		}
-		return ret;
-	}())
-#if CFG_OS == CFG_OS_WINDOWS
-	,
-	waitables(capacity),
-	handles(capacity)
+	pool(pool),
+	impl(resources.impl ? std::move(resources.impl) : std::make_unique<platform_backend>(capacity)),
+	// the backends recycled by the pool are created by the pooled wait_sets, so those are platform-specific
+	platform(custom_backend ? nullptr : static_cast<platform_backend*>(this->impl.get()))
 {
-	utki::assert(
-		capacity <= MAXIMUM_WAIT_OBJECTS,
-		[&](auto& o) {
-			o << "capacity should be less than " << MAXIMUM_WAIT_OBJECTS;
-		},
-		SL
-	);
-	if (capacity > MAXIMUM_WAIT_OBJECTS) {
-		throw std::invalid_argument("wait_set::wait_set(): requested wait_set maximum size is too big");
+	if (this->wait_set_capacity <= this->small_out_events.size()) {
+		this->out_events = utki::make_span(this->small_out_events.data(), this->wait_set_capacity);
+		return;
 	}
-}
 
-#elif CFG_OS == CFG_OS_LINUX
-	,
-	revents(capacity)
-{
-	if (capacity > std::numeric_limits<int>::max()) {
-		throw std::invalid_argument("wait_set(): given capacity is too big, should be <= INT_MAX");
-	}
-	utki::assert(int(capacity) > 0, SL);
-	this->epoll_set = epoll_create(int(capacity));
-	if (this->epoll_set < 0) {
-		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): epoll_create() failed");
-	}
-}
-#elif CFG_OS == CFG_OS_MACOSX
-	,
-	// kevent() reports read and write events separately, so the total number of simultaneous events
-	// reported by kevent() can be more than the total number of waitable objects waited on,
-	// but it is ok to use buffer with less capacity to get the triggered events, then the events
-	// which did not fit into the buffer will be reported the next time.
-	// Using the buffer of the same size as wait_set capacity makes it easier to unify the behaviour
-	// across different platforms.
-	revents(capacity)
-{
-	if (capacity > std::numeric_limits<int>::max()) {
-		throw std::invalid_argument("wait_set(): given capacity is too big, should be <= INT_MAX");
-	}
-	utki::assert(int(capacity) > 0, SL);
-	this->queue = kqueue();
-	if (this->queue == -1) {
-		throw std::system_error(errno, std::generic_category(), "wait_set::wait_set(): kqueue creation failed");
+	if (resources.buffer.size() == this->wait_set_capacity) {
+		this->large_out_events = std::move(resources.buffer);
+	} else {
+		this->large_out_events.resize(this->wait_set_capacity);
 	}
+	this->out_events = this->large_out_events;
 }
-#else
-#	error "Unsupported OS"
-#endif
-
-#if CFG_OS == CFG_OS_MACOSX
 
-void wait_set::add_filter(
-	waitable& w, //
-	int16_t filter,
-	void* user_data
-)
+OPROS_INLINE void wait_set::release_to_pool() noexcept
 {
-	using kevent_struct = struct kevent;
-	kevent_struct event{};
-	kevent_struct out_event{};
-
-	EV_SET(
-		&event, //
-		w.handle,
-		filter,
-		EV_ADD | EV_RECEIPT,
-		0,
-		0,
-		user_data
-	);
-
-	// 0 to make effect of polling, because passing
-	// NULL will cause to wait indefinitely.
-	const timespec timeout = {0, 0};
-
-	int res = kevent(
-		this->queue, //
-		&event, // changelist: events/filters to add, modify or delete.
-		1, // number of entries in changelist.
-		&out_event, // eventlist: output buffer for triggered/receipt events.
-		1, // number of entries available in eventlist.
-		&timeout
-	);
-	if (res < 0) {
-		throw std::system_error(errno, std::generic_category(), "wait_set::add(): add_filter(): kevent() failed");
-	}
-	utki::assert(res == 1, SL);
-
-	// EV_ERROR is always returned because of EV_RECEIPT, according to kevent() documentation.
-	utki::assert((out_event.flags & EV_ERROR) != 0, SL);
-
-	// data should be 0 if added successfully, otherwise it contains error code.
-	if (out_event.data != 0) {
-		utki::log_debug([&](auto& o) {
-			o << "wait_set::add(): out_event.data = " << out_event.data << std::endl;
-		});
-		throw std::runtime_error(
-			utki::cat("wait_set::add(): add_filter(): kevent() failed to add filter, out_event.data = ", out_event.data)
-		);
+	utki::assert(this->pool, SL);
+
+	// never recycle backend with registered waitables, so that those would not leak to the next user
+	if (this->size_of_wait_set != 0) {
+		try {
+			this->impl->clear();
+		} catch (...) {
+			return;
+		}
+		this->size_of_wait_set = 0;
 	}
-}
 
-void wait_set::remove_filter(
-	waitable& w, //
-	int16_t filter
-) noexcept
-{
-	using kevent_struct = struct kevent;
-	kevent_struct event{};
-	kevent_struct out_event{};
-
-	EV_SET(
-		&event, //
-		w.handle,
-		filter,
-		EV_DELETE | EV_RECEIPT,
-		0,
-		0,
-		nullptr
-	);
-
-	// Set to 0 to make effect of polling, because passing NULL will cause to wait indefinitely.
-	const timespec timeout = {0, 0};
-
-	int res = kevent(
-		this->queue, //
-		&event, // changelist: events/filters to add, modify or delete.
-		1, // number of entries in changelist.
-		&out_event, // eventlist: output buffer for triggered/receipt events.
-		1, // number of entries available in eventlist.
-		&timeout
-	);
-	if (res < 0) {
-		// ignore the failure
-		utki::log_debug([&](auto& o) {
-			o << "wait_set::remove(): remove_filter(): kevent() failed" << std::endl;
-		});
+	if (!this->impl->reset()) {
+		return;
 	}
-	utki::assert(res == 1, SL);
 
-	// EV_ERROR is always returned because of EV_RECEIPT, according to kevent() documentation.
-	utki::assert((out_event.flags & EV_ERROR) != 0, SL);
-}
+	wait_set_pool::item resources{this->wait_set_capacity, std::move(this->impl), std::move(this->large_out_events)};
 
-#endif
+	this->pool->release(std::move(resources));
+}
 
-void wait_set::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+OPROS_INLINE void wait_set::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
 {
-#if CFG_OS == CFG_OS_WINDOWS
-	utki::assert(this->size() <= this->handles.size(), SL);
-	if (this->size() == this->handles.size()) {
-		throw std::logic_error("wait_set::add(): wait set is full");
-	}
-
-	// NOTE: Setting wait flags may throw an exception, so do that before
-	// adding object to the array and incrementing number of added objects.
-	w.set_waiting_flags(wait_for);
+	this->impl->add(w, wait_for, user_data);
 
-	this->handles[this->size_of_wait_set] = w.handle;
-	{
-		auto& wi = this->waitables[this->size_of_wait_set];
-		wi.w = &w;
-		wi.user_data = user_data;
-	}
-
-#elif CFG_OS == CFG_OS_LINUX
-	epoll_event e{};
-	e.data.fd = w.handle;
-	e.data.ptr = user_data;
-	e.events = (wait_for.get(ready::read) ? (unsigned(EPOLLIN) | unsigned(EPOLLPRI)) : 0) |
-		(wait_for.get(ready::write) ? EPOLLOUT : 0) | (EPOLLERR);
-	int res = epoll_ctl(this->epoll_set, EPOLL_CTL_ADD, w.handle, &e);
-	if (res < 0) {
-		utki::log_debug([&](auto& o) {
-			o << "wait_set::add(): epoll_ctl() failed. If you are adding socket, "
-				 "please check that is is opened before adding to wait_set."
-			  << std::endl;
-		});
-		throw std::system_error(errno, std::generic_category(), "wait_set::add(): epoll_ctl() failed");
-	}
-#elif CFG_OS == CFG_OS_MACOSX
-	utki::assert(this->size() <= this->revents.size() / 2, SL);
+	++this->size_of_wait_set;
 
-	if (wait_for.get(ready::read)) {
-		this->add_filter(w, EVFILT_READ, user_data);
-	}
-	if (wait_for.get(ready::write)) {
-		this->add_filter(w, EVFILT_WRITE, user_data);
+	if (this->recorder) {
+		this->recorder->record(trace_recorder::record_type::add, trace_recorder::now(), user_data, wait_for);
 	}
-#else
-#	error "Unsupported OS"
-#endif
-
-	++this->size_of_wait_set;
 }
 
-void wait_set::change(
+OPROS_INLINE void wait_set::change(
 	waitable& w, //
 	utki::flags<ready> wait_for,
-	void*
-#if CFG_OS == CFG_OS_LINUX || CFG_OS == CFG_OS_MACOSX
-		user_data
-#endif
+	void* user_data
 )
 {
-#if CFG_OS == CFG_OS_WINDOWS
-	// check if the waitable object is added to this wait set
-	{
-		unsigned i = 0;
-		for (; i < this->size(); ++i) {
-			if (this->waitables[i].w == &w) {
-				break;
-			}
-		}
-		utki::assert(i <= this->size(), SL);
-		if (i == this->size()) {
-			throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
-		}
+	if (this->recorder) {
+		this->recorder->record(trace_recorder::record_type::change, trace_recorder::now(), user_data, wait_for);
 	}
 
-	// set new wait flags
-	w.set_waiting_flags(wait_for);
-
-#elif CFG_OS == CFG_OS_LINUX
-	epoll_event e{};
-	e.data.fd = w.handle;
-	e.data.ptr = user_data;
-	e.events = (wait_for.get(ready::read) ? (unsigned(EPOLLIN) | unsigned(EPOLLPRI)) : 0) |
-		(wait_for.get(ready::write) ? EPOLLOUT : 0) | (EPOLLERR);
-	int res = epoll_ctl(this->epoll_set, EPOLL_CTL_MOD, w.handle, &e);
-	if (res < 0) {
-		throw std::system_error(errno, std::generic_category(), "wait_set::change(): epoll_ctl() failed");
-	}
-#elif CFG_OS == CFG_OS_MACOSX
-	if (wait_for.get(ready::read)) {
-		this->add_filter(w, EVFILT_READ, user_data);
-	} else {
-		this->remove_filter(w, EVFILT_READ);
-	}
-	if (wait_for.get(ready::write)) {
-		this->add_filter(w, EVFILT_WRITE, user_data);
-	} else {
-		this->remove_filter(w, EVFILT_WRITE);
-	}
-#else
-#	error "Unsupported OS"
-#endif
+	this->impl->change(w, wait_for, user_data);
 }
 
-void wait_set::remove(waitable& w) noexcept
+OPROS_INLINE void wait_set::remove(waitable& w) noexcept
 {
 	utki::assert(this->size() != 0, SL);
 
-#if CFG_OS == CFG_OS_WINDOWS
-	// remove object from array
-	{
-		unsigned i = 0;
-		for (; i < this->size_of_wait_set; ++i) {
-			if (this->waitables[i].w == &w) {
-				break;
-			}
-		}
-		utki::assert(i <= this->size_of_wait_set, SL);
-		utki::assert(
-			i != this->size_of_wait_set,
-			[&](auto& o) {
-				o << "wait_set::remove(): waitable is not added to wait set";
-			},
-			SL
-		);
-
-		// decrease number of objects before shifting the object handles in the array
-		unsigned num_object = this->size_of_wait_set - 1;
-
-		// shift object handles in the array
-		for (; i < num_object; ++i) {
-			this->handles[i] = this->handles[i + 1];
-			this->waitables[i] = this->waitables[i + 1];
-		}
-	}
+	void* user_data = this->impl->remove(w);
 
-	// clear wait flags
-	try {
-		w.set_waiting_flags(false);
-	} catch (...) { // NOLINT(bugprone-empty-catch)
-		// ignore error
-	}
+	--this->size_of_wait_set;
 
-#elif CFG_OS == CFG_OS_LINUX
-	int res = epoll_ctl(this->epoll_set, EPOLL_CTL_DEL, w.handle, nullptr);
-	if (res < 0) {
-		utki::assert(
-			false,
-			[&](auto& o) {
-				o << "wait_set::Remove(): epoll_ctl failed, probably the waitable was "
-					 "not added to the wait set";
-			},
-			SL
-		);
+	if (this->recorder) {
+		this->recorder->record(trace_recorder::record_type::remove, trace_recorder::now(), user_data);
 	}
-#elif CFG_OS == CFG_OS_MACOSX
-	this->remove_filter(w, EVFILT_READ);
-	this->remove_filter(w, EVFILT_WRITE);
-#else
-#	error "Unsupported OS"
-#endif
-
-	--this->size_of_wait_set;
 }
 
-#if CFG_OS == CFG_OS_LINUX
-
-bool wait_set::wait_internal_linux(int timeout)
+OPROS_INLINE void wait_set::clear()
 {
-	// TRACE(<< "going to epoll_wait() with timeout = " << timeout << std::endl)
-
-	auto out_events = this->get_out_events();
+	this->impl->clear();
 
-	int num_events_triggered{};
+	this->size_of_wait_set = 0;
 
-	while (true) {
-		utki::assert(this->revents.size() <= std::numeric_limits<int>::max(), SL);
-		num_events_triggered = epoll_wait(this->epoll_set, this->revents.data(), int(this->revents.size()), timeout);
-
-		// TRACE(<< "epoll_wait() returned " << num_events_triggered << std::endl)
+	// triggered events refer to the removed waitables
+	this->triggered = {};
+}
 
-		if (num_events_triggered < 0) {
-			// if interrupted by signal, try waiting again.
-			if (errno == EINTR) {
-				continue;
-			}
-			throw std::system_error(errno, std::generic_category(), "wait_set::wait(): epoll_wait() failed");
-		}
-		break;
-	};
+OPROS_INLINE void wait_set::post(void* user_data, utki::flags<ready> flags)
+{
+	{
+		std::lock_guard<decltype(this->posted_mutex)> lock(this->posted_mutex);
+		this->posted.push_back(event_info{flags, user_data});
+		this->post_pending.store(true);
+	}
 
-	if (num_events_triggered == 0) {
-		// timeout hit
-		this->triggered = {};
-		return false;
+	// in case the backend interrupt is already made and not yet consumed, the waiting
+	// thread will see this post as well
+	if (!this->post_wakeup.exchange(true)) {
+		this->impl->interrupt();
 	}
+}
 
-	utki::assert(num_events_triggered > 0, SL);
-	utki::assert(this->revents.size() == out_events.size(), SL);
-	utki::assert(size_t(num_events_triggered) <= this->revents.size(), SL);
-	utki::assert(size_t(num_events_triggered) <= out_events.size(), SL);
+OPROS_INLINE void wait_set::take_posted()
+{
+	{
+		std::lock_guard<decltype(this->posted_mutex)> lock(this->posted_mutex);
 
-	unsigned out_i = 0;
-	for (const auto& e : utki::make_span(this->revents.data(), num_events_triggered)) {
-		utki::assert(out_i < out_events.size(), SL);
-		event_info& ei = out_events[out_i];
-		++out_i;
+		// reuse the buffer of previously reported events for the next posts
+		this->posted_triggered.clear();
+		std::swap(this->posted, this->posted_triggered);
 
-		ei.flags.clear();
-		ei.user_data = e.data.ptr;
+		this->post_pending.store(false);
+	}
 
-		if ((e.events & EPOLLERR) != 0) {
-			ei.flags.set(ready::error);
-		}
-		if ((e.events & (unsigned(EPOLLIN) | unsigned(EPOLLPRI))) != 0) {
-			ei.flags.set(ready::read);
-		}
-		if ((e.events & EPOLLOUT) != 0) {
-			ei.flags.set(ready::write);
-		}
+	this->interrupted = false;
+	this->posted_reported = true;
+	this->triggered = utki::make_span(this->posted_triggered);
+}
 
-		utki::assert(!ei.flags.is_clear(), SL);
+OPROS_INLINE bool wait_set::on_backend_interrupted(bool infinite, uint32_t timeout)
+{
+	this->interrupted = this->take_interrupt();
+	if (this->interrupted || !this->triggered.empty()) {
+		// posted events, if any, are reported by the next wait()
+		return true;
 	}
 
-	utki::assert(out_i > 0, SL);
-	utki::assert(size_t(out_i) <= out_events.size(), SL);
-	utki::assert(out_i == unsigned(num_events_triggered), SL);
-	this->triggered = utki::make_span(out_events.data(), num_events_triggered);
+	if (this->post_pending.load()) {
+		this->take_posted();
+		return true;
+	}
 
-	return true;
+	// The backend interrupt was made by post() whose events were already reported
+	// without waiting in the backend, so wait again. Such interrupt is pending before
+	// the wait begins and the wait returns right away, so the timeout is not reduced.
+	return this->wait_backend(infinite, timeout);
 }
 
-#endif
-
-bool wait_set::wait_internal(bool wait_infinitly, uint32_t timeout)
+OPROS_INLINE bool wait_set::wait_slow_path(bool wait_infinitly, uint32_t timeout, size_t min_events, uint32_t max_delay)
 {
-	if (this->size_of_wait_set == 0) {
-		throw std::logic_error(
-			"wait_set::wait(): no waitable objects were added "
-			"to the wait_set, can't perform wait()"
-		);
+	if (this->recorder) {
+		this->recorder->record(trace_recorder::record_type::wait_begin, trace_recorder::now());
 	}
 
-#if CFG_OS == CFG_OS_WINDOWS
-	DWORD wait_timeout{};
-	if (wait_infinitly) {
-		wait_timeout = INFINITE;
-	} else {
-		static_assert(
-			INFINITE == std::numeric_limits<DWORD>::max(),
-			"check that INFINITE macro is max uint32_t failed"
-		);
-		if (timeout == std::numeric_limits<decltype(timeout)>::max()) {
-			wait_timeout = std::numeric_limits<DWORD>::max() - 1;
-		} else {
-			wait_timeout = DWORD(timeout);
-		}
-	}
+	this->posted_reported = false;
 
-	DWORD res = WaitForMultipleObjectsEx(
-		this->size_of_wait_set,
-		this->handles.data(),
-		FALSE, // do not wait for all objects, wait for at least one
-		wait_timeout,
-		FALSE // do not stop waiting on IO completion
-	);
-
-	// Return value cannot be WAIT_IO_COMPLETION because we supplied FALSE as
-	// last parameter to WaitForMultipleObjectsEx().
-	utki::assert(res != WAIT_IO_COMPLETION, SL);
-
-	// we are not expecting abandoned mutexes
-	utki::assert(res < WAIT_ABANDONED_0 || (WAIT_ABANDONED_0 + this->size_of_wait_set) <= res, SL);
-
-	if (res == WAIT_FAILED) {
-		throw std::system_error(
-			int(GetLastError()),
-			std::generic_category(),
-			"wait_set::wait(): WaitForMultipleObjectsEx() failed"
-		);
+	bool ret = true;
+	if (this->post_pending.load()) {
+		this->take_posted();
+	} else {
+		ret = this->wait_backend(wait_infinitly, timeout);
 	}
 
-	if (res == WAIT_TIMEOUT) {
-		this->triggered = {};
-		return false;
+	// batching applies to the events of waitables only
+	if (ret && min_events > 1 && !this->posted_reported) {
+		this->collect_batch(min_events, max_delay);
 	}
 
-	utki::assert(WAIT_OBJECT_0 <= res && res < (WAIT_OBJECT_0 + this->size_of_wait_set), SL);
-
-	auto out_events = this->get_out_events();
-	utki::assert(out_events.size() == this->waitables.size(), SL);
-	utki::assert(this->handles.size() == this->waitables.size(), SL);
-
-	// check for activities
-	unsigned num_events = 0;
-	for (unsigned i = 0; i < this->size_of_wait_set; ++i) {
-		auto& wi = this->waitables[i];
-
-		// Check if handle is in signalled state.
-		// In case we have auto-reset events (see
-		// https://learn.microsoft.com/en-us/windows/win32/sync/event-objects?redirectedfrom=MSDN) the signalled state
-		// of the event which made WaitForMultipleObjectsEx() to return will be reset, so we need to check if it is that
-		// event by comparing index to what was returned by WaitForMultipleObjectsEx(). Otherwise, we call
-		// WaitForSingleObjectEx() with zero timeout to check if the event was/is in signalled state.
-		if (res - WAIT_OBJECT_0 == i ||
-			WaitForSingleObjectEx(
-				wi.w->handle,
-				0, // 0 ms timeout
-				FALSE // do not stop waiting on IO completion
-			) == WAIT_OBJECT_0)
-		{
-			// the object is in signalled state
-
-			// NOTE: Need to call get_readiness_flags() even if 'num_events < out_events.size()',
-			// because it resets the readiness state of the HANDLE.
-			utki::assert(wi.w, SL);
-			auto flags = wi.w->get_readiness_flags();
-
-			// WORKAROUND:
-			// On Windows, sometimes event triggers, but then no readiness flags are reported.
-			// As a workaround, here we need to check if there are any readiness
-			// flags actually set.
-			if (!flags.is_clear()) {
-				utki::assert(num_events < out_events.size(), SL);
-
-				out_events[num_events].user_data = wi.user_data;
-				out_events[num_events].flags = flags;
-
-				++num_events;
-			}
-		}
+	if (!this->recorder) {
+		return ret;
 	}
 
-	utki::assert(num_events <= this->size_of_wait_set, SL);
-	utki::assert(num_events <= out_events.size(), SL);
-	this->triggered = utki::make_span(out_events.data(), num_events);
-
-	return true;
-
-#elif CFG_OS == CFG_OS_LINUX
-	if (wait_infinitly) {
-		return this->wait_internal_linux(-1);
+	// use same timestamp for all the records to make it cheaper
+	auto timestamp = trace_recorder::now();
+	for (const auto& e : this->triggered) {
+		this->recorder->record(trace_recorder::record_type::event, timestamp, e.user_data, e.flags);
 	}
-
-	// in linux, epoll_wait() gets timeout as int argument, while we have timeout
-	// as uint32_t, so the requested timeout can be bigger than int can hold
-	// (negative values of the int are not used)
-
-	auto max_time_step = uint32_t(std::numeric_limits<int>::max());
-
-	while (timeout >= max_time_step) {
-		utki::assert(
-			int(max_time_step) >= 0,
-			[&](auto& o) {
-				o << "timeout = 0x" << std::hex << timeout;
-			},
-			SL
-		);
-		auto res = this->wait_internal_linux(int(max_time_step));
-		if (res != 0) {
-			return res;
-		}
-		timeout -= max_time_step;
-		if (timeout == 0) {
-			// timeout hit
-			return false;
-		}
+	if (this->interrupted) {
+		this->recorder->record(trace_recorder::record_type::interrupt, timestamp);
 	}
+	this->recorder->record(trace_recorder::record_type::wait_end, timestamp);
 
-	utki::assert(int(timeout) >= 0, SL);
-	return this->wait_internal_linux(int(timeout));
-
-#elif CFG_OS == CFG_OS_MACOSX
-	timespec ts = {
-		decltype(timespec::tv_sec)(timeout / std::milli::den), // seconds
-		decltype(timespec::tv_nsec)((timeout % std::milli::den) * std::micro::den) // nanoseconds
-	};
+	return ret;
+}
 
-	for (;;) {
-		utki::assert(this->revents.size() <= std::numeric_limits<int>::max(), SL);
-		int num_events_triggered = kevent(
-			this->queue,
-			nullptr,
-			0,
-			this->revents.data(),
-			int(this->revents.size()),
-			(wait_infinitly) ? nullptr : &ts
-		);
-
-		if (num_events_triggered < 0) {
-			if (errno == EINTR) {
+OPROS_INLINE void wait_set::collect_batch(size_t min_events, uint32_t max_delay)
+{
+	using std::chrono::steady_clock;
+
+	auto deadline = steady_clock::now() + std::chrono::microseconds(max_delay);
+
+	// the waitables which have already triggered stay ready, so waiting in the backend would return
+	// right away, thus poll in small time steps instead
+	constexpr auto min_time_step = std::chrono::microseconds(50);
+	auto time_step = std::max(std::chrono::microseconds(max_delay / 8), min_time_step);
+
+	auto out_events = this->out_events;
+	size_t num_triggered = 0;
+
+	// merge the events by user data
+	auto merge = [&](utki::span<const event_info> events) {
+		for (const auto& e : events) {
+			auto merged = utki::make_span(out_events.data(), num_triggered);
+			auto i = std::find_if(merged.begin(), merged.end(), [&e](const auto& m) {
+				return m.user_data == e.user_data;
+			});
+			if (i != merged.end()) {
+				i->flags |= e.flags;
 				continue;
 			}
-			throw std::system_error(errno, std::generic_category(), "wait_set::wait(): kevent() failed");
+			utki::assert(num_triggered < out_events.size(), SL);
+			out_events[num_triggered] = e;
+			++num_triggered;
 		}
+	};
 
-		if (num_events_triggered == 0) {
-			// timeout hit
-			this->triggered = {};
-			return false;
-		}
-
-		utki::assert(num_events_triggered > 0, SL);
-
-		auto out_events = this->get_out_events();
-
-		utki::assert(out_events.size() == this->revents.size(), SL);
-
-		size_t out_i = 0; // index into out_events
-
-		for (const auto& e : utki::make_span(this->revents.data(), size_t(num_events_triggered))) {
-			utki::flags<opros::ready> flags{false};
+	// the events of the first wait are already in the beginning of out_events
+	merge(this->triggered);
 
-			if ((e.flags & EV_ERROR) != 0) {
-				flags.set(ready::error);
-			} else {
-				// no error condition, then set the flag based on filter type
-				if (e.filter == EVFILT_WRITE) {
-					flags.set(ready::write);
-				} else if (e.filter == EVFILT_READ) {
-					flags.set(ready::read);
-				} else {
-					// unsupported event, skip it
-					continue;
-				}
-			}
-
-			auto& oe = out_events[out_i];
-			++out_i;
+	if (!this->interrupted) {
+		this->batch_buffer.resize(out_events.size());
+	}
 
-			oe.flags = flags;
-			oe.user_data = e.udata;
+	while (!this->interrupted && num_triggered < min_events) {
+		auto now = steady_clock::now();
+		if (now >= deadline) {
+			break;
 		}
 
-		utki::assert(out_i <= out_events.size(), SL);
+		auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now);
+		std::this_thread::sleep_for(std::min(remaining, time_step));
 
-		// out_i can be less than number of events triggered because there can be unsupported events
-		// which are not counted
-		utki::assert(out_i <= size_t(num_events_triggered), SL);
+		auto res = this->impl->wait(false, 0, this->batch_buffer);
 
-		this->triggered = utki::make_span(out_events.data(), out_i);
+		utki::assert(res.num_events <= this->batch_buffer.size(), SL);
 
-		return true;
+		merge(utki::make_span(this->batch_buffer.data(), res.num_events));
+
+		// wakeup made by post() does not end the batch, the posted events are reported by the next wait()
+		this->interrupted = res.interrupted && this->take_interrupt();
 	}
-#else
-#	error "Unsupported OS"
-#endif
+
+	this->triggered = utki::make_span(out_events.data(), num_triggered);
 }
+
+} // namespace opros
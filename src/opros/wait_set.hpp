@@ -27,33 +27,24 @@ SOFTWARE.
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
-#include <variant>
 #include <vector>
 
 #include <utki/config.hpp>
 #include <utki/debug.hpp>
 #include <utki/span.hpp>
 
-#if CFG_OS == CFG_OS_WINDOWS
-#	include <utki/windows.hpp>
-
-#elif CFG_OS == CFG_OS_LINUX
-#	include <sys/epoll.h>
-#	include <unistd.h>
-
-#elif CFG_OS == CFG_OS_MACOSX
-#	include <sys/event.h>
-#	include <sys/types.h>
-#	include <unistd.h>
-
-#else
-#	error "Unsupported OS"
-#endif
-
+#include "backend.hpp"
+#include "config.hpp"
+#include "platform_backend.hpp"
+#include "trace_recorder.hpp"
+#include "wait_set_pool.hpp"
 #include "waitable.hpp"
 
 #ifdef assert
@@ -62,76 +53,108 @@ SOFTWARE.
 
 namespace opros {
 
-// TODO: doxygen
-struct event_info {
-	utki::flags<ready> flags;
-	void* user_data{};
-};
-
 /**
  * @brief Set of waitable objects to wait for.
+ * The wait_set is not thread-safe, except interrupt(). But in case the backend supports
+ * thread-safe registration, e.g. concurrent_epoll_backend, then add(), change() and remove()
+ * can be called from any thread, also while another thread is blocked in wait().
  */
 class wait_set
 {
 	const unsigned wait_set_capacity;
-	unsigned size_of_wait_set = 0;
 
-	// for small wait_set we use static array instead of vector
-	constexpr static const unsigned static_capacity_threshold = 3;
+	// atomic to allow thread-safe registration with backends supporting it
+	std::atomic<unsigned> size_of_wait_set = 0;
 
-	using out_events_array_type = std::array<event_info, static_capacity_threshold>;
-	using out_events_vector_type = std::vector<event_info>;
+	// buffers which hold triggered events info, for small wait_set the inline array is used
+	std::array<event_info, 3> small_out_events;
+	std::vector<event_info> large_out_events;
 
-	// define the buffer which will hold triggered events info
-	std::variant<out_events_array_type, out_events_vector_type> out_events_variant;
-
-	utki::span<event_info> get_out_events() noexcept
-	{
-		try {
-			if (std::holds_alternative<out_events_array_type>(this->out_events_variant)) {
-				auto& a = std::get<out_events_array_type>(this->out_events_variant);
-				utki::assert(this->wait_set_capacity <= a.size(), SL);
-				return utki::make_span(a.data(), this->wait_set_capacity);
-			}
-			utki::assert(std::holds_alternative<out_events_vector_type>(this->out_events_variant), SL);
-			return std::get<out_events_vector_type>(this->out_events_variant);
-		} catch (std::bad_variant_access&) {
-			utki::assert(false, SL);
-			return {};
-		}
-	}
+	// points to one of the buffers above
+	utki::span<event_info> out_events;
 
 	utki::span<const event_info> triggered;
 
-#if CFG_OS == CFG_OS_WINDOWS
-	struct added_waitable_info {
-		waitable* w;
-		void* user_data;
-	};
+	// buffer for subsequent polls of wait_batch(), allocated on first use
+	std::vector<event_info> batch_buffer;
 
-	std::vector<added_waitable_info> waitables;
-	std::vector<HANDLE> handles; // used to pass array of HANDLEs to WaitForMultipleObjectsEx()
+	bool interrupted = false;
 
-#elif CFG_OS == CFG_OS_LINUX
-	int epoll_set;
+	// set by interrupt() to tell it from the backend interrupt made by post()
+	std::atomic<bool> interrupt_requested = false;
 
-	std::vector<epoll_event> revents; // used for getting the result from epoll_wait()
-#elif CFG_OS == CFG_OS_MACOSX
-	int queue; // kqueue
+	// events posted with post() and not yet reported
+	std::mutex posted_mutex;
+	std::vector<event_info> posted;
 
-	std::vector<struct kevent> revents; // used for getting the result
-#else
-#	error "Unsupported OS"
-#endif
+	// posted events reported by the last wait()
+	std::vector<event_info> posted_triggered;
+
+	// whether there are events in the posted list, checked by wait() without locking
+	std::atomic<bool> post_pending = false;
+
+	// whether backend interrupt has been made by post() and not yet consumed by waiting in the backend,
+	// used to coalesce wakeups of several posts into one
+	std::atomic<bool> post_wakeup = false;
+
+	// whether the last wait() has reported the posted events
+	bool posted_reported = false;
+
+	bool destroy_with_contents = false;
+
+	trace_recorder* recorder = nullptr;
+
+	// pool to return the backend and buffers to on destruction
+	wait_set_pool* pool;
+
+	std::unique_ptr<backend> impl;
+
+	// points to the impl in case it is the platform-specific backend, so that its functions
+	// can be called directly, without virtual call,
+	// the backend given by user is always called through the virtual interface
+	platform_backend* platform;
+
+	wait_set(
+		unsigned capacity, //
+		wait_set_pool::item&& resources,
+		wait_set_pool* pool,
+		bool custom_backend = false
+	);
+
+	void release_to_pool() noexcept;
 
 public:
 	/**
 	 * @brief Constructor.
+	 * Creates wait_set using the platform-specific backend.
 	 * @param capacity - maximum number of waitable objects that can be added to
-	 * the wait set.
+	 * the wait set. On Windows it must be less than MAXIMUM_WAIT_OBJECTS (64),
+	 * since one wait slot is taken by the event used by interrupt().
+	 * @throw std::invalid_argument - in case the capacity is too big for the platform.
 	 */
 	wait_set(unsigned capacity);
 
+	/**
+	 * @brief Constructor.
+	 * Creates wait_set using the given backend.
+	 * @param capacity - maximum number of waitable objects that can be added to
+	 * the wait set.
+	 * @param backend - backend to use for waiting, must not be nullptr.
+	 */
+	wait_set(unsigned capacity, std::unique_ptr<opros::backend> backend);
+
+	/**
+	 * @brief Constructor.
+	 * Creates wait_set using the platform-specific backend recycled by the pool.
+	 * In case the pool has no backend of the requested capacity, a new one is created.
+	 * On destruction, the wait_set gives its backend and buffers back to the pool.
+	 * @param capacity - maximum number of waitable objects that can be added to
+	 * the wait set. On Windows it must be less than MAXIMUM_WAIT_OBJECTS (64).
+	 * @param pool - pool to take the backend from. Must outlive the wait_set.
+	 * @throw std::invalid_argument - in case the capacity is too big for the platform.
+	 */
+	wait_set(unsigned capacity, wait_set_pool& pool);
+
 	wait_set(const wait_set&) = delete;
 	wait_set& operator=(const wait_set&) = delete;
 
@@ -142,26 +165,22 @@ public:
 	 * @brief Destructor.
 	 * Note, that destructor will check if the wait set is empty. If it is not,
 	 * then an assert will be triggered. It is user's responsibility to remove any
-	 * waitable objects from the waitset before the wait set object is destroyed.
+	 * waitable objects from the waitset before the wait set object is destroyed,
+	 * unless destroying with contents is enabled with set_destroy_with_contents().
 	 */
 	~wait_set() noexcept
 	{
 		utki::assert(
-			this->size_of_wait_set == 0,
+			this->size_of_wait_set == 0 || this->destroy_with_contents,
 			[](auto& o) {
 				o << "attempt to destroy wait_set containig waitables";
 			},
 			SL
 		);
-#if CFG_OS == CFG_OS_WINDOWS
-		// do nothing
-#elif CFG_OS == CFG_OS_LINUX
-		close(this->epoll_set);
-#elif CFG_OS == CFG_OS_MACOSX
-		close(this->queue);
-#else
-#	error "Unsupported OS"
-#endif
+
+		if (this->pool) {
+			this->release_to_pool();
+		}
 	}
 
 	/**
@@ -173,6 +192,15 @@ public:
 		return this->wait_set_capacity;
 	}
 
+	/**
+	 * @brief Get the backend.
+	 * @return backend used by this wait_set.
+	 */
+	opros::backend& get_backend() noexcept
+	{
+		return *this->impl;
+	}
+
 	/**
 	 * @brief Get number of waitables already added to the wait_set.
 	 * @return number of waitables added to the wait_set.
@@ -193,6 +221,10 @@ public:
 	/**
 	 * @brief Change wait flags for a given waitable.
 	 * Changes wait flags for a given waitable, which is in this wait_set.
+	 * Changes which do not alter the current wait flags and user data are ignored.
+	 * With epoll and kqueue backends the change is not passed to the kernel right away, instead all
+	 * changes made between two wait() calls are applied at once in the beginning of the next wait(),
+	 * so errors of applying the change can be reported by wait() as well.
 	 * @param w - waitable for which the changing of wait flags is needed.
 	 * @param wait_for - new wait flags to be set for the given waitable.
 	 * @param user_data - user data associated with the waitable object.
@@ -205,14 +237,78 @@ public:
 	 */
 	void remove(waitable& w) noexcept;
 
+	/**
+	 * @brief Remove all waitables from the wait set.
+	 * Unlike removing waitables one by one, which makes a system call for each waitable,
+	 * the epoll backend drops all the registrations at once by replacing the epoll instance,
+	 * and the kqueue backend deletes all its filters with a single kevent() call.
+	 * The pending interrupt is kept.
+	 * @throw std::system_error - in case creating the new epoll instance or deleting the kqueue filters has failed,
+	 *                            the wait set is left unchanged in that case.
+	 * @throw std::logic_error - in case the backend does not support clearing.
+	 */
+	void clear();
+
+	/**
+	 * @brief Allow destroying the wait set with waitables in it.
+	 * When enabled, the destructor does not check that the wait set is empty, the registrations
+	 * are dropped along with the epoll/kqueue instance, which is much faster than removing
+	 * the waitables one by one, e.g. when shutting down a reactor with many connections.
+	 * In case the wait set was created from a pool, the backend is cleared and returned to the pool.
+	 * @param enable - whether to allow destroying the wait set with waitables in it.
+	 */
+	void set_destroy_with_contents(bool enable) noexcept
+	{
+		this->destroy_with_contents = enable;
+	}
+
+	/**
+	 * @brief Interrupt the wait.
+	 * Makes the currently blocked, or the next, call to wait() return
+	 * without waiting. Several interrupts issued before the wait() returns are
+	 * coalesced into one. The interruption does not occupy a slot in the wait_set,
+	 * it is reported by was_interrupted().
+	 * This function is thread-safe, so it can be called from any thread.
+	 * With platform-specific backend on Linux and MacOS it is also async-signal-safe,
+	 * so it can be called from a signal handler.
+	 */
+	void interrupt() noexcept
+	{
+		this->interrupt_requested.store(true);
+		this->impl->interrupt();
+	}
+
+	/**
+	 * @brief Post event.
+	 * Makes the next wait() report the given event in get_triggered(), the same way as events of waitables.
+	 * While there are posted events, wait() returns them right away without waiting in the backend,
+	 * the events of waitables are reported by the following wait() calls.
+	 * In case the wait_set is blocked in wait(), it is woken up. Several posts before it wakes up make
+	 * only one internal wakeup. The posted event does not occupy a slot in the wait_set.
+	 * This function is thread-safe, so it can be called from any thread.
+	 * @param user_data - user data to report with the event.
+	 * @param flags - readiness flags to report with the event.
+	 */
+	void post(void* user_data, utki::flags<ready> flags);
+
+	/**
+	 * @brief Check if last wait() was interrupted.
+	 * @return true if the last call to wait() has returned because of interrupt().
+	 * @return false otherwise.
+	 */
+	bool was_interrupted() const noexcept
+	{
+		return this->interrupted;
+	}
+
 	/**
 	 * @brief wait for event.
 	 * This function blocks calling thread execution until one of the waitable
-	 * objects in the wait_set triggers.
+	 * objects in the wait_set triggers or the wait is interrupted with interrupt().
 	 */
 	void wait()
 	{
-		[[maybe_unused]] bool res = this->wait_internal(true, 0);
+		[[maybe_unused]] bool res = this->wait_internal(true, 0, 1, 0);
 		utki::assert(res, SL);
 	}
 
@@ -223,12 +319,61 @@ public:
 	 * it guarantees that it will wait AT LEAST for specified number of
 	 * milliseconds.
 	 * @param timeout - maximum time in milliseconds to wait.
-	 * @return true in case the function returned before the timeout has elapsed.
+	 * @return true in case the function returned before the timeout has elapsed,
+	 *         i.e. some waitables have triggered or the wait was interrupted.
 	 * @return false in case the function has returned due to the timeout.
 	 */
 	bool wait(uint32_t timeout)
 	{
-		return this->wait_internal(false, timeout);
+		return this->wait_internal(false, timeout, 1, 0);
+	}
+
+	/**
+	 * @brief wait for a batch of events.
+	 * Blocks until some waitables trigger, then keeps collecting triggered waitables
+	 * until at least min_events waitables have triggered or max_delay microseconds
+	 * have passed since the first event, whichever comes first. This reduces the number of
+	 * wakeups by the cost of bounded latency.
+	 * Since readiness is level-triggered, waitables which stay ready are reported by every poll,
+	 * so the events are merged by user data, i.e. each user data appears in the triggered events once,
+	 * with the readiness flags combined. So, the user data should be unique for each waitable.
+	 * After the first event the wait_set is polled without blocking in small time steps,
+	 * so the interrupt() which comes during the batch collection is noticed with a small delay.
+	 * Interruption ends the batch collection.
+	 * @param min_events - number of triggered waitables to return after.
+	 * @param max_delay - maximum time in microseconds to collect the batch for after the first event.
+	 */
+	void wait_batch(size_t min_events, uint32_t max_delay)
+	{
+		[[maybe_unused]] bool res = this->wait_internal(true, 0, min_events, max_delay);
+		utki::assert(res, SL);
+	}
+
+	/**
+	 * @brief wait for a batch of events with timeout.
+	 * The same as wait_batch(size_t, uint32_t), but with timeout for the first event.
+	 * @param min_events - number of triggered waitables to return after.
+	 * @param max_delay - maximum time in microseconds to collect the batch for after the first event.
+	 * @param timeout - maximum time in milliseconds to wait for the first event.
+	 * @return true in case the function returned before the timeout has elapsed,
+	 *         i.e. some waitables have triggered or the wait was interrupted.
+	 * @return false in case the function has returned due to the timeout.
+	 */
+	bool wait_batch(size_t min_events, uint32_t max_delay, uint32_t timeout)
+	{
+		return this->wait_internal(false, timeout, min_events, max_delay);
+	}
+
+	/**
+	 * @brief Attach trace recorder.
+	 * When trace recorder is attached, all wait_set operations and triggered events
+	 * are recorded to it.
+	 * @param recorder - trace recorder to attach, nullptr to detach. The recorder must
+	 *                   outlive the wait_set or be detached before destroying.
+	 */
+	void set_trace_recorder(trace_recorder* recorder) noexcept
+	{
+		this->recorder = recorder;
 	}
 
 	/**
@@ -241,16 +386,59 @@ public:
 	}
 
 private:
-	bool wait_internal(bool infinite, uint32_t timeout);
+	bool wait_internal(bool infinite, uint32_t timeout, size_t min_events, uint32_t max_delay)
+	{
+		if (this->recorder || min_events > 1) {
+			return this->wait_slow_path(infinite, timeout, min_events, max_delay);
+		}
+		if (this->post_pending.load()) {
+			this->take_posted();
+			return true;
+		}
+		return this->wait_backend(infinite, timeout);
+	}
 
-#if CFG_OS == CFG_OS_LINUX
-	bool wait_internal_linux(int timeout);
-#endif
+	bool wait_backend(bool infinite, uint32_t timeout)
+	{
+		// NOTE: waiting on empty wait_set is allowed, it can still be interrupted with interrupt()
 
-#if CFG_OS == CFG_OS_MACOSX
-	void add_filter(waitable& w, int16_t filter, void* user_data);
-	void remove_filter(waitable& w, int16_t filter) noexcept;
-#endif
+		// platform backend class is final, so the call is not virtual
+		auto res = this->platform ? this->platform->wait(infinite, timeout, this->out_events)
+								  : this->impl->wait(infinite, timeout, this->out_events);
+
+		utki::assert(res.num_events <= this->out_events.size(), SL);
+
+		this->triggered = utki::make_span(this->out_events.data(), res.num_events);
+
+		if (res.interrupted) {
+			return this->on_backend_interrupted(infinite, timeout);
+		}
+		this->interrupted = false;
+
+		return !res.timed_out;
+	}
+
+	// tells interrupt() from the wakeup made by post()
+	bool on_backend_interrupted(bool infinite, uint32_t timeout);
+
+	// consumes the backend interrupt, returns whether it was requested with interrupt()
+	bool take_interrupt() noexcept
+	{
+		this->post_wakeup.store(false);
+		return this->interrupt_requested.exchange(false);
+	}
+
+	// reports the posted events as triggered
+	void take_posted();
+
+	// waiting with tracing and batching
+	bool wait_slow_path(bool infinite, uint32_t timeout, size_t min_events, uint32_t max_delay);
+
+	void collect_batch(size_t min_events, uint32_t max_delay);
 };
 
 } // namespace opros
+
+#ifdef OPROS_HEADER_ONLY
+#	include "wait_set.cpp"
+#endif
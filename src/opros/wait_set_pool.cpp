@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "wait_set_pool.hpp"
+
+#include <mutex>
+
+namespace opros {
+
+OPROS_INLINE wait_set_pool::wait_set_pool(size_t max_size) :
+	max_size(max_size)
+{
+	// reserve in advance, so that release() does not allocate memory
+	this->items.reserve(this->max_size);
+}
+
+OPROS_INLINE wait_set_pool::item wait_set_pool::acquire(unsigned capacity)
+{
+	item ret{capacity, nullptr, {}};
+
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	// search from the end to take the most recently released item, it is more likely to be cached
+	for (auto i = this->items.rbegin(); i != this->items.rend(); ++i) {
+		if (i->capacity != capacity) {
+			continue;
+		}
+		ret = std::move(*i);
+		if (i != this->items.rbegin()) {
+			*i = std::move(this->items.back());
+		}
+		this->items.pop_back();
+		break;
+	}
+
+	return ret;
+}
+
+OPROS_INLINE void wait_set_pool::release(item&& i) noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+
+	if (this->items.size() == this->max_size) {
+		// pool is full, the item is destroyed when going out of scope
+		return;
+	}
+
+	this->items.push_back(std::move(i));
+}
+
+OPROS_INLINE size_t wait_set_pool::size() noexcept
+{
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	return this->items.size();
+}
+
+OPROS_INLINE void wait_set_pool::clear()
+{
+	// the pool has to keep reserved memory, so swap with the vector of the same capacity
+	decltype(this->items) items;
+	items.reserve(this->max_size);
+
+	{
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		std::swap(items, this->items);
+	}
+
+	// items are destroyed outside of the lock
+}
+
+} // namespace opros
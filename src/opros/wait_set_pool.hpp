@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <utki/spin_lock.hpp>
+
+#include "backend.hpp"
+
+namespace opros {
+
+class wait_set;
+
+/**
+ * @brief Pool of recycled wait_set resources.
+ * Creating a wait_set creates kernel objects (e.g. epoll instance and eventfd on Linux)
+ * and allocates buffers, destroying it closes and frees them. When wait_sets are short-lived
+ * those costs can be avoided by constructing the wait_sets with a pool. Such a wait_set takes
+ * its backend and buffers from the pool, if there are any of the same capacity, and gives them
+ * back to the pool on destruction.
+ * Only emptied backends are recycled. The pending interrupt is discarded before the backend is put
+ * to the pool, so nothing is passed from one wait_set to the next one.
+ * The pool is thread-safe, it is protected by a spin lock which is held only for
+ * taking or putting an item, so it can be shared by several threads, though
+ * having a pool per thread avoids contention.
+ * The pool must outlive all the wait_sets constructed with it.
+ */
+class wait_set_pool
+{
+	friend class wait_set;
+
+	struct item {
+		unsigned capacity;
+		std::unique_ptr<backend> impl;
+		std::vector<event_info> buffer;
+	};
+
+	const size_t max_size;
+
+	utki::spin_lock mutex;
+
+	std::vector<item> items;
+
+	item acquire(unsigned capacity);
+	void release(item&& i) noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param max_size - maximum number of items to keep in the pool.
+	 *                   Items released to the full pool are destroyed.
+	 */
+	wait_set_pool(size_t max_size = 16);
+
+	wait_set_pool(const wait_set_pool&) = delete;
+	wait_set_pool& operator=(const wait_set_pool&) = delete;
+
+	wait_set_pool(wait_set_pool&&) = delete;
+	wait_set_pool& operator=(wait_set_pool&&) = delete;
+
+	~wait_set_pool() = default;
+
+	/**
+	 * @brief Get number of items kept in the pool.
+	 * @return number of recycled backends ready for reuse.
+	 */
+	size_t size() noexcept;
+
+	/**
+	 * @brief Destroy all items kept in the pool.
+	 */
+	void clear();
+};
+
+} // namespace opros
+
+#ifdef OPROS_HEADER_ONLY
+#	include "wait_set_pool.cpp"
+#endif
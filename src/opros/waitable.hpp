@@ -54,12 +54,54 @@ enum class ready {
 
 	/**
 	 * @brief Flag indicating error state.
+	 * Always reported, regardless of the wait flags.
 	 */
 	error,
 
+	/**
+	 * @brief Flag indicating hang up.
+	 * For example, both directions of a socket connection are shut down or the other end of a pipe is closed.
+	 * Always reported, regardless of the wait flags.
+	 * Not reported on Windows.
+	 */
+	hangup,
+
+	/**
+	 * @brief Flag indicating that the peer has shut down the writing half of the connection.
+	 * Reading from the waitable will return end of stream, so this allows detecting
+	 * the connection close without an extra read.
+	 * Reported when waiting for ready::read.
+	 * Not reported on Windows.
+	 */
+	read_hangup,
+
+	/**
+	 * @brief Flag indicating priority data available for reading.
+	 * For example, TCP out-of-band data.
+	 * Reported only when waiting for ready::priority, waiting for ready::read does not
+	 * subscribe to priority data, so that readers which do not handle it are not woken up by it.
+	 * Only reported on Linux.
+	 */
+	priority,
+
 	enum_size // this must always be the last element of the enum
 };
 
+/**
+ * @brief Information about triggered event.
+ */
+struct event_info {
+	/**
+	 * @brief Readiness flags of the triggered waitable.
+	 */
+	utki::flags<ready> flags;
+
+	/**
+	 * @brief User data associated with the triggered waitable.
+	 */
+	void* user_data{};
+};
+
 /**
  * @brief Base class for objects which can be waited for.
  * Base class for objects which can be used in wait sets.
@@ -72,6 +114,7 @@ class waitable
 #endif
 {
 	friend class wait_set;
+	friend class backend;
 
 public:
 	waitable(const waitable&) = delete;
@@ -0,0 +1,309 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "windows_backend.hpp"
+
+#if CFG_OS == CFG_OS_WINDOWS
+
+#	include <limits>
+#	include <system_error>
+
+namespace opros {
+
+OPROS_INLINE windows_backend::windows_backend(unsigned capacity) :
+	waitables(capacity),
+	handles(size_t(capacity) + 1) // one extra slot for interrupt event
+{
+	utki::assert(
+		capacity < MAXIMUM_WAIT_OBJECTS,
+		[&](auto& o) {
+			o << "capacity should be less than " << MAXIMUM_WAIT_OBJECTS;
+		},
+		SL
+	);
+	if (capacity >= MAXIMUM_WAIT_OBJECTS) {
+		throw std::invalid_argument("wait_set::wait_set(): requested wait_set maximum size is too big");
+	}
+
+	this->interrupt_event = CreateEvent(
+		nullptr, // security attributes
+		FALSE, // auto-reset
+		FALSE, // not signalled initially
+		nullptr // no name
+	);
+	if (this->interrupt_event == nullptr) {
+		throw std::system_error(
+			int(GetLastError()),
+			std::generic_category(),
+			"wait_set::wait_set(): CreateEvent() failed"
+		);
+	}
+}
+
+OPROS_INLINE windows_backend::~windows_backend()
+{
+	CloseHandle(this->interrupt_event);
+}
+
+OPROS_INLINE unsigned windows_backend::find(const waitable& w) const noexcept
+{
+	unsigned i = 0;
+	for (; i < this->size; ++i) {
+		if (this->waitables[i].w == &w) {
+			break;
+		}
+	}
+	utki::assert(i <= this->size, SL);
+	return i;
+}
+
+OPROS_INLINE void windows_backend::add(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	utki::assert(this->size <= this->waitables.size(), SL);
+	if (this->size == this->waitables.size()) {
+		throw std::logic_error("wait_set::add(): wait set is full");
+	}
+
+	// NOTE: Setting wait flags may throw an exception, so do that before
+	// adding object to the array and incrementing number of added objects.
+	set_waiting_flags(w, wait_for);
+
+	this->handles[this->size] = get_handle(w);
+	{
+		auto& wi = this->waitables[this->size];
+		wi.w = &w;
+		wi.wait_for = wait_for;
+		wi.user_data = user_data;
+	}
+
+	++this->size;
+}
+
+OPROS_INLINE void windows_backend::change(waitable& w, utki::flags<ready> wait_for, void* user_data)
+{
+	// check if the waitable object is added to this wait set
+	unsigned i = this->find(w);
+	if (i == this->size) {
+		throw std::logic_error("wait_set::change(): the waitable is not added to this wait set");
+	}
+
+	auto& wi = this->waitables[i];
+
+	if (wi.wait_for != wait_for) {
+		// set new wait flags
+		set_waiting_flags(w, wait_for);
+		wi.wait_for = wait_for;
+	}
+	wi.user_data = user_data;
+}
+
+OPROS_INLINE void* windows_backend::remove(waitable& w) noexcept
+{
+	// remove object from array
+	unsigned i = this->find(w);
+	utki::assert(
+		i != this->size,
+		[&](auto& o) {
+			o << "wait_set::remove(): waitable is not added to wait set";
+		},
+		SL
+	);
+	if (i == this->size) {
+		return nullptr;
+	}
+
+	void* user_data = this->waitables[i].user_data;
+
+	// decrease number of objects before shifting the object handles in the array
+	--this->size;
+
+	// shift object handles in the array
+	for (; i < this->size; ++i) {
+		this->handles[i] = this->handles[i + 1];
+		this->waitables[i] = this->waitables[i + 1];
+	}
+
+	// clear wait flags
+	try {
+		set_waiting_flags(w, false);
+	} catch (...) { // NOLINT(bugprone-empty-catch)
+		// ignore error
+	}
+
+	return user_data;
+}
+
+OPROS_INLINE void windows_backend::clear()
+{
+	// there is no kernel object holding the registrations, but the wait flags
+	// of every waitable have to be cleared
+	for (const auto& i : utki::make_span(this->waitables.data(), this->size)) {
+		try {
+			set_waiting_flags(*i.w, false);
+		} catch (...) { // NOLINT(bugprone-empty-catch)
+			// ignore error
+		}
+	}
+	this->size = 0;
+}
+
+OPROS_INLINE void windows_backend::interrupt() noexcept
+{
+	if (SetEvent(this->interrupt_event) == 0) {
+		utki::assert(false, SL);
+	}
+}
+
+OPROS_INLINE bool windows_backend::reset() noexcept
+{
+	utki::assert(this->size == 0, SL);
+
+	// drop pending interrupt
+	if (ResetEvent(this->interrupt_event) == 0) {
+		return false;
+	}
+
+	return true;
+}
+
+OPROS_INLINE backend::wait_result windows_backend::wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events)
+{
+	DWORD wait_timeout{};
+	if (infinite) {
+		wait_timeout = INFINITE;
+	} else {
+		static_assert(
+			INFINITE == std::numeric_limits<DWORD>::max(),
+			"check that INFINITE macro is max uint32_t failed"
+		);
+		if (timeout == std::numeric_limits<decltype(timeout)>::max()) {
+			wait_timeout = std::numeric_limits<DWORD>::max() - 1;
+		} else {
+			wait_timeout = DWORD(timeout);
+		}
+	}
+
+	// the interrupt event always goes right after the added waitables' handles
+	utki::assert(this->size < this->handles.size(), SL);
+	this->handles[this->size] = this->interrupt_event;
+
+	DWORD res = WaitForMultipleObjectsEx(
+		this->size + 1,
+		this->handles.data(),
+		FALSE, // do not wait for all objects, wait for at least one
+		wait_timeout,
+		FALSE // do not stop waiting on IO completion
+	);
+
+	// Return value cannot be WAIT_IO_COMPLETION because we supplied FALSE as
+	// last parameter to WaitForMultipleObjectsEx().
+	utki::assert(res != WAIT_IO_COMPLETION, SL);
+
+	// we are not expecting abandoned mutexes
+	utki::assert(res < WAIT_ABANDONED_0 || (WAIT_ABANDONED_0 + this->size + 1) <= res, SL);
+
+	if (res == WAIT_FAILED) {
+		throw std::system_error(
+			int(GetLastError()),
+			std::generic_category(),
+			"wait_set::wait(): WaitForMultipleObjectsEx() failed"
+		);
+	}
+
+	wait_result ret;
+
+	if (res == WAIT_TIMEOUT) {
+		ret.timed_out = true;
+		return ret;
+	}
+
+	utki::assert(WAIT_OBJECT_0 <= res && res <= (WAIT_OBJECT_0 + this->size), SL);
+
+	if (res - WAIT_OBJECT_0 == this->size) {
+		// WaitForMultipleObjectsEx() reports the lowest index of signalled objects,
+		// so only the interrupt event is signalled, it was reset automatically
+		ret.interrupted = true;
+		return ret;
+	}
+
+	utki::assert(out_events.size() == this->waitables.size(), SL);
+	utki::assert(this->handles.size() == this->waitables.size() + 1, SL);
+
+	// check for activities
+	unsigned num_events = 0;
+	for (unsigned i = 0; i < this->size; ++i) {
+		auto& wi = this->waitables[i];
+
+		// Check if handle is in signalled state.
+		// In case we have auto-reset events (see
+		// https://learn.microsoft.com/en-us/windows/win32/sync/event-objects?redirectedfrom=MSDN) the signalled state
+		// of the event which made WaitForMultipleObjectsEx() to return will be reset, so we need to check if it is that
+		// event by comparing index to what was returned by WaitForMultipleObjectsEx(). Otherwise, we call
+		// WaitForSingleObjectEx() with zero timeout to check if the event was/is in signalled state.
+		if (res - WAIT_OBJECT_0 == i ||
+			WaitForSingleObjectEx(
+				get_handle(*wi.w),
+				0, // 0 ms timeout
+				FALSE // do not stop waiting on IO completion
+			) == WAIT_OBJECT_0)
+		{
+			// the object is in signalled state
+
+			// NOTE: Need to call get_readiness_flags() even if 'num_events < out_events.size()',
+			// because it resets the readiness state of the HANDLE.
+			utki::assert(wi.w, SL);
+			auto flags = get_readiness_flags(*wi.w);
+
+			// WORKAROUND:
+			// On Windows, sometimes event triggers, but then no readiness flags are reported.
+			// As a workaround, here we need to check if there are any readiness
+			// flags actually set.
+			if (!flags.is_clear()) {
+				utki::assert(num_events < out_events.size(), SL);
+
+				out_events[num_events].user_data = wi.user_data;
+				out_events[num_events].flags = flags;
+
+				++num_events;
+			}
+		}
+	}
+
+	// check if interrupt event is also signalled, this resets the auto-reset event
+	if (WaitForSingleObjectEx(this->interrupt_event, 0, FALSE) == WAIT_OBJECT_0) {
+		ret.interrupted = true;
+	}
+
+	utki::assert(num_events <= this->size, SL);
+	utki::assert(num_events <= out_events.size(), SL);
+	ret.num_events = num_events;
+
+	return ret;
+}
+
+} // namespace opros
+
+#endif
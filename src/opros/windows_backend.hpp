@@ -0,0 +1,96 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015-2026 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <utki/config.hpp>
+
+#if CFG_OS == CFG_OS_WINDOWS
+
+#	include <vector>
+
+#	include <utki/windows.hpp>
+
+#	include "backend.hpp"
+
+namespace opros {
+
+/**
+ * @brief Windows WaitForMultipleObjectsEx() based backend.
+ */
+class windows_backend final : public backend
+{
+	struct added_waitable_info {
+		waitable* w;
+		utki::flags<ready> wait_for;
+		void* user_data;
+	};
+
+	std::vector<added_waitable_info> waitables;
+
+	// used to pass array of HANDLEs to WaitForMultipleObjectsEx(),
+	// the last slot is reserved for the interrupt event
+	std::vector<HANDLE> handles;
+
+	HANDLE interrupt_event; // auto-reset event used by interrupt()
+
+	unsigned size = 0;
+
+	unsigned find(const waitable& w) const noexcept;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param capacity - maximum number of waitables, must be less than MAXIMUM_WAIT_OBJECTS,
+	 *                   since one of the handles waited by WaitForMultipleObjectsEx() is the interrupt event.
+	 * @throw std::invalid_argument - in case the capacity is not less than MAXIMUM_WAIT_OBJECTS.
+	 */
+	windows_backend(unsigned capacity);
+
+	windows_backend(const windows_backend&) = delete;
+	windows_backend& operator=(const windows_backend&) = delete;
+
+	windows_backend(windows_backend&&) = delete;
+	windows_backend& operator=(windows_backend&&) = delete;
+
+	~windows_backend() override;
+
+	void add(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void change(waitable& w, utki::flags<ready> wait_for, void* user_data) override;
+	void* remove(waitable& w) noexcept override;
+	void clear() override;
+	wait_result wait(bool infinite, uint32_t timeout, utki::span<event_info> out_events) override;
+	void interrupt() noexcept override;
+	bool reset() noexcept override;
+};
+
+} // namespace opros
+
+#endif
+
+#ifdef OPROS_HEADER_ONLY
+#	include "windows_backend.cpp"
+#endif
@@ -8,6 +8,29 @@ inline void test_wait_set(){
 	test_general::run();
 	test_message_queue_as_waitable::run();
 	test_threads::run();
+	test_interrupt::run();
+	test_change::run();
+	test_trace::run();
+	test_simulation::run();
+	test_poll_promotion::run();
+	test_pool::run();
+	test_executor::run();
+	test_hangup::run();
+	test_process::run();
+	test_file_watch::run();
+	test_uring::run();
+	test_ipc_channel::run();
+	test_wait_batch::run();
+	test_bounded_queue::run();
+	test_concurrent_registration::run();
+	test_sockets::run();
+	test_pipe::run();
+	test_clear::run();
+	test_dispatcher_rate_limit::run();
+	test_dispatcher_edf::run();
+	test_futex::run();
+	test_post::run();
+	test_execution::run();
 
 	utki::log([&](auto&o){o << "[PASSED]: WaitSet test" << std::endl;});
 }
@@ -1,13 +1,45 @@
+#include <algorithm>
 #include <vector>
+#include <set>
 #include <thread>
 #include <iostream>
+#include <sstream>
+#include <cstring>
 
 #include <utki/debug.hpp>
 #include "../../src/opros/wait_set.hpp"
+#include "../../src/opros/simulation_backend.hpp"
+#include "../../src/opros/poll_backend.hpp"
+#include "../../src/opros/interest_table.hpp"
+#include "../../src/opros/executor.hpp"
+#include "../../src/opros/bounded_queue.hpp"
+#include "../../src/opros/dispatcher.hpp"
+#include "../../src/opros/execution.hpp"
 #include "../helpers/queue.hpp"
 
 #include "tests.hpp"
 
+#if CFG_OS == CFG_OS_LINUX
+#	include <sys/socket.h>
+#	include <unistd.h>
+#	include <csignal>
+#	include <sys/wait.h>
+#	include "../../src/opros/epoll_backend.hpp"
+#	include "../../src/opros/process.hpp"
+#	include "../../src/opros/file_watch.hpp"
+#	include <fstream>
+#	include <fcntl.h>
+#	include "../../src/opros/uring.hpp"
+#	include "../../src/opros/ipc_channel.hpp"
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include "../../src/opros/concurrent_epoll_backend.hpp"
+#	include "../../src/opros/udp_socket.hpp"
+#	include "../../src/opros/tcp_socket.hpp"
+#	include "../../src/opros/pipe.hpp"
+#	include "../../src/opros/futex_backend.hpp"
+#endif
+
 #ifdef assert
 #	undef assert
 #endif
@@ -202,4 +234,2376 @@ void run(){
 	}
 }
 
-}
\ No newline at end of file
+}
+namespace test_interrupt{
+namespace{
+void check(opros::wait_set& ws){
+	// test that several interrupts are coalesced into one
+	{
+		helpers::queue queue;
+
+		ws.add(queue, {opros::ready::read}, &queue);
+
+		ws.interrupt();
+		ws.interrupt();
+		ws.interrupt();
+
+		utki::assert(ws.wait(100), SL);
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().empty(), SL);
+
+		utki::assert(!ws.wait(100), SL);
+		utki::assert(!ws.was_interrupted(), SL);
+
+		// interrupt together with triggered waitable
+		queue.push_message([](){});
+		ws.interrupt();
+
+		utki::assert(ws.wait(100), SL);
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &queue, SL);
+
+		utki::assert(queue.peek_msg(), SL);
+
+		ws.remove(queue);
+	}
+
+	// test interrupting blocked wait() of empty wait_set from another thread
+	{
+		std::thread thr([&ws](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+			ws.interrupt();
+		});
+
+		ws.wait();
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().empty(), SL);
+
+		thr.join();
+	}
+}
+}
+
+void run(){
+	{
+		opros::wait_set ws(1);
+		check(ws);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	// small wait sets use poll_backend by default, check epoll_backend explicitly
+	{
+		opros::wait_set ws(1, std::make_unique<opros::epoll_backend>(1));
+		check(ws);
+	}
+#endif
+}
+}
+
+namespace test_change{
+namespace{
+void check(opros::wait_set& ws){
+	helpers::queue q1, q2;
+
+	ws.add(q1, {opros::ready::read}, &q1);
+	ws.add(q2, {opros::ready::read}, &q2);
+
+	q1.push_message([](){});
+	q2.push_message([](){});
+
+	// change which does not alter anything
+	ws.change(q1, {opros::ready::read}, &q1);
+
+	// stop waiting for q2
+	ws.change(q2, false, &q2);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &q1, SL);
+
+	// several changes between waits, the last one wins
+	ws.change(q1, false, &q1);
+	ws.change(q2, {opros::ready::read}, &q1);
+	ws.change(q2, {opros::ready::read}, &q2);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &q2, SL);
+
+	// change which reverts previous change
+	ws.change(q1, {opros::ready::read}, &q1);
+	ws.change(q1, false, &q1);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &q2, SL);
+
+	// change user data only
+	ws.change(q2, {opros::ready::read}, &q1);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &q1, SL);
+
+	// remove waitable which has pending change
+	ws.change(q1, {opros::ready::read}, &q2);
+	ws.remove(q1);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &q1, SL);
+
+	utki::assert(q1.peek_msg(), SL);
+	utki::assert(q2.peek_msg(), SL);
+
+	ws.remove(q2);
+}
+}
+
+void run(){
+	{
+		opros::wait_set ws(2);
+		check(ws);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	// small wait sets use poll_backend by default, check the deferred changes of epoll_backend explicitly
+	{
+		opros::wait_set ws(2, std::make_unique<opros::epoll_backend>(2));
+		check(ws);
+	}
+#endif
+
+	// redundant changes are not passed to the kernel
+	{
+		opros::interest_table interests;
+
+		int d1, d2;
+		interests.insert(3, {{opros::ready::read}, &d1});
+		interests.insert(5, {{opros::ready::read}, &d2});
+		utki::assert(interests.size() == 2, SL);
+
+		unsigned num_applied = 0;
+		auto apply = [&](int handle, const opros::interest_table::state& requested, const auto& applied){
+			utki::assert(handle == 3, SL);
+			utki::assert(requested.wait_for.is_clear(), SL);
+			utki::assert(requested.user_data == &d2, SL);
+			utki::assert(applied.wait_for.get(opros::ready::read), SL);
+			++num_applied;
+		};
+
+		// change which does not alter anything
+		interests.request(3, {{opros::ready::read}, &d1});
+
+		// change which is reverted before applying
+		interests.request(5, {false, &d2});
+		interests.request(5, {{opros::ready::read}, &d2});
+
+		interests.apply_pending_changes(apply);
+		utki::assert(num_applied == 0, SL);
+
+		// several changes of the same handle are applied once
+		interests.request(3, {false, &d1});
+		interests.request(3, {{opros::ready::write}, &d1});
+		interests.request(3, {false, &d2});
+
+		interests.apply_pending_changes(apply);
+		utki::assert(num_applied == 1, SL);
+
+		auto i = interests.find(3);
+		utki::assert(i, SL);
+		utki::assert(!i->pending, SL);
+		utki::assert(i->applied == i->requested, SL);
+
+		// change of removed and re-added handle is dropped
+		interests.request(5, {false, &d2});
+		interests.erase(5);
+		utki::assert(!interests.find(5), SL);
+		interests.insert(5, {{opros::ready::read}, &d2});
+
+		interests.apply_pending_changes(apply);
+		utki::assert(num_applied == 1, SL);
+
+		interests.erase(3);
+		interests.erase(5);
+		utki::assert(interests.size() == 0, SL);
+		utki::assert(!interests.find(3), SL);
+		utki::assert(!interests.find(100), SL);
+	}
+}
+}
+
+namespace test_trace{
+size_t count_substrings(const std::string& str, const std::string& sub){
+	size_t ret = 0;
+	for(auto pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size())){
+		++ret;
+	}
+	return ret;
+}
+
+void run(){
+	opros::trace_recorder recorder(100);
+	utki::assert(recorder.capacity() == 128, SL);
+
+	{
+		opros::wait_set ws(2);
+		ws.set_trace_recorder(&recorder);
+
+		helpers::queue queue;
+
+		ws.add(queue, {opros::ready::read}, &queue);
+
+		queue.push_message([](){});
+		ws.interrupt();
+		utki::assert(ws.wait(100), SL);
+
+		ws.change(queue, {opros::ready::read, opros::ready::write}, &queue);
+
+		ws.remove(queue);
+	}
+
+	{
+		std::stringstream ss;
+		recorder.dump_chrome_trace(ss);
+		auto str = ss.str();
+
+		utki::assert(count_substrings(str, R"("name":"add")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"change")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"remove")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"interrupt")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"wait","ph":"B")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"wait","ph":"E")") == 1, SL);
+		utki::assert(count_substrings(str, R"("name":"event")") == 1, SL);
+		utki::assert(count_substrings(str, R"("flags":"read|write")") == 1, SL);
+	}
+
+	// test that only last records are kept when ring buffer is overflown
+	for(unsigned i = 0; i != 1000; ++i){
+		recorder.record(opros::trace_recorder::record_type::wait_begin, opros::trace_recorder::now());
+		recorder.record(opros::trace_recorder::record_type::wait_end, opros::trace_recorder::now());
+	}
+
+	{
+		std::stringstream ss;
+		recorder.dump_chrome_trace(ss);
+		auto str = ss.str();
+
+		utki::assert(count_substrings(str, R"("name":"wait")") == recorder.capacity(), SL);
+		utki::assert(count_substrings(str, R"("name":"add")") == 0, SL);
+	}
+
+	recorder.clear();
+
+	{
+		std::stringstream ss;
+		recorder.dump_chrome_trace(ss);
+		utki::assert(count_substrings(ss.str(), R"("name")") == 0, SL);
+	}
+
+	// timestamps are relative to the earliest record, not the first one recorded,
+	// e.g. when the record of the other thread gets to the ring buffer later
+	{
+		auto now = opros::trace_recorder::now();
+		recorder.record(opros::trace_recorder::record_type::interrupt, now + 1500);
+		recorder.record(opros::trace_recorder::record_type::wait_begin, now);
+
+		std::stringstream ss;
+		recorder.dump_chrome_trace(ss);
+		auto str = ss.str();
+
+		utki::assert(count_substrings(str, R"("name":"interrupt","ph":"i","s":"t","pid":0,"tid":)") == 1, SL);
+		utki::assert(count_substrings(str, R"("ts":1.500})") == 1, [&](auto&o){o << str;}, SL);
+		utki::assert(count_substrings(str, R"("ts":0.000})") == 1, [&](auto&o){o << str;}, SL);
+
+		recorder.clear();
+	}
+}
+}
+
+namespace test_simulation{
+void run(){
+	auto backend = std::make_unique<opros::simulation_backend>();
+	auto& sim = *backend;
+
+	opros::wait_set ws(2, std::move(backend));
+	utki::assert(&ws.get_backend() == &sim, SL);
+
+	opros::simulated_waitable w1, w2, w3;
+
+	ws.add(w1, {opros::ready::read}, &w1);
+	ws.add(w2, {opros::ready::read, opros::ready::write}, &w2);
+	ws.add(w3, {opros::ready::write}, &w3);
+
+	// nothing is ready, finite timeout returns right away
+	utki::assert(!ws.wait(1000000), SL);
+	utki::assert(ws.get_triggered().empty(), SL);
+
+	// readiness not matching the wait flags is not reported
+	sim.set_readiness(w1, {opros::ready::write});
+	utki::assert(!ws.wait(0), SL);
+
+	// priority data is reported only when waiting for it, not when waiting for read
+	sim.set_readiness(w1, {opros::ready::priority});
+	utki::assert(!ws.wait(0), SL);
+
+	ws.change(w1, {opros::ready::read, opros::ready::priority}, &w1);
+	utki::assert(ws.wait(0), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &w1, SL);
+	utki::assert(ws.get_triggered()[0].flags == utki::make_flags({opros::ready::priority}), SL);
+
+	ws.change(w1, {opros::ready::read}, &w1);
+	utki::assert(!ws.wait(0), SL);
+
+	// error is always reported
+	sim.set_readiness(w1, {opros::ready::write, opros::ready::error});
+	utki::assert(ws.wait(0), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &w1, SL);
+	utki::assert(ws.get_triggered()[0].flags == utki::make_flags({opros::ready::error}), SL);
+
+	// readiness is level-triggered, more ready waitables than the buffer can hold
+	sim.set_readiness(w2, {opros::ready::read});
+	sim.set_readiness(w3, {opros::ready::write});
+
+	ws.wait();
+	utki::assert(ws.get_triggered().size() == 2, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &w1, SL);
+	utki::assert(ws.get_triggered()[1].user_data == &w2, SL);
+
+	// the one which did not fit goes first
+	ws.wait();
+	utki::assert(ws.get_triggered().size() == 2, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &w3, SL);
+	utki::assert(ws.get_triggered()[1].user_data == &w1, SL);
+
+	sim.set_readiness(w1, false);
+	sim.set_readiness(w2, false);
+
+	ws.change(w3, {opros::ready::read}, &w3);
+	utki::assert(!ws.wait(0), SL);
+	utki::assert(sim.get_readiness(w3) == utki::make_flags({opros::ready::write}), SL);
+
+	ws.remove(w3);
+
+	// interrupt
+	ws.interrupt();
+	utki::assert(ws.wait(0), SL);
+	utki::assert(ws.was_interrupted(), SL);
+	utki::assert(ws.get_triggered().empty(), SL);
+
+	// blocking wait woken up from another thread
+	{
+		std::thread thr([&sim, &w2](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			sim.set_readiness(w2, {opros::ready::write});
+		});
+
+		ws.wait();
+		utki::assert(!ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &w2, SL);
+		utki::assert(ws.get_triggered()[0].flags == utki::make_flags({opros::ready::write}), SL);
+
+		thr.join();
+	}
+
+	ws.remove(w1);
+	ws.remove(w2);
+
+	// many synthetic events
+	{
+		const unsigned num_waitables = 1000;
+
+		auto backend = std::make_unique<opros::simulation_backend>();
+		auto& sim = *backend;
+
+		opros::wait_set ws(num_waitables, std::move(backend));
+
+		std::vector<opros::simulated_waitable> waitables(num_waitables);
+
+		for(auto& w : waitables){
+			ws.add(w, {opros::ready::read}, &w);
+		}
+
+		size_t num_events = 0;
+		for(unsigned i = 0; i != 100; ++i){
+			for(auto& w : waitables){
+				sim.set_readiness(w, {opros::ready::read});
+			}
+			ws.wait();
+			num_events += ws.get_triggered().size();
+			for(auto& w : waitables){
+				sim.set_readiness(w, false);
+			}
+		}
+		utki::assert(num_events == 100 * num_waitables, SL);
+
+		for(auto& w : waitables){
+			ws.remove(w);
+		}
+	}
+}
+}
+
+namespace test_poll_promotion{
+void run(){
+	opros::wait_set ws(6);
+
+	std::vector<helpers::queue> queues(6);
+
+	for(auto& q : queues){
+		ws.add(q, {opros::ready::read}, &q);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	{
+		auto pb = dynamic_cast<opros::poll_backend*>(&ws.get_backend());
+		utki::assert(pb, SL);
+		utki::assert(pb->is_promoted(), SL);
+	}
+#endif
+
+	// interrupt must still work after promotion
+	ws.interrupt();
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.was_interrupted(), SL);
+	utki::assert(ws.get_triggered().empty(), SL);
+
+	queues[1].push_message([](){});
+	queues[5].push_message([](){});
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 2, SL);
+
+	for(auto& q : queues){
+		ws.remove(q);
+	}
+
+	// small wait set stays on poll()
+	opros::wait_set small_ws(3);
+
+	for(size_t i = 0; i != 3; ++i){
+		small_ws.add(queues[i], {opros::ready::read}, &queues[i]);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	{
+		auto pb = dynamic_cast<opros::poll_backend*>(&small_ws.get_backend());
+		utki::assert(pb, SL);
+		utki::assert(!pb->is_promoted(), SL);
+	}
+#endif
+
+	// queues[1] already has a message
+	small_ws.change(queues[1], false, &queues[1]);
+	queues[0].push_message([](){});
+
+	utki::assert(small_ws.wait(100), SL);
+	utki::assert(small_ws.get_triggered().size() == 1, SL);
+	utki::assert(small_ws.get_triggered()[0].user_data == &queues[0], SL);
+	utki::assert(queues[0].peek_msg(), SL);
+
+	small_ws.interrupt();
+	utki::assert(small_ws.wait(100), SL);
+	utki::assert(small_ws.was_interrupted(), SL);
+	utki::assert(small_ws.get_triggered().empty(), SL);
+
+	for(size_t i = 0; i != 3; ++i){
+		small_ws.remove(queues[i]);
+	}
+
+	// more waitables than the capacity, all of them ready
+	{
+		opros::wait_set tiny_ws(1);
+
+		for(size_t i = 0; i != 3; ++i){
+			queues[i].push_message([](){});
+			tiny_ws.add(queues[i], {opros::ready::read}, &queues[i]);
+		}
+
+#if CFG_OS == CFG_OS_LINUX
+		{
+			auto pb = dynamic_cast<opros::poll_backend*>(&tiny_ws.get_backend());
+			utki::assert(pb, SL);
+			utki::assert(pb->is_promoted(), SL);
+		}
+#endif
+
+		std::set<void*> reported;
+		for(size_t i = 0; i != 3; ++i){
+			utki::assert(tiny_ws.wait(100), SL);
+			utki::assert(tiny_ws.get_triggered().size() == 1, SL);
+			auto q = static_cast<helpers::queue*>(tiny_ws.get_triggered()[0].user_data);
+			// queues[1] has a message left from the previous checks
+			utki::assert(q->peek_msg(), SL);
+			while(q->peek_msg()){}
+			reported.insert(q);
+		}
+		utki::assert(reported.size() == 3, SL);
+
+		utki::assert(!tiny_ws.wait(0), SL);
+
+		for(size_t i = 0; i != 3; ++i){
+			tiny_ws.remove(queues[i]);
+		}
+	}
+}
+}
+
+namespace test_pool{
+void run(){
+	opros::wait_set_pool pool;
+
+	helpers::queue queue;
+
+	const opros::backend* recycled = nullptr;
+
+	for(unsigned capacity : {1, 10}){
+		{
+			opros::wait_set ws(capacity, pool);
+
+			ws.add(queue, {opros::ready::read}, &queue);
+
+			queue.push_message([](){});
+
+			utki::assert(ws.wait(100), SL);
+			utki::assert(ws.get_triggered().size() == 1, SL);
+			utki::assert(queue.peek_msg(), SL);
+
+			ws.remove(queue);
+
+			// interrupt which is not consumed by wait() must not leak to the next user of the backend
+			ws.interrupt();
+
+			recycled = &ws.get_backend();
+		}
+		utki::assert(pool.size() == 1, SL);
+
+		{
+			opros::wait_set ws(capacity, pool);
+			utki::assert(pool.size() == 0, SL);
+			utki::assert(&ws.get_backend() == recycled, SL);
+
+			// no stale interrupt
+			utki::assert(!ws.wait(0), SL);
+			utki::assert(!ws.was_interrupted(), SL);
+
+			ws.add(queue, {opros::ready::read}, &queue);
+
+			queue.push_message([](){});
+
+			utki::assert(ws.wait(100), SL);
+			utki::assert(ws.get_triggered().size() == 1, SL);
+			utki::assert(ws.get_triggered()[0].user_data == &queue, SL);
+			utki::assert(queue.peek_msg(), SL);
+
+			ws.remove(queue);
+		}
+		utki::assert(pool.size() == 1, SL);
+
+		// wait_set of different capacity does not take the backend from the pool
+		{
+			opros::wait_set ws(capacity + 1, pool);
+			utki::assert(pool.size() == 1, SL);
+		}
+		utki::assert(pool.size() == 2, SL);
+
+		pool.clear();
+		utki::assert(pool.size() == 0, SL);
+	}
+}
+}
+
+namespace test_executor{
+namespace{
+template <typename predicate_type>
+bool wait_for(predicate_type pred){
+	for(unsigned i = 0; i != 300; ++i){
+		if(pred()){
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return pred();
+}
+}
+
+void run(){
+	// all messages are handled, one message per handler call
+	{
+		opros::executor ex(4, 3);
+
+		std::vector<helpers::queue> queues(4);
+		std::atomic<unsigned> num_handled{0};
+
+		for(auto& q : queues){
+			ex.add(q, {opros::ready::read}, [&q](utki::flags<opros::ready> flags){
+				utki::assert(flags.get(opros::ready::read), SL);
+				auto m = q.peek_msg();
+				if(m){
+					m();
+				}
+			});
+		}
+
+		for(unsigned i = 0; i != 100; ++i){
+			queues[i % queues.size()].push_message([&num_handled](){
+				++num_handled;
+			});
+		}
+
+		utki::assert(wait_for([&](){return num_handled == 100;}), SL);
+
+		for(auto& q : queues){
+			ex.remove(q);
+		}
+	}
+
+	// slow handler does not stall others
+	{
+		opros::executor ex(2, 2);
+
+		helpers::queue slow_queue, fast_queue;
+		std::atomic<bool> slow_started{false};
+		std::atomic<bool> slow_finished{false};
+		std::atomic<bool> fast_handled{false};
+
+		ex.add(slow_queue, {opros::ready::read}, [&](utki::flags<opros::ready>){
+			slow_started = true;
+			wait_for([&](){return fast_handled.load();});
+			slow_finished = true;
+			slow_queue.peek_msg();
+		});
+
+		ex.add(fast_queue, {opros::ready::read}, [&](utki::flags<opros::ready>){
+			fast_handled = true;
+			fast_queue.peek_msg();
+		});
+
+		slow_queue.push_message([](){});
+		utki::assert(wait_for([&](){return slow_started.load();}), SL);
+
+		fast_queue.push_message([](){});
+		utki::assert(wait_for([&](){return slow_finished.load();}), SL);
+		utki::assert(fast_handled, SL);
+
+		ex.remove(slow_queue);
+		ex.remove(fast_queue);
+	}
+
+	// remove from handler, handler is not called again
+	{
+		opros::executor ex(1, 1);
+
+		helpers::queue queue;
+		std::atomic<unsigned> num_calls{0};
+
+		ex.add(queue, {opros::ready::read}, [&](utki::flags<opros::ready>){
+			++num_calls;
+			ex.remove(queue);
+		});
+
+		queue.push_message([](){});
+
+		utki::assert(wait_for([&](){return num_calls != 0;}), SL);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		utki::assert(num_calls == 1, SL);
+
+		utki::assert(queue.peek_msg(), SL);
+
+		bool thrown = false;
+		try{
+			ex.remove(queue);
+		}catch(std::logic_error&){
+			thrown = true;
+		}
+		utki::assert(thrown, SL);
+	}
+
+	// two handlers removing each other's waitables do not deadlock
+	{
+		opros::executor ex(2, 2);
+
+		helpers::queue q1, q2;
+		std::atomic<unsigned> num_started{0};
+		std::atomic<unsigned> num_finished{0};
+
+		auto make_handler = [&](helpers::queue& other){
+			return [&](utki::flags<opros::ready>){
+				++num_started;
+				wait_for([&](){return num_started == 2;});
+				ex.remove(other);
+				++num_finished;
+			};
+		};
+
+		ex.add(q1, {opros::ready::read}, make_handler(q2));
+		ex.add(q2, {opros::ready::read}, make_handler(q1));
+
+		q1.push_message([](){});
+		q2.push_message([](){});
+
+		utki::assert(wait_for([&](){return num_finished == 2;}), SL);
+		utki::assert(num_started == 2, SL);
+	}
+}
+}
+
+namespace test_hangup{
+#if CFG_OS == CFG_OS_LINUX
+namespace{
+class socket_waitable : public opros::waitable{
+public:
+	socket_waitable(int fd) :
+		opros::waitable(fd)
+	{}
+};
+
+void check(opros::wait_set& ws){
+	std::array<int, 2> fds{};
+	utki::assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) == 0, SL);
+
+	socket_waitable sock(fds[0]);
+
+	ws.add(sock, {opros::ready::read}, &sock);
+
+	utki::assert(!ws.wait(0), SL);
+
+	// peer shuts down writing, reading end gets read hang-up
+	utki::assert(shutdown(fds[1], SHUT_WR) == 0, SL);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].flags.get(opros::ready::read_hangup), SL);
+	utki::assert(!ws.get_triggered()[0].flags.get(opros::ready::hangup), SL);
+
+	// hang-up is reported even without waiting for anything
+	ws.change(sock, false, &sock);
+	utki::assert(!ws.wait(0), SL);
+
+	utki::assert(close(fds[1]) == 0, SL);
+
+	utki::assert(ws.wait(100), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].flags.get(opros::ready::hangup), SL);
+	utki::assert(!ws.get_triggered()[0].flags.get(opros::ready::read_hangup), SL);
+
+	ws.remove(sock);
+
+	utki::assert(close(fds[0]) == 0, SL);
+}
+}
+#endif
+
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	{
+		// poll backend
+		opros::wait_set ws(1);
+		check(ws);
+	}
+	{
+		opros::wait_set ws(1, std::make_unique<opros::epoll_backend>(1));
+		check(ws);
+	}
+#endif
+}
+}
+
+namespace test_process{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	opros::wait_set ws(2);
+
+	auto child1 = fork();
+	utki::assert(child1 >= 0, SL);
+	if(child1 == 0){
+		_exit(42);
+	}
+
+	auto child2 = fork();
+	utki::assert(child2 >= 0, SL);
+	if(child2 == 0){
+		pause();
+		_exit(0);
+	}
+
+	std::unique_ptr<opros::process> p1;
+	try{
+		p1 = std::make_unique<opros::process>(child1);
+	}catch(std::system_error& e){
+		if(e.code().value() != ENOSYS){
+			throw;
+		}
+		utki::log([&](auto&o){o << "pidfd is not supported, skip process test" << std::endl;});
+		kill(child2, SIGKILL);
+		waitpid(child1, nullptr, 0);
+		waitpid(child2, nullptr, 0);
+		return;
+	}
+	opros::process p2(child2);
+
+	utki::assert(!p2.reap(), SL);
+
+	ws.add(*p1, {opros::ready::read}, p1.get());
+	ws.add(p2, {opros::ready::read}, &p2);
+
+	utki::assert(ws.wait(3000), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == p1.get(), SL);
+
+	{
+		auto status = p1->reap();
+		utki::assert(status, SL);
+		utki::assert(!status->signaled, SL);
+		utki::assert(status->code == 42, SL);
+	}
+
+	ws.remove(*p1);
+
+	p2.send_signal(SIGKILL);
+
+	utki::assert(ws.wait(3000), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &p2, SL);
+
+	{
+		auto status = p2.reap();
+		utki::assert(status, SL);
+		utki::assert(status->signaled, SL);
+		utki::assert(status->code == SIGKILL, SL);
+	}
+
+	ws.remove(p2);
+#endif
+}
+}
+
+namespace test_file_watch{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	std::string dir_template = "/tmp/opros_test_XXXXXX";
+	utki::assert(mkdtemp(dir_template.data()), SL);
+	const std::string dir = dir_template;
+
+	opros::file_watch fw;
+
+	auto wd = fw.add_watch(dir, {opros::file_watch::change::created, opros::file_watch::change::deleted});
+
+	opros::wait_set ws(1);
+	ws.add(fw, {opros::ready::read}, &fw);
+
+	utki::assert(!ws.wait(0), SL);
+	utki::assert(fw.read_events().empty(), SL);
+
+	const std::string file_name = "some_file.txt";
+	std::ofstream(dir + "/" + file_name) << "hello";
+
+	utki::assert(ws.wait(1000), SL);
+	utki::assert(ws.get_triggered().size() == 1, SL);
+	utki::assert(ws.get_triggered()[0].user_data == &fw, SL);
+
+	{
+		auto events = fw.read_events();
+		utki::assert(events.size() == 1, SL);
+		utki::assert(events[0].watch == wd, SL);
+		utki::assert(events[0].changes.get(opros::file_watch::change::created), SL);
+		utki::assert(events[0].name == file_name, [&](auto&o){o << "name = " << events[0].name;}, SL);
+	}
+
+	utki::assert(!ws.wait(0), SL);
+
+	utki::assert(std::remove((dir + "/" + file_name).c_str()) == 0, SL);
+
+	utki::assert(ws.wait(1000), SL);
+
+	{
+		auto events = fw.read_events();
+		utki::assert(events.size() == 1, SL);
+		utki::assert(events[0].changes.get(opros::file_watch::change::deleted), SL);
+		utki::assert(events[0].name == file_name, SL);
+	}
+
+	fw.remove_watch(wd);
+
+	// removing the watch is reported as well
+	utki::assert(ws.wait(1000), SL);
+	{
+		auto events = fw.read_events();
+		utki::assert(events.size() == 1, SL);
+		utki::assert(events[0].changes.get(opros::file_watch::change::watch_removed), SL);
+		utki::assert(events[0].name.empty(), SL);
+	}
+
+	ws.remove(fw);
+
+	utki::assert(rmdir(dir.c_str()) == 0, SL);
+#endif
+}
+}
+
+namespace test_uring{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	std::unique_ptr<opros::uring> ring;
+	try{
+		ring = std::make_unique<opros::uring>(4);
+	}catch(std::system_error& e){
+		utki::log([&](auto&o){o << "io_uring is not available (" << e.what() << "), skip uring test" << std::endl;});
+		return;
+	}
+
+	opros::wait_set ws(1);
+	ws.add(*ring, {opros::ready::read}, ring.get());
+
+	auto wait_completion = [&](){
+		utki::assert(ws.wait(3000), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		auto c = ring->get_completions();
+		utki::assert(c.size() == 1, SL);
+		return c[0];
+	};
+
+	std::string dir_template = "/tmp/opros_test_XXXXXX";
+	utki::assert(mkdtemp(dir_template.data()), SL);
+	const std::string file_name = dir_template + "/file.bin";
+
+	// open
+	utki::assert(ring->queue_openat(AT_FDCWD, file_name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600, 1), SL);
+	utki::assert(ring->num_queued_operations() == 1, SL);
+	utki::assert(ring->submit() == 1, SL);
+	utki::assert(ring->num_queued_operations() == 0, SL);
+
+	auto c = wait_completion();
+	utki::assert(c.user_data == 1, SL);
+	utki::assert(c.result >= 0, [&](auto&o){o << "result = " << c.result;}, SL);
+	int fd = c.result;
+
+	// write, then fsync
+	const std::array<uint8_t, 4> data = {1, 2, 3, 4};
+	utki::assert(ring->queue_write(fd, utki::make_span(data), 0, 2), SL);
+	utki::assert(ring->submit() == 1, SL);
+	c = wait_completion();
+	utki::assert(c.user_data == 2, SL);
+	utki::assert(c.result == int32_t(data.size()), SL);
+
+	utki::assert(ring->queue_fsync(fd, true, 3), SL);
+	utki::assert(ring->submit() == 1, SL);
+	c = wait_completion();
+	utki::assert(c.user_data == 3, SL);
+	utki::assert(c.result == 0, SL);
+
+	// read to registered buffer
+	std::vector<uint8_t> buf(16);
+	const std::array<utki::span<uint8_t>, 1> buffers = {utki::make_span(buf)};
+	ring->register_buffers(utki::make_span(buffers));
+
+	utki::assert(ring->queue_read_fixed(fd, utki::make_span(buf), 0, 0, 4), SL);
+	utki::assert(ring->submit() == 1, SL);
+	c = wait_completion();
+	utki::assert(c.user_data == 4, SL);
+	utki::assert(c.result == int32_t(data.size()), SL);
+	utki::assert(std::equal(data.begin(), data.end(), buf.begin()), SL);
+
+	ring->unregister_buffers();
+
+	// submission queue overflow
+	for(unsigned i = 0; i != 4; ++i){
+		utki::assert(ring->queue_fsync(fd, false, 5), SL);
+	}
+	utki::assert(!ring->queue_fsync(fd, false, 5), SL);
+	utki::assert(ring->submit() == 4, SL);
+
+	unsigned num_completions = 0;
+	while(num_completions != 4){
+		utki::assert(ws.wait(3000), SL);
+		num_completions += unsigned(ring->get_completions().size());
+	}
+
+	// completion queue overflow, the completion queue is twice as big as the submission queue
+	{
+		constexpr unsigned num_operations = 16;
+		for(unsigned i = 0; i != num_operations / 4; ++i){
+			for(unsigned j = 0; j != 4; ++j){
+				utki::assert(ring->queue_fsync(fd, false, 6), SL);
+			}
+			utki::assert(ring->submit() == 4, SL);
+
+			// let the operations complete without fetching the completions
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+
+		num_completions = 0;
+		while(num_completions != num_operations){
+			utki::assert(ws.wait(3000), [&](auto&o){o << "num_completions = " << num_completions;}, SL);
+			for(const auto& c : ring->get_completions()){
+				utki::assert(c.user_data == 6, SL);
+				++num_completions;
+			}
+		}
+	}
+
+	ws.remove(*ring);
+
+	close(fd);
+	utki::assert(std::remove(file_name.c_str()) == 0, SL);
+	utki::assert(rmdir(dir_template.c_str()) == 0, SL);
+#endif
+}
+}
+
+namespace test_ipc_channel{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	// record corrupted by the peer
+	{
+		constexpr size_t capacity = 256;
+		opros::ipc_channel producer(capacity);
+		opros::ipc_channel consumer(dup(producer.get_memfd()), dup(producer.get_handle()));
+
+		const std::array<uint8_t, 3> msg = {1, 2, 3};
+		utki::assert(producer.send(utki::make_span(msg)), SL);
+
+		// the ring is in the end of the shared memory
+		struct stat st{};
+		utki::assert(fstat(producer.get_memfd(), &st) == 0, SL);
+		void* mapping = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, producer.get_memfd(), 0);
+		utki::assert(mapping != MAP_FAILED, SL);
+		auto ring = std::next(static_cast<uint8_t*>(mapping), st.st_size - off_t(capacity));
+
+		for(uint32_t bad_size : {uint32_t(capacity), uint32_t(100), uint32_t(0x7fffffff)}){
+			memcpy(ring, &bad_size, sizeof(bad_size));
+
+			bool thrown = false;
+			try{
+				consumer.front();
+			}catch(std::runtime_error&){
+				thrown = true;
+			}
+			utki::assert(thrown, [&](auto&o){o << "bad_size = " << bad_size;}, SL);
+
+			thrown = false;
+			try{
+				consumer.pop();
+			}catch(std::runtime_error&){
+				thrown = true;
+			}
+			utki::assert(thrown, SL);
+		}
+
+		munmap(mapping, size_t(st.st_size));
+	}
+
+	// single process, attached channel
+	{
+		opros::ipc_channel producer(256);
+		opros::ipc_channel consumer(dup(producer.get_memfd()), dup(producer.get_handle()));
+
+		opros::wait_set ws(1);
+		ws.add(consumer, {opros::ready::read}, &consumer);
+
+		utki::assert(!ws.wait(0), SL);
+		utki::assert(!consumer.front(), SL);
+
+		const std::array<uint8_t, 3> msg1 = {1, 2, 3};
+		const std::array<uint8_t, 5> msg2 = {4, 5, 6, 7, 8};
+
+		utki::assert(producer.send(utki::make_span(msg1)), SL);
+		utki::assert(producer.send(utki::make_span(msg2)), SL);
+
+		utki::assert(ws.wait(0), SL);
+		{
+			auto m = consumer.front();
+			utki::assert(m, SL);
+			utki::assert(m->size() == msg1.size(), SL);
+			utki::assert(std::equal(msg1.begin(), msg1.end(), m->begin()), SL);
+		}
+		consumer.pop();
+
+		// still not empty
+		utki::assert(ws.wait(0), SL);
+		{
+			auto m = consumer.front();
+			utki::assert(m, SL);
+			utki::assert(m->size() == msg2.size(), SL);
+			utki::assert(std::equal(msg2.begin(), msg2.end(), m->begin()), SL);
+		}
+		consumer.pop();
+
+		utki::assert(!ws.wait(0), SL);
+		utki::assert(!consumer.front(), SL);
+
+		// fill the channel
+		std::vector<uint8_t> big(producer.max_message_size(), 0xab);
+		unsigned num_sent = 0;
+		while(producer.send(utki::make_span(big))){
+			++num_sent;
+		}
+		utki::assert(num_sent != 0, SL);
+
+		ws.remove(consumer);
+	}
+
+	// messages from another process
+	{
+		opros::ipc_channel channel(1024);
+
+		constexpr uint32_t num_messages = 10000;
+
+		auto child = fork();
+		utki::assert(child >= 0, SL);
+		if(child == 0){
+			std::vector<uint8_t> buf;
+			for(uint32_t i = 0; i != num_messages; ++i){
+				buf.resize(sizeof(i) + i % 100);
+				memcpy(buf.data(), &i, sizeof(i));
+				while(!channel.send(utki::make_span(buf))){
+					std::this_thread::yield();
+				}
+			}
+			_exit(0);
+		}
+
+		opros::wait_set ws(1);
+		ws.add(channel, {opros::ready::read}, &channel);
+
+		uint32_t expected = 0;
+		while(expected != num_messages){
+			utki::assert(ws.wait(3000), SL);
+			while(auto m = channel.front()){
+				utki::assert(m->size() == sizeof(expected) + expected % 100, SL);
+				uint32_t i = 0;
+				memcpy(&i, m->data(), sizeof(i));
+				utki::assert(i == expected, [&](auto&o){o << "i = " << i << ", expected = " << expected;}, SL);
+				++expected;
+				channel.pop();
+			}
+		}
+
+		utki::assert(!ws.wait(0), SL);
+
+		ws.remove(channel);
+
+		int status = 0;
+		utki::assert(waitpid(child, &status, 0) == child, SL);
+		utki::assert(WIFEXITED(status) && WEXITSTATUS(status) == 0, SL);
+	}
+#endif
+}
+}
+
+namespace test_wait_batch{
+void run(){
+	opros::wait_set ws(4);
+
+	std::vector<helpers::queue> queues(4);
+	for(auto& q : queues){
+		ws.add(q, {opros::ready::read}, &q);
+	}
+
+	// nothing triggers
+	utki::assert(!ws.wait_batch(2, 1000, 100), SL);
+
+	// batch is collected until enough waitables trigger
+	{
+		queues[0].push_message([](){});
+
+		std::thread thr([&queues](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			queues[1].push_message([](){});
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			queues[2].push_message([](){});
+		});
+
+		ws.wait_batch(3, 3000000);
+
+		thr.join();
+
+		utki::assert(!ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 3, [&](auto&o){o << "size = " << ws.get_triggered().size();}, SL);
+		for(size_t i = 0; i != 3; ++i){
+			auto t = ws.get_triggered();
+			utki::assert(std::count_if(t.begin(), t.end(), [&](const auto& e){return e.user_data == &queues[i];}) == 1, SL);
+		}
+	}
+
+	// maximum delay is hit
+	{
+		auto start = std::chrono::steady_clock::now();
+		utki::assert(ws.wait_batch(4, 50000, 1000), SL);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		utki::assert(ws.get_triggered().size() == 3, SL);
+		utki::assert(elapsed >= std::chrono::milliseconds(50), SL);
+		utki::assert(elapsed < std::chrono::milliseconds(1000), SL);
+	}
+
+	// interrupt ends the batch collection
+	{
+		std::thread thr([&ws](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			ws.interrupt();
+		});
+
+		auto start = std::chrono::steady_clock::now();
+		ws.wait_batch(4, 3000000);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		thr.join();
+
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(elapsed < std::chrono::milliseconds(1000), SL);
+	}
+
+	for(auto& q : queues){
+		while(q.peek_msg()){}
+		ws.remove(q);
+	}
+}
+}
+
+namespace test_bounded_queue{
+void run(){
+	// readiness follows the watermarks
+	{
+		opros::bounded_queue<int> q(4, 2);
+
+		opros::wait_set ws(1);
+		ws.add(q, {opros::ready::read, opros::ready::write}, &q);
+
+		auto get_flags = [&](){
+			utki::assert(ws.wait(0), SL);
+			utki::assert(ws.get_triggered().size() == 1, SL);
+			return ws.get_triggered()[0].flags;
+		};
+
+		// empty queue is only writable
+		{
+			auto f = get_flags();
+			utki::assert(!f.get(opros::ready::read), SL);
+			utki::assert(f.get(opros::ready::write), SL);
+		}
+
+		for(int i = 0; i != 4; ++i){
+			utki::assert(q.try_push(int(i)), SL);
+			auto f = get_flags();
+			utki::assert(f.get(opros::ready::read), SL);
+			utki::assert(f.get(opros::ready::write) == (i != 3), SL);
+		}
+
+		// full
+		utki::assert(!q.try_push(4), SL);
+		utki::assert(q.size() == 4, SL);
+
+		// above low watermark the queue stays full
+		utki::assert(q.try_pop() == 0, SL);
+		utki::assert(!q.try_push(4), SL);
+		utki::assert(!get_flags().get(opros::ready::write), SL);
+
+		// dropped to low watermark, accepting again
+		utki::assert(q.try_pop() == 1, SL);
+		{
+			auto f = get_flags();
+			utki::assert(f.get(opros::ready::read), SL);
+			utki::assert(f.get(opros::ready::write), SL);
+		}
+		utki::assert(q.try_push(4), SL);
+
+		utki::assert(q.try_pop() == 2, SL);
+		utki::assert(q.try_pop() == 3, SL);
+		utki::assert(q.try_pop() == 4, SL);
+		utki::assert(!q.try_pop(), SL);
+
+		{
+			auto f = get_flags();
+			utki::assert(!f.get(opros::ready::read), SL);
+			utki::assert(f.get(opros::ready::write), SL);
+		}
+
+		ws.remove(q);
+	}
+
+	// producer waits for write readiness
+	{
+		opros::bounded_queue<uint32_t> q(16, 8);
+
+		constexpr uint32_t num_items = 100000;
+
+		std::thread producer([&](){
+			opros::wait_set ws(1);
+			ws.add(q, {opros::ready::write}, &q);
+			for(uint32_t i = 0; i != num_items;){
+				if(q.try_push(uint32_t(i))){
+					++i;
+					continue;
+				}
+				ws.wait();
+			}
+			ws.remove(q);
+		});
+
+		opros::wait_set ws(1);
+		ws.add(q, {opros::ready::read}, &q);
+
+		uint32_t expected = 0;
+		while(expected != num_items){
+			ws.wait();
+			while(auto i = q.try_pop()){
+				utki::assert(*i == expected, SL);
+				++expected;
+			}
+		}
+
+		producer.join();
+
+		// after the concurrent readiness changes the handle signals the final readiness
+		utki::assert(!ws.wait(0), SL);
+		ws.change(q, {opros::ready::write}, &q);
+		utki::assert(ws.wait(0), SL);
+
+		ws.remove(q);
+	}
+}
+}
+
+namespace test_concurrent_registration{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	// add and change while another thread is blocked in wait()
+	{
+		opros::wait_set ws(2, std::make_unique<opros::concurrent_epoll_backend>(2));
+
+		helpers::queue q1;
+		helpers::queue q2;
+		q1.push_message([](){});
+		q2.push_message([](){});
+
+		std::atomic<void*> triggered{nullptr};
+
+		std::thread waiter([&](){
+			for(unsigned i = 0; i != 2; ++i){
+				ws.wait();
+				utki::assert(!ws.was_interrupted(), SL);
+				utki::assert(ws.get_triggered().size() == 1, SL);
+				triggered.store(ws.get_triggered()[0].user_data);
+				while(triggered.load() != nullptr){
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		// let the waiter block
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		utki::assert(triggered.load() == nullptr, SL);
+
+		ws.add(q1, {opros::ready::read}, &q1);
+		while(triggered.load() == nullptr){
+			std::this_thread::yield();
+		}
+		utki::assert(triggered.load() == &q1, SL);
+
+		// stop waiting for q1 and add q2 with no wait flags before the waiter resumes
+		ws.change(q1, {}, &q1);
+		ws.add(q2, {}, &q2);
+		triggered.store(nullptr);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		utki::assert(triggered.load() == nullptr, SL);
+
+		ws.change(q2, {opros::ready::read}, &q2);
+		while(triggered.load() == nullptr){
+			std::this_thread::yield();
+		}
+		utki::assert(triggered.load() == &q2, SL);
+		triggered.store(nullptr);
+
+		waiter.join();
+
+		ws.remove(q1);
+		ws.remove(q2);
+		utki::assert(ws.size() == 0, SL);
+	}
+
+	// events of removed waitables are not reported by wait() started after the removal
+	{
+		opros::wait_set ws(1, std::make_unique<opros::concurrent_epoll_backend>(1));
+
+		helpers::queue q;
+		q.push_message([](){});
+
+		constexpr unsigned num_iterations = 1000;
+
+		// each registration has its own user data
+		std::vector<unsigned> ids(num_iterations);
+
+		std::atomic<bool> quit{false};
+
+		// number of registrations removed so far
+		std::atomic<unsigned> num_removed{0};
+
+		std::thread waiter([&](){
+			while(!quit.load()){
+				unsigned removed_before_wait = num_removed.load();
+				ws.wait();
+				for(const auto& e : ws.get_triggered()){
+					auto id = unsigned(static_cast<unsigned*>(e.user_data) - ids.data());
+					utki::assert(id >= removed_before_wait, [&](auto& o){o << "id = " << id << ", removed = " << removed_before_wait;}, SL);
+				}
+			}
+		});
+
+		for(unsigned i = 0; i != num_iterations; ++i){
+			ws.add(q, {opros::ready::read}, &ids[i]);
+			std::this_thread::yield();
+			ws.remove(q);
+			++num_removed;
+		}
+
+		quit.store(true);
+		ws.interrupt();
+		waiter.join();
+	}
+
+	// in one-shot mode the waitable is not reported again until re-armed with change()
+	{
+		opros::wait_set ws(1, std::make_unique<opros::concurrent_epoll_backend>(1, true));
+
+		helpers::queue q;
+		q.push_message([](){});
+
+		ws.add(q, {opros::ready::read}, &q);
+
+		utki::assert(ws.wait(0), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &q, SL);
+
+		// the queue is still readable, but the registration is disabled
+		utki::assert(!ws.wait(0), SL);
+
+		// re-arm from another thread while waiting
+		std::thread rearmer([&](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			ws.change(q, {opros::ready::read}, &q);
+		});
+
+		utki::assert(ws.wait(1000), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &q, SL);
+
+		rearmer.join();
+
+		utki::assert(!ws.wait(0), SL);
+
+		ws.remove(q);
+	}
+#endif
+}
+}
+
+namespace test_sockets{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	// udp batch
+	{
+		opros::udp_socket receiver(opros::endpoint("127.0.0.1", 0));
+		opros::udp_socket sender(opros::endpoint("127.0.0.1", 0));
+
+		auto receiver_address = receiver.get_local_endpoint();
+		utki::assert(receiver_address.get_port() != 0, SL);
+		utki::assert(receiver_address.get_ip() == "127.0.0.1", SL);
+
+		opros::wait_set ws(1);
+		ws.add(receiver, {opros::ready::read}, &receiver);
+
+		utki::assert(!ws.wait(0), SL);
+
+		constexpr size_t num_datagrams = 8;
+
+		std::vector<std::vector<uint8_t>> out_data(num_datagrams);
+		std::vector<opros::udp_socket::datagram> out(num_datagrams);
+		for(size_t i = 0; i != num_datagrams; ++i){
+			out_data[i].assign(i + 1, uint8_t(i));
+			out[i].buffer = utki::make_span(out_data[i]);
+			out[i].size = out_data[i].size();
+			out[i].peer = receiver_address;
+		}
+
+		utki::assert(sender.send(utki::make_span(out)) == num_datagrams, SL);
+
+		utki::assert(ws.wait(1000), SL);
+
+		// buffers for one more datagram than sent, the last one is too small
+		std::vector<std::array<uint8_t, 16>> in_data(num_datagrams + 1);
+		std::vector<opros::udp_socket::datagram> in(num_datagrams + 1);
+		for(size_t i = 0; i != in.size(); ++i){
+			in[i].buffer = utki::make_span(in_data[i]);
+		}
+
+		size_t num_received = 0;
+		while(num_received != num_datagrams){
+			auto span = utki::make_span(in).subspan(num_received);
+			num_received += receiver.receive(span);
+		}
+
+		for(size_t i = 0; i != num_datagrams; ++i){
+			utki::assert(in[i].size == i + 1, SL);
+			utki::assert(!in[i].truncated, SL);
+			utki::assert(in[i].peer == sender.get_local_endpoint(), SL);
+			utki::assert(std::all_of(in_data[i].begin(), in_data[i].begin() + i + 1, [&](auto b){return b == uint8_t(i);}), SL);
+		}
+
+		utki::assert(receiver.receive(utki::make_span(in)) == 0, SL);
+		utki::assert(!ws.wait(0), SL);
+
+		ws.remove(receiver);
+	}
+
+	// tcp
+	{
+		opros::tcp_acceptor acceptor(opros::endpoint("127.0.0.1", 0));
+
+		opros::wait_set ws(3);
+		ws.add(acceptor, {opros::ready::read}, &acceptor);
+
+		opros::tcp_socket client(acceptor.get_local_endpoint());
+		ws.add(client, {opros::ready::write}, &client);
+
+		std::unique_ptr<opros::tcp_socket> server;
+		bool connected = false;
+		while(!server || !connected){
+			ws.wait();
+			for(const auto& e : ws.get_triggered()){
+				if(e.user_data == &acceptor){
+					server = acceptor.accept();
+					utki::assert(server, SL);
+					utki::assert(server->get_remote_endpoint().get_ip() == "127.0.0.1", SL);
+					ws.remove(acceptor);
+				}else if(e.user_data == &client){
+					utki::assert(client.get_error() == 0, SL);
+					connected = true;
+					ws.remove(client);
+				}
+			}
+		}
+
+		utki::assert(!acceptor.accept(), SL);
+
+		client.set_nodelay(true);
+
+		const std::array<uint8_t, 3> part1 = {1, 2, 3};
+		const std::array<uint8_t, 4> part2 = {4, 5, 6, 7};
+		const std::array<utki::span<const uint8_t>, 2> parts = {utki::make_span(part1), utki::make_span(part2)};
+		utki::assert(client.send(utki::make_span(parts)) == part1.size() + part2.size(), SL);
+
+		ws.add(*server, {opros::ready::read}, server.get());
+
+		std::array<uint8_t, 2> in1{};
+		std::array<uint8_t, 8> in2{};
+		const std::array<utki::span<uint8_t>, 2> in_parts = {utki::make_span(in1), utki::make_span(in2)};
+
+		// small data sent in one go arrives in one go over loopback
+		ws.wait();
+		auto num_received = server->receive(utki::make_span(in_parts));
+		utki::assert(num_received == size_t(7), SL);
+		utki::assert(in1[0] == 1 && in1[1] == 2, SL);
+		utki::assert(in2[0] == 3 && in2[4] == 7, SL);
+
+		utki::assert(!server->receive(utki::make_span(in_parts)), SL);
+
+		// out-of-band data wakes up only the waiters for priority data
+		{
+			ws.remove(*server);
+
+			opros::wait_set epoll_ws(1, std::make_unique<opros::epoll_backend>(1));
+
+			const uint8_t oob = 8;
+			utki::assert(send(client.get_handle(), &oob, 1, MSG_OOB) == 1, SL);
+
+			for(auto* s : {&ws, &epoll_ws}){
+				s->add(*server, {opros::ready::read}, server.get());
+				utki::assert(!s->wait(100), SL);
+
+				s->change(*server, {opros::ready::read, opros::ready::priority}, server.get());
+				utki::assert(s->wait(100), SL);
+				utki::assert(s->get_triggered().size() == 1, SL);
+				utki::assert(s->get_triggered()[0].flags.get(opros::ready::priority), SL);
+				utki::assert(!s->get_triggered()[0].flags.get(opros::ready::read), SL);
+
+				s->remove(*server);
+			}
+
+			uint8_t buf = 0;
+			utki::assert(recv(server->get_handle(), &buf, 1, MSG_OOB) == 1, SL);
+			utki::assert(buf == oob, SL);
+
+			ws.add(*server, {opros::ready::read}, server.get());
+		}
+
+		// peer closes the connection
+		shutdown(client.get_handle(), SHUT_WR);
+		ws.wait();
+		utki::assert(server->receive(utki::make_span(in_parts)) == size_t(0), SL);
+
+		ws.remove(*server);
+	}
+#endif
+}
+}
+
+namespace test_pipe{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	// vmsplice and tee
+	{
+		opros::pipe a;
+		opros::pipe b;
+
+		opros::wait_set ws(1);
+		ws.add(a.get_read_end(), {opros::ready::read}, &a);
+		utki::assert(!ws.wait(0), SL);
+
+		const std::array<uint8_t, 5> data = {1, 2, 3, 4, 5};
+		const std::array<utki::span<const uint8_t>, 1> buffers = {utki::make_span(data)};
+		utki::assert(a.get_write_end().vmsplice(utki::make_span(buffers)) == data.size(), SL);
+
+		utki::assert(ws.wait(0), SL);
+
+		// duplicate to pipe b, the data stays in pipe a
+		utki::assert(a.get_read_end().tee_to(b.get_write_end(), 100) == data.size(), SL);
+		utki::assert(ws.wait(0), SL);
+
+		for(auto* p : {&a, &b}){
+			std::array<uint8_t, 10> buf{};
+			utki::assert(read(p->get_read_end().get_handle(), buf.data(), buf.size()) == ssize_t(data.size()), SL);
+			utki::assert(std::equal(data.begin(), data.end(), buf.begin()), SL);
+		}
+
+		utki::assert(!ws.wait(0), SL);
+		utki::assert(!a.get_read_end().tee_to(b.get_write_end(), 100), SL);
+
+		ws.remove(a.get_read_end());
+	}
+
+	// pump data from one pipe to another through a slow consumer
+	{
+		opros::pipe source;
+		opros::pipe destination;
+
+		utki::assert(source.get_capacity() != 0, SL);
+
+		opros::splice_pump pump(source.get_read_end(), destination.get_write_end());
+
+		constexpr size_t data_size = 1024 * 1024;
+
+		std::thread producer([&](){
+			std::vector<uint8_t> buf(4096);
+			size_t num_written = 0;
+			opros::wait_set ws(1);
+			ws.add(source.get_write_end(), {opros::ready::write}, nullptr);
+			while(num_written != data_size){
+				for(size_t i = 0; i != buf.size(); ++i){
+					buf[i] = uint8_t(num_written + i);
+				}
+				auto res = write(source.get_write_end().get_handle(), buf.data(), std::min(buf.size(), data_size - num_written));
+				if(res < 0){
+					utki::assert(errno == EAGAIN, SL);
+					ws.wait();
+					continue;
+				}
+				num_written += size_t(res);
+			}
+			ws.remove(source.get_write_end());
+		});
+
+		std::atomic<bool> all_consumed{false};
+
+		std::thread consumer([&](){
+			std::vector<uint8_t> buf(1000);
+			size_t num_read = 0;
+			opros::wait_set ws(1);
+			ws.add(destination.get_read_end(), {opros::ready::read}, nullptr);
+			while(num_read != data_size){
+				ws.wait();
+				auto res = read(destination.get_read_end().get_handle(), buf.data(), buf.size());
+				if(res <= 0){
+					continue;
+				}
+				for(size_t i = 0; i != size_t(res); ++i){
+					utki::assert(buf[i] == uint8_t(num_read + i), SL);
+				}
+				num_read += size_t(res);
+			}
+			ws.remove(destination.get_read_end());
+			all_consumed.store(true);
+		});
+
+		opros::wait_set ws(2);
+		ws.add(source.get_read_end(), {opros::ready::read}, &source);
+		ws.add(destination.get_write_end(), {opros::ready::write}, &destination);
+
+		// the source write end is not closed, so the pump never finishes, poll for the consumer to get all the data
+		while(!all_consumed.load()){
+			ws.wait(10);
+			auto state = pump.pump();
+			utki::assert(!state.finished, SL);
+			utki::assert(state.wait_source != state.wait_destination, SL);
+
+			utki::flags<opros::ready> source_flags = false;
+			source_flags.set(opros::ready::read, state.wait_source);
+			ws.change(source.get_read_end(), source_flags, &source);
+
+			utki::flags<opros::ready> destination_flags = false;
+			destination_flags.set(opros::ready::write, state.wait_destination);
+			ws.change(destination.get_write_end(), destination_flags, &destination);
+		}
+		utki::assert(pump.get_num_buffered() == 0, SL);
+
+		ws.remove(source.get_read_end());
+		ws.remove(destination.get_write_end());
+
+		producer.join();
+		consumer.join();
+	}
+#endif
+}
+}
+
+namespace test_clear{
+void run(){
+	// big and small wait sets
+	for(unsigned num_queues : {2, 5}){
+		std::vector<std::unique_ptr<helpers::queue>> queues;
+		for(unsigned i = 0; i != num_queues; ++i){
+			queues.push_back(std::make_unique<helpers::queue>());
+			queues.back()->push_message([](){});
+		}
+
+		opros::wait_set ws(8);
+
+		for(unsigned repeat = 0; repeat != 2; ++repeat){
+			for(auto& q : queues){
+				ws.add(*q, {opros::ready::read}, q.get());
+			}
+			utki::assert(ws.size() == num_queues, SL);
+			utki::assert(ws.wait(0), SL);
+			utki::assert(ws.get_triggered().size() == num_queues, SL);
+
+			ws.interrupt();
+			ws.clear();
+			utki::assert(ws.size() == 0, SL);
+			utki::assert(ws.get_triggered().empty(), SL);
+
+			// pending interrupt is kept
+			utki::assert(ws.wait(0), SL);
+			utki::assert(ws.was_interrupted(), SL);
+			utki::assert(ws.get_triggered().empty(), SL);
+			utki::assert(!ws.wait(0), SL);
+		}
+	}
+
+	// simulation backend
+	{
+		opros::simulated_waitable w;
+		auto backend = std::make_unique<opros::simulation_backend>();
+		auto& sim = *backend;
+		opros::wait_set ws(1, std::move(backend));
+		ws.add(w, {opros::ready::read}, &w);
+		sim.set_readiness(w, {opros::ready::read});
+		ws.clear();
+		utki::assert(!ws.wait(0), SL);
+		ws.add(w, {opros::ready::read}, &w);
+		ws.remove(w);
+	}
+
+	// destroy with contents
+	{
+		helpers::queue q;
+		q.push_message([](){});
+
+		opros::wait_set_pool pool;
+
+		for(unsigned i = 0; i != 2; ++i){
+			opros::wait_set ws(8, pool);
+			ws.add(q, {opros::ready::read}, &q);
+			utki::assert(ws.wait(0), SL);
+			ws.set_destroy_with_contents(true);
+		}
+
+		// the backend was cleared and recycled
+		utki::assert(pool.size() == 1, SL);
+
+		opros::wait_set ws(8, pool);
+		utki::assert(!ws.wait(0), SL);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	// clear while another thread is waiting
+	{
+		opros::wait_set ws(2, std::make_unique<opros::concurrent_epoll_backend>(2));
+
+		helpers::queue q1;
+		helpers::queue q2;
+		q2.push_message([](){});
+		ws.add(q1, {opros::ready::read}, &q1);
+
+		std::atomic<void*> triggered{nullptr};
+
+		std::thread waiter([&](){
+			ws.wait();
+			utki::assert(!ws.was_interrupted(), SL);
+			utki::assert(ws.get_triggered().size() == 1, SL);
+			triggered.store(ws.get_triggered()[0].user_data);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		ws.clear();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		utki::assert(triggered.load() == nullptr, SL);
+
+		ws.add(q2, {opros::ready::read}, &q2);
+
+		waiter.join();
+		utki::assert(triggered.load() == &q2, SL);
+
+		ws.remove(q2);
+	}
+#endif
+}
+}
+
+namespace test_dispatcher_rate_limit{
+void run(){
+	// fair dispatch with one handler call per iteration
+	{
+		opros::dispatcher d(4, 1);
+
+		helpers::queue q1;
+		helpers::queue q2;
+		for(unsigned i = 0; i != 100; ++i){
+			q1.push_message([](){});
+			q2.push_message([](){});
+		}
+
+		std::vector<helpers::queue*> order;
+
+		d.add(q1, {opros::ready::read}, [&](utki::flags<opros::ready> f){
+			utki::assert(f.get(opros::ready::read), SL);
+			q1.peek_msg();
+			order.push_back(&q1);
+		});
+		d.add(q2, {opros::ready::read}, [&](utki::flags<opros::ready> f){
+			utki::assert(f.get(opros::ready::read), SL);
+			q2.peek_msg();
+			order.push_back(&q2);
+		});
+
+		for(unsigned i = 0; i != 10; ++i){
+			utki::assert(d.run_once(0) == 1, SL);
+		}
+
+		utki::assert(order.size() == 10, SL);
+		for(size_t i = 1; i != order.size(); ++i){
+			utki::assert(order[i] != order[i - 1], SL);
+		}
+
+		d.remove(q1);
+		d.remove(q2);
+	}
+
+	// rate limited flooding source
+	{
+		opros::dispatcher d(4);
+
+		helpers::queue q;
+		for(unsigned i = 0; i != 1000; ++i){
+			q.push_message([](){});
+		}
+
+		unsigned num_calls = 0;
+
+		d.add(
+			q,
+			{opros::ready::read},
+			[&](utki::flags<opros::ready>){
+				q.peek_msg();
+				++num_calls;
+			},
+			{10, 2}
+		);
+
+		// the burst is served at once, then the source is muted
+		d.run_once(0);
+		d.run_once(0);
+		utki::assert(num_calls == 2, SL);
+		utki::assert(d.is_muted(q), SL);
+
+		d.run_once(0);
+		utki::assert(num_calls == 2, SL);
+
+		auto start = std::chrono::steady_clock::now();
+		while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500)){
+			d.run_once(1000);
+		}
+
+		utki::assert(num_calls >= 2 + 3 && num_calls <= 2 + 7, [&](auto&o){o << "num_calls = " << num_calls;}, SL);
+
+		d.remove(q);
+	}
+
+	// removing waitable from its own handler
+	{
+		opros::dispatcher d(4);
+
+		helpers::queue q;
+		q.push_message([](){});
+
+		unsigned num_calls = 0;
+
+		d.add(q, {opros::ready::read}, [&](utki::flags<opros::ready>){
+			++num_calls;
+			d.remove(q);
+		});
+
+		d.run_once(0);
+		d.run_once(0);
+		utki::assert(num_calls == 1, SL);
+	}
+}
+}
+
+namespace test_dispatcher_edf{
+void run(){
+	opros::dispatcher d(4);
+
+	helpers::queue q1;
+	helpers::queue q2;
+	helpers::queue q3;
+	q1.push_message([](){});
+	q2.push_message([](){});
+	q3.push_message([](){});
+
+	std::vector<std::string> order;
+
+	d.add(q1, {opros::ready::read}, [&](utki::flags<opros::ready>){
+		q1.peek_msg();
+		order.push_back("q1");
+	});
+	d.add(q2, {opros::ready::read}, [&](utki::flags<opros::ready>){
+		q2.peek_msg();
+		order.push_back("q2");
+	});
+	d.add(q3, {opros::ready::read}, [&](utki::flags<opros::ready>){
+		q3.peek_msg();
+		order.push_back("q3");
+	});
+
+	d.set_deadline(q1, std::chrono::seconds(30));
+	d.set_deadline(q2, std::chrono::seconds(10));
+
+	auto now = opros::dispatcher::clock::now();
+
+	d.post([&](){order.push_back("no deadline");});
+	d.post([&](){order.push_back("20s");}, now + std::chrono::seconds(20));
+
+	utki::assert(d.run_once(0) == 5, SL);
+
+	std::vector<std::string> expected = {"q2", "20s", "q1", "no deadline", "q3"};
+	utki::assert(order == expected, SL);
+	utki::assert(d.get_num_missed_deadlines() == 0, SL);
+
+	d.post([](){}, now - std::chrono::seconds(1));
+	utki::assert(d.get_num_queued() == 1, SL);
+	utki::assert(d.run_once(0) == 1, SL);
+	utki::assert(d.get_num_missed_deadlines() == 1, SL);
+
+	d.remove(q1);
+	d.remove(q2);
+	d.remove(q3);
+}
+}
+
+namespace test_futex{
+void run(){
+#if CFG_OS == CFG_OS_LINUX
+	opros::wait_set ws(2, std::make_unique<opros::futex_backend>());
+
+	opros::futex_event e1;
+	opros::futex_event e2;
+
+	ws.add(e1, {opros::ready::read}, &e1);
+	ws.add(e2, {opros::ready::read}, &e2);
+
+	// only futex events can be added
+	{
+		helpers::queue q;
+		bool thrown = false;
+		try{
+			ws.add(q, {opros::ready::read}, &q);
+		}catch(std::invalid_argument&){
+			thrown = true;
+		}
+		utki::assert(thrown, SL);
+	}
+
+	// timeout
+	{
+		auto start = std::chrono::steady_clock::now();
+		utki::assert(!ws.wait(20), SL);
+		utki::assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20), SL);
+	}
+
+	// signalled from another thread while waiting
+	{
+		std::thread signaller([&](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			e2.signal();
+		});
+
+		ws.wait();
+		signaller.join();
+
+		utki::assert(!ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &e2, SL);
+		utki::assert(ws.get_triggered()[0].flags.get(opros::ready::read), SL);
+	}
+
+	// event stays ready until reset
+	{
+		utki::assert(ws.wait(0), SL);
+		e1.signal();
+		utki::assert(ws.wait(0), SL);
+		utki::assert(ws.get_triggered().size() == 2, SL);
+
+		e1.reset();
+		e2.reset();
+		utki::assert(!ws.wait(0), SL);
+	}
+
+	// interrupt
+	{
+		std::thread interrupter([&](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			ws.interrupt();
+		});
+
+		ws.wait();
+		interrupter.join();
+
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 0, SL);
+	}
+
+	// ping-pong between two threads
+	{
+		opros::wait_set ws2(1, std::make_unique<opros::futex_backend>());
+
+		ws.remove(e2);
+		ws2.add(e2, {opros::ready::read}, &e2);
+
+		constexpr unsigned num_round_trips = 10000;
+
+		std::thread peer([&](){
+			for(unsigned i = 0; i != num_round_trips; ++i){
+				ws2.wait();
+				e2.reset();
+				e1.signal();
+			}
+		});
+
+		for(unsigned i = 0; i != num_round_trips; ++i){
+			e2.signal();
+			ws.wait();
+			utki::assert(ws.get_triggered().size() == 1, SL);
+			e1.reset();
+		}
+
+		peer.join();
+
+		ws2.remove(e2);
+	}
+
+	ws.remove(e1);
+#endif
+}
+}
+
+namespace test_post{
+namespace{
+void check(opros::wait_set& ws){
+	helpers::queue q;
+	ws.add(q, {opros::ready::read}, &q);
+
+	int a = 0;
+	int b = 0;
+
+	// posted events are reported right away, in the order of posting
+	{
+		ws.post(&a, {opros::ready::read});
+		ws.post(&b, {opros::ready::write});
+
+		utki::assert(ws.wait(0), SL);
+		utki::assert(!ws.was_interrupted(), SL);
+
+		auto triggered = ws.get_triggered();
+		utki::assert(triggered.size() == 2, SL);
+		utki::assert(triggered[0].user_data == &a, SL);
+		utki::assert(triggered[0].flags.get(opros::ready::read), SL);
+		utki::assert(triggered[1].user_data == &b, SL);
+		utki::assert(triggered[1].flags.get(opros::ready::write), SL);
+
+		// the internal wakeup left from the posts is not reported
+		utki::assert(!ws.wait(0), SL);
+		utki::assert(!ws.was_interrupted(), SL);
+	}
+
+	// post wakes up blocked wait
+	{
+		std::thread poster([&](){
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			ws.post(&a, {opros::ready::read});
+		});
+
+		ws.wait();
+		poster.join();
+
+		utki::assert(!ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &a, SL);
+
+		utki::assert(!ws.wait(0), SL);
+	}
+
+	// interrupt is not lost among posts
+	{
+		ws.interrupt();
+		ws.post(&a, {opros::ready::read});
+
+		ws.wait();
+		utki::assert(!ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+
+		ws.wait();
+		utki::assert(ws.was_interrupted(), SL);
+		utki::assert(ws.get_triggered().size() == 0, SL);
+	}
+
+	// posted events are reported before the events of waitables
+	{
+		q.push_message([](){});
+		ws.post(&b, {opros::ready::read});
+
+		ws.wait();
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &b, SL);
+
+		ws.wait();
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &q, SL);
+
+		q.peek_msg();
+	}
+
+	// posted events are not batched with events of waitables
+	{
+		ws.post(&a, {opros::ready::read});
+
+		utki::assert(ws.wait_batch(2, 1000, 0), SL);
+		utki::assert(ws.get_triggered().size() == 1, SL);
+		utki::assert(ws.get_triggered()[0].user_data == &a, SL);
+	}
+
+	// many posts from another thread
+	{
+		constexpr unsigned num_posts = 10000;
+
+		std::thread poster([&](){
+			for(unsigned i = 0; i != num_posts; ++i){
+				ws.post(&a, {opros::ready::read});
+			}
+		});
+
+		unsigned num_received = 0;
+		while(num_received != num_posts){
+			ws.wait();
+			utki::assert(!ws.was_interrupted(), SL);
+			num_received += unsigned(ws.get_triggered().size());
+		}
+
+		poster.join();
+
+		utki::assert(!ws.wait(0), SL);
+	}
+
+	ws.remove(q);
+}
+}
+
+void run(){
+	{
+		opros::wait_set ws(2);
+		check(ws);
+	}
+
+#if CFG_OS == CFG_OS_LINUX
+	// small wait sets use poll_backend by default, check epoll_backend explicitly
+	{
+		opros::wait_set ws(2, std::make_unique<opros::epoll_backend>(2));
+		check(ws);
+	}
+#endif
+}
+}
+
+namespace test_execution{
+#if __has_include(<stdexec/execution.hpp>) && __cplusplus >= 202002L
+namespace{
+enum class completion{
+	none,
+	value,
+	error,
+	stopped
+};
+
+struct receiver{
+	using receiver_concept = stdexec::receiver_t;
+
+	std::atomic<completion>* result;
+	utki::flags<opros::ready>* flags;
+	stdexec::inplace_stop_token token;
+
+	struct env{
+		stdexec::inplace_stop_token token;
+
+		stdexec::inplace_stop_token query(stdexec::get_stop_token_t)const noexcept{
+			return this->token;
+		}
+	};
+
+	env get_env()const noexcept{
+		return {this->token};
+	}
+
+	void set_value()&& noexcept{
+		this->result->store(completion::value);
+	}
+
+	void set_value(utki::flags<opros::ready> f)&& noexcept{
+		*this->flags = f;
+		this->result->store(completion::value);
+	}
+
+	void set_error(std::exception_ptr)&& noexcept{
+		this->result->store(completion::error);
+	}
+
+	void set_stopped()&& noexcept{
+		this->result->store(completion::stopped);
+	}
+};
+
+completion wait_completion(const std::atomic<completion>& result){
+	auto start = std::chrono::steady_clock::now();
+	while(result.load() == completion::none){
+		utki::assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5), SL);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return result.load();
+}
+}
+#endif
+
+void run(){
+#if __has_include(<stdexec/execution.hpp>) && __cplusplus >= 202002L
+	opros::execution_context context(4);
+	auto scheduler = context.get_scheduler();
+
+	std::thread loop([&](){
+		context.run();
+	});
+
+	// schedule
+	{
+		std::atomic<completion> result{completion::none};
+		utki::flags<opros::ready> flags;
+		stdexec::inplace_stop_source stop_source;
+
+		auto op = stdexec::connect(scheduler.schedule(), receiver{&result, &flags, stop_source.get_token()});
+		stdexec::start(op);
+
+		utki::assert(wait_completion(result) == completion::value, SL);
+	}
+
+	// wait for waitable
+	{
+		helpers::queue q;
+
+		std::atomic<completion> result{completion::none};
+		utki::flags<opros::ready> flags;
+		stdexec::inplace_stop_source stop_source;
+
+		auto op = stdexec::connect(
+			scheduler.async_wait(q, {opros::ready::read}),
+			receiver{&result, &flags, stop_source.get_token()}
+		);
+		stdexec::start(op);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		utki::assert(result.load() == completion::none, SL);
+
+		q.push_message([](){});
+
+		utki::assert(wait_completion(result) == completion::value, SL);
+		utki::assert(flags.get(opros::ready::read), SL);
+	}
+
+	// stop started wait, the waitable never becomes ready
+	{
+		helpers::queue q;
+
+		std::atomic<completion> result{completion::none};
+		utki::flags<opros::ready> flags;
+		stdexec::inplace_stop_source stop_source;
+
+		auto op = stdexec::connect(
+			scheduler.async_wait(q, {opros::ready::read}),
+			receiver{&result, &flags, stop_source.get_token()}
+		);
+		stdexec::start(op);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		utki::assert(result.load() == completion::none, SL);
+
+		stop_source.request_stop();
+
+		utki::assert(wait_completion(result) == completion::stopped, SL);
+	}
+
+	// stop requested before start
+	{
+		helpers::queue q;
+
+		std::atomic<completion> result{completion::none};
+		utki::flags<opros::ready> flags;
+		stdexec::inplace_stop_source stop_source;
+		stop_source.request_stop();
+
+		auto op = stdexec::connect(
+			scheduler.async_wait(q, {opros::ready::read}),
+			receiver{&result, &flags, stop_source.get_token()}
+		);
+		stdexec::start(op);
+
+		utki::assert(result.load() == completion::stopped, SL);
+	}
+
+	context.finish();
+	loop.join();
+#endif
+}
+}
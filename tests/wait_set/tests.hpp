@@ -11,3 +11,95 @@ void run();
 namespace test_threads{
 void run();
 }
+
+namespace test_interrupt{
+void run();
+}
+
+namespace test_change{
+void run();
+}
+
+namespace test_trace{
+void run();
+}
+
+namespace test_simulation{
+void run();
+}
+
+namespace test_poll_promotion{
+void run();
+}
+
+namespace test_pool{
+void run();
+}
+
+namespace test_executor{
+void run();
+}
+
+namespace test_hangup{
+void run();
+}
+
+namespace test_process{
+void run();
+}
+
+namespace test_file_watch{
+void run();
+}
+
+namespace test_uring{
+void run();
+}
+
+namespace test_ipc_channel{
+void run();
+}
+
+namespace test_wait_batch{
+void run();
+}
+
+namespace test_bounded_queue{
+void run();
+}
+
+namespace test_concurrent_registration{
+void run();
+}
+
+namespace test_sockets{
+void run();
+}
+
+namespace test_pipe{
+void run();
+}
+
+namespace test_clear{
+void run();
+}
+
+namespace test_dispatcher_rate_limit{
+void run();
+}
+
+namespace test_dispatcher_edf{
+void run();
+}
+
+namespace test_futex{
+void run();
+}
+
+namespace test_post{
+void run();
+}
+
+namespace test_execution{
+void run();
+}